@@ -8,9 +8,158 @@
 
 #include <argon2.h>
 
+#include <boost/circular_buffer.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/program_options.hpp>
 
+namespace
+{
+/** Mutex and condition variable udp_buffer, kept as the baseline for debug_profile_udp_buffer */
+class locked_udp_buffer
+{
+public:
+	locked_udp_buffer(cga::stat & stats_a, size_t size_a, size_t count_a) :
+	stats(stats_a),
+	free(count_a),
+	full(count_a),
+	slab(size_a * count_a),
+	entries(count_a),
+	stopped(false)
+	{
+		for (size_t i(0); i < count_a; ++i)
+		{
+			entries[i] = { slab.data() + i * size_a, 0, cga::endpoint(), std::chrono::steady_clock::time_point() };
+			free.push_back(&entries[i]);
+		}
+	}
+	cga::udp_data * allocate()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!stopped && free.empty() && full.empty())
+		{
+			stats.inc(cga::stat::type::udp, cga::stat::detail::blocking, cga::stat::dir::in);
+			condition.wait(lock);
+		}
+		cga::udp_data * result(nullptr);
+		if (!free.empty())
+		{
+			result = free.front();
+			free.pop_front();
+		}
+		else if (!full.empty())
+		{
+			result = full.front();
+			full.pop_front();
+			stats.inc(cga::stat::type::udp, cga::stat::detail::overflow, cga::stat::dir::in);
+		}
+		return result;
+	}
+	void enqueue(cga::udp_data * data_a)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			full.push_back(data_a);
+		}
+		condition.notify_all();
+	}
+	cga::udp_data * dequeue()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!stopped && full.empty())
+		{
+			condition.wait(lock);
+		}
+		cga::udp_data * result(nullptr);
+		if (!full.empty())
+		{
+			result = full.front();
+			full.pop_front();
+		}
+		return result;
+	}
+	void release(cga::udp_data * data_a)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			free.push_back(data_a);
+		}
+		condition.notify_all();
+	}
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopped = true;
+		}
+		condition.notify_all();
+	}
+
+private:
+	cga::stat & stats;
+	std::mutex mutex;
+	std::condition_variable condition;
+	boost::circular_buffer<cga::udp_data *> free;
+	boost::circular_buffer<cga::udp_data *> full;
+	std::vector<uint8_t> slab;
+	std::vector<cga::udp_data> entries;
+	bool stopped;
+};
+
+/** Push packets through a udp buffer from producer threads to consumer threads, returns elapsed microseconds */
+template <typename BUFFER>
+uint64_t profile_udp_buffer(BUFFER & buffer_a, size_t producers_a, size_t consumers_a, size_t packets_a)
+{
+	std::atomic<size_t> serviced(0);
+	std::vector<std::thread> threads;
+	auto begin(std::chrono::high_resolution_clock::now());
+	for (size_t i(0); i < consumers_a; ++i)
+	{
+		threads.emplace_back([&buffer_a, &serviced]() {
+			for (auto data(buffer_a.dequeue()); data != nullptr; data = buffer_a.dequeue())
+			{
+				serviced += data->size;
+				buffer_a.release(data);
+			}
+		});
+	}
+	std::vector<std::thread> producer_threads;
+	for (size_t i(0); i < producers_a; ++i)
+	{
+		producer_threads.emplace_back([&buffer_a, packets_a, producers_a]() {
+			for (size_t j(0); j < packets_a / producers_a; ++j)
+			{
+				auto data(buffer_a.allocate());
+				data->size = 1;
+				buffer_a.enqueue(data);
+			}
+		});
+	}
+	for (auto & thread : producer_threads)
+	{
+		thread.join();
+	}
+	// Packets overwritten by drop-oldest are never serviced, stop once the queue has drained
+	auto target(packets_a / producers_a * producers_a);
+	auto last(serviced.load());
+	while (serviced.load() < target)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		if (serviced.load() == last)
+		{
+			break;
+		}
+		last = serviced.load();
+	}
+	buffer_a.stop();
+	for (auto & thread : threads)
+	{
+		thread.join();
+	}
+	auto end(std::chrono::high_resolution_clock::now());
+	return std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count();
+}
+}
+
 int main(int argc, char *const *argv)
 {
 	cga::set_umask();
@@ -46,6 +195,8 @@ int main(int argc, char *const *argv)
 		("debug_verify_profile_batch", "Profile batch signature verification")
 		("debug_profile_bootstrap", "Profile bootstrap style blocks processing (at least 10GB of free storage space required)")
 		("debug_profile_sign", "Profile signature generation")
+		("debug_profile_block_hash", "Profile cached against recomputed block hashes")
+		("debug_profile_udp_buffer", "Profile lock-free against mutex based UDP buffer throughput")
 		("debug_profile_process", "Profile active blocks processing (only for cga_test_network)")
 		("debug_profile_votes", "Profile votes processing (only for cga_test_network)")
 		("debug_rpc", "Read an RPC command from stdin and invoke it. Network operations will have no effect.")
@@ -239,6 +390,40 @@ int main(int argc, char *const *argv)
 		{
 			cga::work_pool work(std::numeric_limits<unsigned>::max(), nullptr);
 			cga::change_block block(0, 0, cga::keypair().prv, 0, 0);
+			std::cerr << "Profiling work kernels on a single thread\n";
+			auto root(block.root());
+			for (auto kernel : { cga::work_kernel::scalar, cga::work_kernel::avx2, cga::work_kernel::avx512 })
+			{
+				if (cga::work_kernel_supported(kernel))
+				{
+					auto lanes(cga::work_kernel_lanes(kernel));
+					std::array<uint64_t, cga::work_kernel_max_lanes> nonces;
+					std::array<uint64_t, cga::work_kernel_max_lanes> values;
+					uint64_t hashes(0);
+					uint64_t nonce(0);
+					auto begin1(std::chrono::high_resolution_clock::now());
+					auto end1(begin1);
+					while (end1 - begin1 < std::chrono::seconds(1))
+					{
+						for (auto i(0); i < 4096; ++i)
+						{
+							for (auto j(0); j < lanes; ++j)
+							{
+								nonces[j] = ++nonce;
+							}
+							cga::work_values(kernel, root, nonces.data(), values.data());
+						}
+						hashes += 4096 * lanes;
+						end1 = std::chrono::high_resolution_clock::now();
+					}
+					auto seconds(std::chrono::duration_cast<std::chrono::duration<double>>(end1 - begin1).count());
+					std::cerr << boost::str(boost::format("%1% kernel: %2% hashes/sec%3%\n") % cga::work_kernel_name(kernel) % static_cast<uint64_t>(hashes / seconds) % (kernel == work.kernel ? " (selected)" : ""));
+				}
+				else
+				{
+					std::cerr << boost::str(boost::format("%1% kernel: not supported\n") % cga::work_kernel_name(kernel));
+				}
+			}
 			std::cerr << "Starting generation profiling\n";
 			while (true)
 			{
@@ -410,6 +595,65 @@ int main(int argc, char *const *argv)
 				std::cerr << boost::str(boost::format("%|1$ 12d|\n") % std::chrono::duration_cast<std::chrono::microseconds>(end1 - begin1).count());
 			}
 		}
+		else if (vm.count("debug_profile_block_hash"))
+		{
+			cga::keypair key;
+			size_t num_blocks(100000);
+			size_t num_lookups(8); // Hash lookups per block, as done along the processing path
+			std::vector<std::shared_ptr<cga::state_block>> blocks;
+			blocks.reserve(num_blocks);
+			cga::block_hash latest(0);
+			for (auto i(0); i < num_blocks; ++i)
+			{
+				blocks.push_back(std::make_shared<cga::state_block>(key.pub, latest, key.pub, i, 0, key.prv, key.pub, 0));
+				latest = blocks.back()->hash();
+			}
+			std::cerr << boost::str(boost::format("Hashing %1% blocks %2% times each\n") % num_blocks % num_lookups);
+			uint64_t sum(0);
+			auto begin1(std::chrono::high_resolution_clock::now());
+			for (auto & block : blocks)
+			{
+				for (auto j(0); j < num_lookups; ++j)
+				{
+					block->hash_invalidate();
+					sum += block->hash().qwords[0];
+				}
+			}
+			auto end1(std::chrono::high_resolution_clock::now());
+			for (auto & block : blocks)
+			{
+				block->hash_invalidate();
+			}
+			auto begin2(std::chrono::high_resolution_clock::now());
+			for (auto & block : blocks)
+			{
+				for (auto j(0); j < num_lookups; ++j)
+				{
+					sum += block->hash().qwords[0];
+				}
+			}
+			auto end2(std::chrono::high_resolution_clock::now());
+			auto recomputed(std::chrono::duration_cast<std::chrono::microseconds>(end1 - begin1).count());
+			auto cached(std::chrono::duration_cast<std::chrono::microseconds>(end2 - begin2).count());
+			std::cout << boost::str(boost::format("Recomputed: %1% us\nCached: %2% us\nSpeedup: %3%x (checksum %4%)") % recomputed % cached % (cached > 0 ? recomputed / cached : recomputed) % (sum & 0xff)) << std::endl;
+		}
+		else if (vm.count("debug_profile_udp_buffer"))
+		{
+			size_t num_packets(4000000);
+			size_t num_producers(1);
+			size_t num_consumers(std::max(2u, std::thread::hardware_concurrency()));
+			std::cerr << boost::str(boost::format("Passing %1% packets from %2% producers to %3% consumers\n") % num_packets % num_producers % num_consumers);
+			auto run([&](std::string const & name_a, auto make_buffer_a) {
+				cga::stat stats(cga::stat_config{});
+				auto buffer(make_buffer_a(stats));
+				auto elapsed(profile_udp_buffer(*buffer, num_producers, num_consumers, num_packets));
+				auto overflow(stats.count(cga::stat::type::udp, cga::stat::detail::overflow, cga::stat::dir::in));
+				auto blocking(stats.count(cga::stat::type::udp, cga::stat::detail::blocking, cga::stat::dir::in));
+				std::cout << boost::str(boost::format("%1%: %2% us, %3% packets/s, overflow %4%, blocking %5%") % name_a % elapsed % (num_packets * 1000000 / std::max<uint64_t>(elapsed, 1)) % overflow % blocking) << std::endl;
+			});
+			run("mutex", [](cga::stat & stats_a) { return std::make_unique<locked_udp_buffer>(stats_a, cga::network::buffer_size, 4096); });
+			run("lock-free", [](cga::stat & stats_a) { return std::make_unique<cga::udp_buffer>(stats_a, cga::network::buffer_size, 4096); });
+		}
 		else if (vm.count("debug_profile_process"))
 		{
 			if (cga::is_test_network)
@@ -52,6 +52,7 @@ public:
 			static_cast<BUILDER *> (this)->validate ();
 		}
 		assert (!ec);
+		block->hash_invalidate ();
 		return std::move (block);
 	}
 
@@ -63,6 +64,7 @@ public:
 			static_cast<BUILDER *> (this)->validate ();
 		}
 		ec = this->ec;
+		block->hash_invalidate ();
 		return std::move (block);
 	}
 
@@ -77,6 +79,8 @@ public:
 	/** Sign the block using the \p private_key and \p public_key */
 	inline abstract_builder & sign (cga::raw_key const & private_key, cga::public_key const & public_key)
 	{
+		// Hashables may have changed since the digest was last taken
+		block->hash_invalidate ();
 		block->signature = cga::sign_message (private_key, public_key, block->hash ());
 		build_state |= build_flags::signature_present;
 		return *this;
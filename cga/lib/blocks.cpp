@@ -89,24 +89,67 @@ size_t cga::block::size (cga::block_type type_a)
 	return result;
 }
 
+cga::block::block (cga::block const & other_a)
+{
+	if (other_a.cached_hash_state.load (std::memory_order_acquire) == hash_state::ready)
+	{
+		cached_hash = other_a.cached_hash;
+		cached_hash_state.store (hash_state::ready, std::memory_order_relaxed);
+	}
+}
+
+cga::block & cga::block::operator= (cga::block const & other_a)
+{
+	if (this != &other_a)
+	{
+		hash_invalidate ();
+		if (other_a.cached_hash_state.load (std::memory_order_acquire) == hash_state::ready)
+		{
+			cached_hash = other_a.cached_hash;
+			cached_hash_state.store (hash_state::ready, std::memory_order_release);
+		}
+	}
+	return *this;
+}
+
 cga::block_hash cga::block::hash () const
 {
 	cga::uint256_union result;
-	blake2b_state hash_l;
-	auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
-	assert (status == 0);
-	hash (hash_l);
-	status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
-	assert (status == 0);
+	if (cached_hash_state.load (std::memory_order_acquire) == hash_state::ready)
+	{
+		result = cached_hash;
+	}
+	else
+	{
+		blake2b_state hash_l;
+		auto status (blake2b_init (&hash_l, sizeof (result.bytes)));
+		assert (status == 0);
+		hash (hash_l);
+		status = blake2b_final (&hash_l, result.bytes.data (), sizeof (result.bytes));
+		assert (status == 0);
+		// Only the first thread to finish publishes its result, others keep their local copy
+		auto expected (hash_state::empty);
+		if (cached_hash_state.compare_exchange_strong (expected, hash_state::writing, std::memory_order_acquire))
+		{
+			cached_hash = result;
+			cached_hash_state.store (hash_state::ready, std::memory_order_release);
+		}
+	}
 	return result;
 }
 
+void cga::block::hash_invalidate ()
+{
+	cached_hash_state.store (hash_state::empty, std::memory_order_release);
+}
+
 cga::block_hash cga::block::full_hash () const
 {
 	cga::block_hash result;
 	blake2b_state state;
 	blake2b_init (&state, sizeof (result.bytes));
-	blake2b_update (&state, hash ().bytes.data (), sizeof (hash ()));
+	auto hash_l (hash ());
+	blake2b_update (&state, hash_l.bytes.data (), sizeof (hash_l));
 	auto signature (block_signature ());
 	blake2b_update (&state, signature.bytes.data (), sizeof (signature));
 	auto work (block_work ());
@@ -221,6 +264,7 @@ void cga::send_block::serialize (cga::stream & stream_a) const
 bool cga::send_block::deserialize (cga::stream & stream_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		read (stream_a, hashables.previous.bytes);
@@ -260,6 +304,7 @@ void cga::send_block::serialize_json (std::string & string_a) const
 bool cga::send_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		assert (tree_a.get<std::string> ("type") == "send");
@@ -536,6 +581,7 @@ void cga::open_block::serialize (cga::stream & stream_a) const
 bool cga::open_block::deserialize (cga::stream & stream_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		read (stream_a, hashables.source);
@@ -571,6 +617,7 @@ void cga::open_block::serialize_json (std::string & string_a) const
 bool cga::open_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		assert (tree_a.get<std::string> ("type") == "open");
@@ -774,6 +821,7 @@ void cga::change_block::serialize (cga::stream & stream_a) const
 bool cga::change_block::deserialize (cga::stream & stream_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		read (stream_a, hashables.previous);
@@ -807,6 +855,7 @@ void cga::change_block::serialize_json (std::string & string_a) const
 bool cga::change_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		assert (tree_a.get<std::string> ("type") == "change");
@@ -1053,6 +1102,7 @@ void cga::state_block::serialize (cga::stream & stream_a) const
 bool cga::state_block::deserialize (cga::stream & stream_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		read (stream_a, hashables.account);
@@ -1094,6 +1144,7 @@ void cga::state_block::serialize_json (std::string & string_a) const
 bool cga::state_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		assert (tree_a.get<std::string> ("type") == "state");
@@ -1349,6 +1400,7 @@ void cga::receive_block::serialize (cga::stream & stream_a) const
 bool cga::receive_block::deserialize (cga::stream & stream_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		read (stream_a, hashables.previous.bytes);
@@ -1386,6 +1438,7 @@ void cga::receive_block::serialize_json (std::string & string_a) const
 bool cga::receive_block::deserialize_json (boost::property_tree::ptree const & tree_a)
 {
 	auto error (false);
+	hash_invalidate ();
 	try
 	{
 		assert (tree_a.get<std::string> ("type") == "receive");
@@ -5,6 +5,7 @@
 #include <cga/lib/utility.hpp>
 
 #include <boost/property_tree/json_parser.hpp>
+#include <atomic>
 #include <cassert>
 #include <crypto/blake2/blake2.h>
 #include <streambuf>
@@ -56,8 +57,13 @@ enum class block_type : uint8_t
 class block
 {
 public:
-	// Return a digest of the hashables in this block.
+	block () = default;
+	block (cga::block const &);
+	cga::block & operator= (cga::block const &);
+	// Return a digest of the hashables in this block, computed once and cached.
 	cga::block_hash hash () const;
+	// Drop the cached digest, required after modifying hashables directly.
+	void hash_invalidate ();
 	// Return a digest of hashables and non-hashables in this block.
 	cga::block_hash full_hash () const;
 	std::string to_json () const;
@@ -84,6 +90,16 @@ public:
 	virtual ~block () = default;
 	virtual bool valid_predecessor (cga::block const &) const = 0;
 	static size_t size (cga::block_type);
+
+private:
+	enum class hash_state : uint8_t
+	{
+		empty,
+		writing,
+		ready
+	};
+	mutable cga::block_hash cached_hash;
+	mutable std::atomic<hash_state> cached_hash_state{ hash_state::empty };
 };
 class send_hashables
 {
@@ -0,0 +1,157 @@
+#include <cga/lib/cuckoo_filter.hpp>
+
+#include <utility>
+
+size_t constexpr cga::cuckoo_filter::bucket_size;
+size_t constexpr cga::cuckoo_filter::max_kicks;
+
+namespace
+{
+size_t bucket_count (size_t capacity_a)
+{
+	size_t result (1);
+	while (result * cga::cuckoo_filter::bucket_size < capacity_a)
+	{
+		result <<= 1;
+	}
+	return result;
+}
+}
+
+cga::cuckoo_filter::cuckoo_filter (size_t capacity_a) :
+slots (bucket_count (capacity_a) * bucket_size, 0),
+mask (bucket_count (capacity_a) - 1),
+count (0),
+victim_used (false),
+victim_index (0),
+victim_fingerprint (0),
+kick_random (0x9e3779b97f4a7c15ULL)
+{
+}
+
+bool cga::cuckoo_filter::insert (cga::uint256_union const & key_a)
+{
+	auto result (!victim_used);
+	if (result)
+	{
+		auto fingerprint_l (fingerprint (key_a));
+		auto index_l (index (key_a));
+		if (!bucket_insert (index_l, fingerprint_l) && !bucket_insert (alternate (index_l, fingerprint_l), fingerprint_l))
+		{
+			// Both buckets are full, keep evicting into the evicted fingerprint's other bucket until one has room
+			auto done (false);
+			for (size_t i (0); !done && i < max_kicks; ++i)
+			{
+				kick_random ^= kick_random << 13;
+				kick_random ^= kick_random >> 7;
+				kick_random ^= kick_random << 17;
+				std::swap (fingerprint_l, slots[index_l * bucket_size + kick_random % bucket_size]);
+				index_l = alternate (index_l, fingerprint_l);
+				done = bucket_insert (index_l, fingerprint_l);
+			}
+			if (!done)
+			{
+				victim_used = true;
+				victim_index = index_l;
+				victim_fingerprint = fingerprint_l;
+			}
+		}
+		++count;
+	}
+	return result;
+}
+
+void cga::cuckoo_filter::erase (cga::uint256_union const & key_a)
+{
+	auto fingerprint_l (fingerprint (key_a));
+	auto index_l (index (key_a));
+	auto alternate_l (alternate (index_l, fingerprint_l));
+	if (bucket_erase (index_l, fingerprint_l) || bucket_erase (alternate_l, fingerprint_l))
+	{
+		--count;
+		// A slot has been freed, the victim may fit again
+		if (victim_used && (bucket_insert (victim_index, victim_fingerprint) || bucket_insert (alternate (victim_index, victim_fingerprint), victim_fingerprint)))
+		{
+			victim_used = false;
+		}
+	}
+	else if (victim_used && victim_fingerprint == fingerprint_l && (victim_index == index_l || victim_index == alternate_l))
+	{
+		victim_used = false;
+		--count;
+	}
+}
+
+bool cga::cuckoo_filter::may_contain (cga::uint256_union const & key_a) const
+{
+	auto fingerprint_l (fingerprint (key_a));
+	auto index_l (index (key_a));
+	auto alternate_l (alternate (index_l, fingerprint_l));
+	return bucket_contains (index_l, fingerprint_l) || bucket_contains (alternate_l, fingerprint_l) || (victim_used && victim_fingerprint == fingerprint_l && (victim_index == index_l || victim_index == alternate_l));
+}
+
+size_t cga::cuckoo_filter::size () const
+{
+	return count;
+}
+
+size_t cga::cuckoo_filter::capacity () const
+{
+	return slots.size ();
+}
+
+size_t cga::cuckoo_filter::index (cga::uint256_union const & key_a) const
+{
+	return static_cast<size_t> (key_a.qwords[0]) & mask;
+}
+
+uint16_t cga::cuckoo_filter::fingerprint (cga::uint256_union const & key_a) const
+{
+	// Taken from bits not used for the index so the two stay independent
+	auto result (static_cast<uint16_t> (key_a.qwords[1]));
+	return result != 0 ? result : 1;
+}
+
+size_t cga::cuckoo_filter::alternate (size_t index_a, uint16_t fingerprint_a) const
+{
+	// Partial key cuckoo hashing, applying this twice gets back to the original bucket
+	return (index_a ^ (static_cast<size_t> (fingerprint_a) * 0x5bd1e995)) & mask;
+}
+
+bool cga::cuckoo_filter::bucket_insert (size_t index_a, uint16_t fingerprint_a)
+{
+	auto result (false);
+	for (size_t i (index_a * bucket_size), n (i + bucket_size); !result && i < n; ++i)
+	{
+		if (slots[i] == 0)
+		{
+			slots[i] = fingerprint_a;
+			result = true;
+		}
+	}
+	return result;
+}
+
+bool cga::cuckoo_filter::bucket_erase (size_t index_a, uint16_t fingerprint_a)
+{
+	auto result (false);
+	for (size_t i (index_a * bucket_size), n (i + bucket_size); !result && i < n; ++i)
+	{
+		if (slots[i] == fingerprint_a)
+		{
+			slots[i] = 0;
+			result = true;
+		}
+	}
+	return result;
+}
+
+bool cga::cuckoo_filter::bucket_contains (size_t index_a, uint16_t fingerprint_a) const
+{
+	auto result (false);
+	for (size_t i (index_a * bucket_size), n (i + bucket_size); !result && i < n; ++i)
+	{
+		result = slots[i] == fingerprint_a;
+	}
+	return result;
+}
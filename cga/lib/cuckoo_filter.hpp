@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cga/lib/numbers.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace cga
+{
+/**
+ * Approximate set membership for 256 bit keys which are already uniformly distributed, such as block hashes.
+ * Each key is reduced to a 16 bit fingerprint kept in one of two candidate buckets of four slots, so a lookup
+ * touches at most two cache lines. There are no false negatives as long as only inserted keys are erased,
+ * absent keys are reported as present about 8 times in 65536 when the filter is full.
+ * Unlike a bloom filter keys can be erased, every insert adds a copy so duplicate keys must be erased as many times.
+ * Not thread safe, callers synchronise access.
+ */
+class cuckoo_filter
+{
+public:
+	cuckoo_filter (size_t);
+	// Returns false if the filter is too full to take the key, it is left unchanged and needs rebuilding with more capacity
+	bool insert (cga::uint256_union const &);
+	void erase (cga::uint256_union const &);
+	bool may_contain (cga::uint256_union const &) const;
+	size_t size () const;
+	size_t capacity () const;
+	static size_t constexpr bucket_size = 4;
+	static size_t constexpr max_kicks = 512;
+
+private:
+	size_t index (cga::uint256_union const &) const;
+	uint16_t fingerprint (cga::uint256_union const &) const;
+	size_t alternate (size_t, uint16_t) const;
+	bool bucket_insert (size_t, uint16_t);
+	bool bucket_erase (size_t, uint16_t);
+	bool bucket_contains (size_t, uint16_t) const;
+	// Zero marks an empty slot, fingerprints are never zero
+	std::vector<uint16_t> slots;
+	size_t mask;
+	size_t count;
+	// Fingerprint displaced by the last insert which ran out of kicks, kept so it's never lost
+	bool victim_used;
+	size_t victim_index;
+	uint16_t victim_fingerprint;
+	uint64_t kick_random;
+};
+}
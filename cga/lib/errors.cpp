@@ -144,6 +144,8 @@ std::string cga::error_rpc_messages::message (int ev) const
 			return "Representative account and previous hash required";
 		case cga::error_rpc::block_create_requirements_send:
 			return "Destination account, previous hash, current balance and amount required";
+		case cga::error_rpc::block_trace_disabled:
+			return "Block tracing is disabled, set block_trace_interval in the node config";
 		case cga::error_rpc::confirmation_not_found:
 			return "Active confirmation not found";
 		case cga::error_rpc::invalid_balance:
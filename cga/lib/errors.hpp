@@ -88,6 +88,7 @@ enum class error_rpc
 	block_create_requirements_receive,
 	block_create_requirements_change,
 	block_create_requirements_send,
+	block_trace_disabled,
 	confirmation_not_found,
 	invalid_balance,
 	invalid_destinations,
@@ -0,0 +1,74 @@
+#include <cga/lib/lockfree.hpp>
+
+#include <climits>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(__linux__)
+static_assert (sizeof (std::atomic<uint32_t>) == sizeof (uint32_t), "Futex word must be a plain 32 bit integer");
+
+void futex_wait (std::atomic<uint32_t> & word_a, uint32_t expected_a)
+{
+	syscall (SYS_futex, reinterpret_cast<uint32_t *> (&word_a), FUTEX_WAIT_PRIVATE, expected_a, nullptr, nullptr, 0);
+}
+
+void futex_wake_all (std::atomic<uint32_t> & word_a)
+{
+	syscall (SYS_futex, reinterpret_cast<uint32_t *> (&word_a), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+#endif
+}
+
+cga::event_count::event_count () :
+epoch (0)
+{
+}
+
+uint32_t cga::event_count::prepare_wait ()
+{
+	auto result (epoch.fetch_or (1) | 1);
+	// Pairs with the fence in notify_all, either the notifier sees the sleeper bit or the waiter's re-check sees the change
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	return result;
+}
+
+void cga::event_count::wait (uint32_t epoch_a)
+{
+#if defined(__linux__)
+	while (epoch.load () == epoch_a)
+	{
+		futex_wait (epoch, epoch_a);
+	}
+#else
+	std::unique_lock<std::mutex> lock (mutex);
+	while (epoch.load () == epoch_a)
+	{
+		condition.wait (lock);
+	}
+#endif
+}
+
+void cga::event_count::notify_all ()
+{
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	auto current (epoch.load ());
+	// Advancing clears the sleeper bit, if the exchange fails another notifier has already woken everyone
+	if ((current & 1) && epoch.compare_exchange_strong (current, current + 1))
+	{
+#if defined(__linux__)
+		futex_wake_all (epoch);
+#else
+		{
+			// Serialise with a waiter between its epoch check and blocking on the condition
+			std::lock_guard<std::mutex> lock (mutex);
+		}
+		condition.notify_all ();
+#endif
+	}
+}
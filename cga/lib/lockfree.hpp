@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace cga
+{
+/**
+ * Bounded multi-producer multi-consumer FIFO. Every cell carries a sequence number telling producers and consumers
+ * whose turn it is, so the only shared writes are a CAS on the producer or consumer cursor.
+ * Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class mpmc_ring
+{
+public:
+	mpmc_ring (size_t);
+	// Returns false if the ring is full
+	bool push (T const &);
+	// Returns false if the ring is empty, leaving the argument untouched
+	bool pop (T &);
+	// Number of values pushed and not yet popped, only a snapshot while other threads are using the ring
+	size_t size () const;
+	size_t capacity () const;
+
+private:
+	class cell
+	{
+	public:
+		std::atomic<size_t> sequence;
+		T value;
+	};
+	static size_t round_up (size_t);
+	std::unique_ptr<cell[]> cells;
+	size_t const mask;
+	// Cursors live on separate cache lines so producers and consumers don't invalidate each other
+	alignas (64) std::atomic<size_t> push_position;
+	alignas (64) std::atomic<size_t> pop_position;
+};
+
+/**
+ * Lets threads sleep until a lock-free structure changes without any locking on the fast path.
+ * A waiter calls prepare_wait, re-checks its condition and only calls wait if it still has nothing to do.
+ * The low bit of the epoch marks that someone may be sleeping on it, so notify_all only enters the kernel
+ * once per batch of sleepers rather than on every change. Backed by a futex on Linux, a mutex and condition variable elsewhere.
+ */
+class event_count
+{
+public:
+	event_count ();
+	uint32_t prepare_wait ();
+	void wait (uint32_t);
+	void notify_all ();
+
+private:
+	std::atomic<uint32_t> epoch;
+#if !defined(__linux__)
+	std::mutex mutex;
+	std::condition_variable condition;
+#endif
+};
+}
+
+template <typename T>
+cga::mpmc_ring<T>::mpmc_ring (size_t capacity_a) :
+cells (new cell[round_up (capacity_a)]),
+mask (round_up (capacity_a) - 1),
+push_position (0),
+pop_position (0)
+{
+	for (size_t i (0); i <= mask; ++i)
+	{
+		cells[i].sequence.store (i, std::memory_order_relaxed);
+	}
+}
+
+template <typename T>
+bool cga::mpmc_ring<T>::push (T const & value_a)
+{
+	auto result (false);
+	auto position (push_position.load (std::memory_order_relaxed));
+	cell * target (nullptr);
+	while (target == nullptr)
+	{
+		auto & current (cells[position & mask]);
+		auto sequence (current.sequence.load (std::memory_order_acquire));
+		auto difference (static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position));
+		if (difference == 0)
+		{
+			if (push_position.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+			{
+				target = &current;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Cell still holds a value from the previous lap, ring is full
+			break;
+		}
+		else
+		{
+			position = push_position.load (std::memory_order_relaxed);
+		}
+	}
+	if (target != nullptr)
+	{
+		target->value = value_a;
+		target->sequence.store (position + 1, std::memory_order_release);
+		result = true;
+	}
+	return result;
+}
+
+template <typename T>
+bool cga::mpmc_ring<T>::pop (T & value_a)
+{
+	auto result (false);
+	auto position (pop_position.load (std::memory_order_relaxed));
+	cell * target (nullptr);
+	while (target == nullptr)
+	{
+		auto & current (cells[position & mask]);
+		auto sequence (current.sequence.load (std::memory_order_acquire));
+		auto difference (static_cast<intptr_t> (sequence) - static_cast<intptr_t> (position + 1));
+		if (difference == 0)
+		{
+			if (pop_position.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+			{
+				target = &current;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Cell hasn't been written on this lap, ring is empty
+			break;
+		}
+		else
+		{
+			position = pop_position.load (std::memory_order_relaxed);
+		}
+	}
+	if (target != nullptr)
+	{
+		value_a = target->value;
+		target->sequence.store (position + mask + 1, std::memory_order_release);
+		result = true;
+	}
+	return result;
+}
+
+template <typename T>
+size_t cga::mpmc_ring<T>::size () const
+{
+	// Pop cursor is read first so a concurrent push can only make the result larger, never wrap below zero
+	auto pop (pop_position.load (std::memory_order_relaxed));
+	auto push (push_position.load (std::memory_order_relaxed));
+	return push > pop ? std::min (push - pop, mask + 1) : 0;
+}
+
+template <typename T>
+size_t cga::mpmc_ring<T>::capacity () const
+{
+	return mask + 1;
+}
+
+template <typename T>
+size_t cga::mpmc_ring<T>::round_up (size_t capacity_a)
+{
+	assert (capacity_a > 0);
+	size_t result (1);
+	while (result < capacity_a)
+	{
+		result <<= 1;
+	}
+	return result;
+}
@@ -0,0 +1,299 @@
+#include <cga/lib/timing_wheel.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+size_t constexpr cga::timing_wheel::level_bits;
+size_t constexpr cga::timing_wheel::slot_count;
+size_t constexpr cga::timing_wheel::level_count;
+std::chrono::milliseconds constexpr cga::timing_wheel::resolution;
+size_t constexpr cga::timing_wheel::entry_size;
+uint32_t constexpr cga::timing_wheel::npos;
+uint64_t constexpr cga::timing_wheel::tick_npos;
+uint32_t constexpr cga::timing_wheel::overflow;
+uint32_t constexpr cga::timing_wheel::ready;
+
+cga::timing_wheel::timing_wheel () :
+epoch (std::chrono::steady_clock::now ()),
+current (0),
+free_list (npos),
+count (0)
+{
+	heads.fill (npos);
+	tails.fill (npos);
+	counts.fill (0);
+	occupied.fill (0);
+}
+
+cga::timing_wheel::handle cga::timing_wheel::insert (std::chrono::steady_clock::time_point wakeup_a, std::function<void()> function_a)
+{
+	uint32_t index;
+	if (free_list != npos)
+	{
+		index = free_list;
+		free_list = entries[index].next;
+	}
+	else
+	{
+		index = static_cast<uint32_t> (entries.size ());
+		entries.push_back (entry{});
+		entries[index].generation = 0;
+	}
+	auto & entry_l (entries[index]);
+	entry_l.wakeup = wakeup_a;
+	entry_l.tick = tick_of (wakeup_a);
+	entry_l.function = std::move (function_a);
+	place (index);
+	++count;
+	return handle{ index, entry_l.generation };
+}
+
+bool cga::timing_wheel::erase (cga::timing_wheel::handle const & handle_a)
+{
+	auto result (handle_a.index >= entries.size () || entries[handle_a.index].generation != handle_a.generation || entries[handle_a.index].list == npos);
+	if (!result)
+	{
+		unlink (handle_a.index);
+		release (handle_a.index);
+		--count;
+	}
+	return result;
+}
+
+void cga::timing_wheel::expire (std::chrono::steady_clock::time_point now_a, std::vector<std::function<void()>> & functions_a)
+{
+	assert (expired.empty ());
+	auto limit (now_a > epoch ? static_cast<uint64_t> ((now_a - epoch) / resolution) : 0);
+	for (auto i (detach (ready)); i != npos; i = entries[i].next)
+	{
+		expired.push_back (i);
+	}
+	for (auto tick (next_tick ()); tick <= limit; tick = next_tick ())
+	{
+		auto crossed (tick ^ current);
+		current = tick;
+		if ((crossed >> (level_count * level_bits)) != 0)
+		{
+			cascade (overflow);
+		}
+		for (auto level (level_count - 1); level > 0; --level)
+		{
+			if ((current & ((uint64_t (1) << (level * level_bits)) - 1)) == 0)
+			{
+				cascade (static_cast<uint32_t> (level * slot_count + ((current >> (level * level_bits)) & (slot_count - 1))));
+			}
+		}
+		for (auto i (detach (static_cast<uint32_t> (current & (slot_count - 1)))); i != npos; i = entries[i].next)
+		{
+			expired.push_back (i);
+		}
+	}
+	// Nothing is due before the limit, so the wheel can skip straight to it
+	current = std::max (current, limit);
+	std::stable_sort (expired.begin (), expired.end (), [this](uint32_t lhs, uint32_t rhs) {
+		return entries[lhs].wakeup < entries[rhs].wakeup;
+	});
+	for (auto i : expired)
+	{
+		functions_a.push_back (std::move (entries[i].function));
+		release (i);
+	}
+	count -= expired.size ();
+	expired.clear ();
+}
+
+std::chrono::steady_clock::time_point cga::timing_wheel::next () const
+{
+	auto tick (next_tick ());
+	return tick != tick_npos ? epoch + resolution * static_cast<std::chrono::milliseconds::rep> (tick) : std::chrono::steady_clock::time_point::max ();
+}
+
+size_t cga::timing_wheel::size () const
+{
+	return count;
+}
+
+size_t cga::timing_wheel::occupancy (size_t level_a, size_t slot_a) const
+{
+	assert (level_a < level_count && slot_a < slot_count);
+	return counts[level_a * slot_count + slot_a];
+}
+
+size_t cga::timing_wheel::overflow_size () const
+{
+	return counts[overflow];
+}
+
+size_t cga::timing_wheel::ready_size () const
+{
+	return counts[ready];
+}
+
+uint64_t cga::timing_wheel::tick_of (std::chrono::steady_clock::time_point time_a) const
+{
+	uint64_t result (0);
+	if (time_a > epoch)
+	{
+		auto elapsed (time_a - epoch);
+		result = static_cast<uint64_t> (elapsed / resolution);
+		// Rounded up so nothing runs before its time
+		if (elapsed % resolution != elapsed.zero ())
+		{
+			++result;
+		}
+	}
+	return result;
+}
+
+uint64_t cga::timing_wheel::next_tick () const
+{
+	auto result (tick_npos);
+	if (counts[ready] != 0)
+	{
+		result = current;
+	}
+	for (size_t level (0); result == tick_npos && level < level_count; ++level)
+	{
+		auto shift (level * level_bits);
+		// Slots at or behind the current one belong to the next revolution and are never occupied
+		auto first ((current >> shift & (slot_count - 1)) + 1);
+		auto words (occupied.data () + level * slot_count / 64);
+		for (auto word (first / 64); result == tick_npos && word < slot_count / 64; ++word)
+		{
+			auto bits (words[word]);
+			if (word == first / 64)
+			{
+				bits &= first % 64 != 0 ? ~uint64_t (0) << (first % 64) : ~uint64_t (0);
+			}
+			if (bits != 0)
+			{
+				uint64_t slot (word * 64);
+				for (; (bits & 1) == 0; bits >>= 1)
+				{
+					++slot;
+				}
+				auto above (shift + level_bits);
+				result = (current >> above << above) | (slot << shift);
+			}
+		}
+	}
+	if (result == tick_npos && counts[overflow] != 0)
+	{
+		auto above (level_count * level_bits);
+		result = ((current >> above) + 1) << above;
+	}
+	return result;
+}
+
+void cga::timing_wheel::place (uint32_t index_a)
+{
+	auto tick (entries[index_a].tick);
+	uint32_t list (ready);
+	if (tick > current)
+	{
+		list = overflow;
+		auto differ (tick ^ current);
+		for (size_t level (0); list == overflow && level < level_count; ++level)
+		{
+			if ((differ >> ((level + 1) * level_bits)) == 0)
+			{
+				list = static_cast<uint32_t> (level * slot_count + ((tick >> (level * level_bits)) & (slot_count - 1)));
+			}
+		}
+	}
+	link (list, index_a);
+}
+
+void cga::timing_wheel::link (uint32_t list_a, uint32_t index_a)
+{
+	auto & entry_l (entries[index_a]);
+	entry_l.list = list_a;
+	entry_l.next = npos;
+	entry_l.previous = tails[list_a];
+	if (tails[list_a] != npos)
+	{
+		entries[tails[list_a]].next = index_a;
+	}
+	else
+	{
+		heads[list_a] = index_a;
+	}
+	tails[list_a] = index_a;
+	if (counts[list_a]++ == 0 && list_a < overflow)
+	{
+		occupied[list_a / 64] |= uint64_t (1) << (list_a % 64);
+	}
+}
+
+void cga::timing_wheel::unlink (uint32_t index_a)
+{
+	auto & entry_l (entries[index_a]);
+	auto list (entry_l.list);
+	if (entry_l.previous != npos)
+	{
+		entries[entry_l.previous].next = entry_l.next;
+	}
+	else
+	{
+		heads[list] = entry_l.next;
+	}
+	if (entry_l.next != npos)
+	{
+		entries[entry_l.next].previous = entry_l.previous;
+	}
+	else
+	{
+		tails[list] = entry_l.previous;
+	}
+	entry_l.list = npos;
+	if (--counts[list] == 0 && list < overflow)
+	{
+		occupied[list / 64] &= ~(uint64_t (1) << (list % 64));
+	}
+}
+
+uint32_t cga::timing_wheel::detach (uint32_t list_a)
+{
+	auto result (heads[list_a]);
+	for (auto i (result); i != npos; i = entries[i].next)
+	{
+		entries[i].list = npos;
+	}
+	heads[list_a] = npos;
+	tails[list_a] = npos;
+	counts[list_a] = 0;
+	if (list_a < overflow)
+	{
+		occupied[list_a / 64] &= ~(uint64_t (1) << (list_a % 64));
+	}
+	return result;
+}
+
+void cga::timing_wheel::release (uint32_t index_a)
+{
+	auto & entry_l (entries[index_a]);
+	entry_l.function = nullptr;
+	entry_l.list = npos;
+	// Outstanding handles to the entry no longer match
+	++entry_l.generation;
+	entry_l.next = free_list;
+	free_list = index_a;
+}
+
+void cga::timing_wheel::cascade (uint32_t list_a)
+{
+	for (auto i (detach (list_a)); i != npos;)
+	{
+		// Placing the entry overwrites its link
+		auto next (entries[i].next);
+		if (entries[i].tick == current)
+		{
+			expired.push_back (i);
+		}
+		else
+		{
+			place (i);
+		}
+		i = next;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace cga
+{
+/**
+ * Hierarchical timing wheel holding operations to run at a given time, with a resolution of one millisecond.
+ * Each of the four levels has 256 slots, an operation is kept in the lowest level whose slot range covers the
+ * time until it's due and moves down a level each time the level above reaches its slot. Operations more
+ * than 2^32 milliseconds out wait in an overflow list and operations already due in a ready list, so they aren't held
+ * back to the next tick. Insert and erase are constant time, and finding the next
+ * slot with anything in it is a scan of occupancy bitmaps, so expiry skips straight over idle stretches.
+ * Entries are pooled and linked by index, so inserting doesn't allocate once the pool has grown.
+ * Not thread safe, callers synchronise access.
+ */
+class timing_wheel
+{
+public:
+	/** Identifies an inserted operation, erasing through it is harmless once the operation has expired */
+	class handle
+	{
+	public:
+		uint32_t index;
+		uint32_t generation;
+	};
+	timing_wheel ();
+	cga::timing_wheel::handle insert (std::chrono::steady_clock::time_point, std::function<void()>);
+	// Returns true if there was nothing to erase, the operation has already expired or been erased
+	bool erase (cga::timing_wheel::handle const &);
+	// Moves every operation due at or before the given time to the end of the vector, earliest first
+	void expire (std::chrono::steady_clock::time_point, std::vector<std::function<void()>> &);
+	// When expire will next have anything to do, time_point::max () if the wheel is empty
+	std::chrono::steady_clock::time_point next () const;
+	size_t size () const;
+	// Number of operations in a slot of a level
+	size_t occupancy (size_t level, size_t slot) const;
+	size_t overflow_size () const;
+	size_t ready_size () const;
+	static size_t constexpr level_bits = 8;
+	static size_t constexpr slot_count = 1 << level_bits;
+	static size_t constexpr level_count = 4;
+	static std::chrono::milliseconds constexpr resolution = std::chrono::milliseconds (1);
+
+private:
+	class entry
+	{
+	public:
+		std::chrono::steady_clock::time_point wakeup;
+		uint64_t tick;
+		std::function<void()> function;
+		uint32_t next;
+		uint32_t previous;
+		uint32_t generation;
+		// List the entry is linked into, npos while it's free
+		uint32_t list;
+	};
+
+public:
+	static size_t constexpr entry_size = sizeof (entry);
+
+private:
+	static uint32_t constexpr npos = ~uint32_t (0);
+	static uint64_t constexpr tick_npos = ~uint64_t (0);
+	static uint32_t constexpr overflow = level_count * slot_count;
+	static uint32_t constexpr ready = overflow + 1;
+	uint64_t tick_of (std::chrono::steady_clock::time_point) const;
+	uint64_t next_tick () const;
+	// Links the entry into the list for its tick, relative to the current tick
+	void place (uint32_t);
+	void link (uint32_t list, uint32_t);
+	void unlink (uint32_t);
+	// Unlinks a whole list, returning its first entry
+	uint32_t detach (uint32_t list);
+	void release (uint32_t);
+	// Moves the entries of a list whose slot the current tick has reached down the wheel, collecting the ones now due
+	void cascade (uint32_t list);
+	std::chrono::steady_clock::time_point const epoch;
+	// Every operation due at or before this tick has expired
+	uint64_t current;
+	std::vector<cga::timing_wheel::entry> entries;
+	uint32_t free_list;
+	std::array<uint32_t, ready + 1> heads;
+	std::array<uint32_t, ready + 1> tails;
+	std::array<uint32_t, ready + 1> counts;
+	// One bit per slot, set while it has anything in it
+	std::array<uint64_t, overflow / 64> occupied;
+	// Entries collected by expire, kept to reuse its capacity
+	std::vector<uint32_t> expired;
+	size_t count;
+};
+}
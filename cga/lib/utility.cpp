@@ -54,7 +54,7 @@ namespace thread_role
 		return current_thread_role;
 	}
 
-	static std::string get_string (cga::thread_role::name role)
+	std::string get_string (cga::thread_role::name role)
 	{
 		std::string thread_role_name_string;
 
@@ -99,6 +99,24 @@ namespace thread_role
 			case cga::thread_role::name::slow_db_upgrade:
 				thread_role_name_string = "Slow db upgrade";
 				break;
+			case cga::thread_role::name::block_verification:
+				thread_role_name_string = "Blck verifying";
+				break;
+			case cga::thread_role::name::block_post_commit:
+				thread_role_name_string = "Blck postcommit";
+				break;
+			case cga::thread_role::name::write_queue:
+				thread_role_name_string = "Write queue";
+				break;
+			case cga::thread_role::name::confirmation_height_processing:
+				thread_role_name_string = "Conf height";
+				break;
+			case cga::thread_role::name::stat_aggregation:
+				thread_role_name_string = "Stat aggregator";
+				break;
+			case cga::thread_role::name::block_filter_rebuild:
+				thread_role_name_string = "Blck filter";
+				break;
 		}
 
 		/*
@@ -86,6 +86,12 @@ namespace thread_role
 		voting,
 		signature_checking,
 		slow_db_upgrade,
+		block_verification,
+		block_post_commit,
+		write_queue,
+		confirmation_height_processing,
+		stat_aggregation,
+		block_filter_rebuild,
 	};
 	/*
 	 * Get/Set the identifier for the current thread
@@ -98,6 +104,11 @@ namespace thread_role
 	 */
 	std::string get_string ();
 
+	/*
+	 * Get the given role as a string, as used for thread names
+	 */
+	std::string get_string (cga::thread_role::name);
+
 	/*
 	 * Internal only, should not be called directly
 	 */
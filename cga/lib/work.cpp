@@ -3,6 +3,7 @@
 #include <cga/lib/blocks.hpp>
 #include <cga/node/xorshift.hpp>
 
+#include <algorithm>
 #include <future>
 
 bool cga::work_validate (cga::block_hash const & root_a, uint64_t work_a, uint64_t * difficulty_a)
@@ -23,18 +24,40 @@ bool cga::work_validate (cga::block const & block_a, uint64_t * difficulty_a)
 uint64_t cga::work_value (cga::block_hash const & root_a, uint64_t work_a)
 {
 	uint64_t result;
-	blake2b_state hash;
-	blake2b_init (&hash, sizeof (result));
-	blake2b_update (&hash, reinterpret_cast<uint8_t *> (&work_a), sizeof (work_a));
-	blake2b_update (&hash, root_a.bytes.data (), root_a.bytes.size ());
-	blake2b_final (&hash, reinterpret_cast<uint8_t *> (&result), sizeof (result));
+	cga::work_values (cga::work_kernel::scalar, root_a, &work_a, &result);
 	return result;
 }
 
+void cga::work_validate_batch (cga::block_hash const * roots_a, uint64_t const * works_a, size_t count_a, int * valid_a)
+{
+	auto kernel (cga::work_kernel_best ());
+	auto lanes (cga::work_kernel_lanes (kernel));
+	cga::uint256_union const * roots[cga::work_kernel_max_lanes];
+	uint64_t works[cga::work_kernel_max_lanes];
+	uint64_t values[cga::work_kernel_max_lanes];
+	for (size_t i (0); i < count_a; i += lanes)
+	{
+		auto filled (std::min (lanes, count_a - i));
+		for (size_t j (0); j < lanes; ++j)
+		{
+			// Pad a partial final batch by repeating the last pair, its results are discarded
+			auto index (i + std::min (j, filled - 1));
+			roots[j] = &roots_a[index];
+			works[j] = works_a[index];
+		}
+		cga::work_values (kernel, roots, works, values);
+		for (size_t j (0); j < filled; ++j)
+		{
+			valid_a[i + j] = values[j] >= cga::work_pool::publish_threshold ? 1 : 0;
+		}
+	}
+}
+
 cga::work_pool::work_pool (unsigned max_threads_a, std::function<boost::optional<uint64_t> (cga::uint256_union const &)> opencl_a) :
 ticket (0),
 done (false),
-opencl (opencl_a)
+opencl (opencl_a),
+kernel (cga::work_kernel_best ())
 {
 	static_assert (ATOMIC_INT_LOCK_FREE == 2, "Atomic int needed");
 	boost::thread::attributes attrs;
@@ -67,8 +90,9 @@ void cga::work_pool::loop (uint64_t thread)
 	cga::random_pool::generate_block (reinterpret_cast<uint8_t *> (rng.s.data ()), rng.s.size () * sizeof (decltype (rng.s)::value_type));
 	uint64_t work;
 	uint64_t output;
-	blake2b_state hash;
-	blake2b_init (&hash, sizeof (output));
+	auto lanes (cga::work_kernel_lanes (kernel));
+	std::array<uint64_t, cga::work_kernel_max_lanes> works;
+	std::array<uint64_t, cga::work_kernel_max_lanes> outputs;
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!done || !pending.empty ())
 	{
@@ -90,14 +114,20 @@ void cga::work_pool::loop (uint64_t thread)
 				// Don't query main memory every iteration in order to reduce memory bus traffic
 				// All operations here operate on stack memory
 				// Count iterations down to zero since comparing to zero is easier than comparing to another number
+				// Each iteration evaluates one nonce per kernel lane
 				unsigned iteration (256);
 				while (iteration && output < current_l.difficulty)
 				{
-					work = rng.next ();
-					blake2b_update (&hash, reinterpret_cast<uint8_t *> (&work), sizeof (work));
-					blake2b_update (&hash, current_l.item.bytes.data (), current_l.item.bytes.size ());
-					blake2b_final (&hash, reinterpret_cast<uint8_t *> (&output), sizeof (output));
-					blake2b_init (&hash, sizeof (output));
+					for (size_t i (0); i < lanes; ++i)
+					{
+						works[i] = rng.next ();
+					}
+					cga::work_values (kernel, current_l.item, works.data (), outputs.data ());
+					for (size_t i (0); i < lanes && output < current_l.difficulty; ++i)
+					{
+						work = works[i];
+						output = outputs[i];
+					}
 					iteration -= 1;
 				}
 			}
@@ -5,7 +5,9 @@
 #include <cga/lib/config.hpp>
 #include <cga/lib/numbers.hpp>
 #include <cga/lib/utility.hpp>
+#include <cga/lib/work_kernel.hpp>
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <memory>
@@ -17,6 +19,8 @@ class block;
 bool work_validate (cga::block_hash const &, uint64_t, uint64_t * = nullptr);
 bool work_validate (cga::block const &, uint64_t * = nullptr);
 uint64_t work_value (cga::block_hash const &, uint64_t);
+/** Validate count (root, work) pairs using the widest work kernel, valid[i] is set to 1 when pair i meets the publish threshold */
+void work_validate_batch (cga::block_hash const *, uint64_t const *, size_t, int *);
 class opencl_work;
 class work_item
 {
@@ -43,6 +47,8 @@ public:
 	std::condition_variable producer_condition;
 	std::function<boost::optional<uint64_t> (cga::uint256_union const &)> opencl;
 	cga::observer_set<bool> work_observers;
+	// Hashing kernel used by the work threads, the widest one this CPU supports
+	cga::work_kernel const kernel;
 	// Local work threshold for rate-limiting publishing blocks. ~5 seconds of work.
 	static uint64_t const publish_test_threshold = 0xff00000000000000;
 	static uint64_t const publish_full_threshold = 0xffffffc000000000;
@@ -0,0 +1,291 @@
+#include <cga/lib/work_kernel.hpp>
+
+#include <cassert>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CGA_WORK_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+uint64_t const blake2b_iv[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+uint8_t const blake2b_sigma[12][16] = {
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+	{ 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+	{ 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+	{ 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+	{ 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+	{ 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+	{ 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+	{ 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+	{ 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+	{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+// Parameter block for an unkeyed 8 byte digest: digest length 8, fanout 1, depth 1
+uint64_t const work_h0 (blake2b_iv[0] ^ 0x01010008ULL);
+// Message is nonce (8 bytes) followed by root (32 bytes)
+uint64_t const work_message_size (40);
+
+/*
+ * The compression below is shared by every kernel, each one defines WORK_ADD, WORK_XOR and the rotations for its lane type.
+ * v holds the working state and m the message words, both arrays of the lane type.
+ */
+#define WORK_G(r, i, a, b, c, d)                                      \
+	a = WORK_ADD (WORK_ADD (a, b), m[blake2b_sigma[r][2 * i + 0]]); \
+	d = WORK_ROR32 (WORK_XOR (d, a));                              \
+	c = WORK_ADD (c, d);                                           \
+	b = WORK_ROR24 (WORK_XOR (b, c));                              \
+	a = WORK_ADD (WORK_ADD (a, b), m[blake2b_sigma[r][2 * i + 1]]); \
+	d = WORK_ROR16 (WORK_XOR (d, a));                              \
+	c = WORK_ADD (c, d);                                           \
+	b = WORK_ROR63 (WORK_XOR (b, c));
+
+#define WORK_ROUNDS                                   \
+	for (auto r (0); r < 12; ++r)                     \
+	{                                                 \
+		WORK_G (r, 0, v[0], v[4], v[8], v[12]);  \
+		WORK_G (r, 1, v[1], v[5], v[9], v[13]);  \
+		WORK_G (r, 2, v[2], v[6], v[10], v[14]); \
+		WORK_G (r, 3, v[3], v[7], v[11], v[15]); \
+		WORK_G (r, 4, v[0], v[5], v[10], v[15]); \
+		WORK_G (r, 5, v[1], v[6], v[11], v[12]); \
+		WORK_G (r, 6, v[2], v[7], v[8], v[13]);  \
+		WORK_G (r, 7, v[3], v[4], v[9], v[14]);  \
+	}
+
+void work_values_scalar (cga::uint256_union const * const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+#define WORK_ADD(a, b) ((a) + (b))
+#define WORK_XOR(a, b) ((a) ^ (b))
+#define WORK_ROR(a, n) (((a) >> (n)) | ((a) << (64 - (n))))
+#define WORK_ROR32(a) WORK_ROR (a, 32)
+#define WORK_ROR24(a) WORK_ROR (a, 24)
+#define WORK_ROR16(a) WORK_ROR (a, 16)
+#define WORK_ROR63(a) WORK_ROR (a, 63)
+	auto const & root (*roots_a[0]);
+	uint64_t m[16] = { nonces_a[0], root.qwords[0], root.qwords[1], root.qwords[2], root.qwords[3] };
+	uint64_t v[16] = {
+		work_h0, blake2b_iv[1], blake2b_iv[2], blake2b_iv[3], blake2b_iv[4], blake2b_iv[5], blake2b_iv[6], blake2b_iv[7],
+		blake2b_iv[0], blake2b_iv[1], blake2b_iv[2], blake2b_iv[3], blake2b_iv[4] ^ work_message_size, blake2b_iv[5], ~blake2b_iv[6], blake2b_iv[7]
+	};
+	WORK_ROUNDS
+	values_a[0] = work_h0 ^ v[0] ^ v[8];
+#undef WORK_ADD
+#undef WORK_XOR
+#undef WORK_ROR
+#undef WORK_ROR32
+#undef WORK_ROR24
+#undef WORK_ROR16
+#undef WORK_ROR63
+}
+
+#if CGA_WORK_KERNEL_X86
+/** Gather each root word across lanes so word i of lane j lands at words_a[i * lanes_a + j] */
+void transpose_roots (cga::uint256_union const * const * roots_a, size_t lanes_a, uint64_t * words_a)
+{
+	for (size_t j (0); j < lanes_a; ++j)
+	{
+		for (size_t i (0); i < 4; ++i)
+		{
+			words_a[i * lanes_a + j] = roots_a[j]->qwords[i];
+		}
+	}
+}
+
+__attribute__ ((target ("avx2"))) void work_values_avx2 (cga::uint256_union const * const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+#define WORK_ADD(a, b) _mm256_add_epi64 (a, b)
+#define WORK_XOR(a, b) _mm256_xor_si256 (a, b)
+#define WORK_ROR32(a) _mm256_shuffle_epi32 (a, _MM_SHUFFLE (2, 3, 0, 1))
+#define WORK_ROR24(a) _mm256_shuffle_epi8 (a, rotate24)
+#define WORK_ROR16(a) _mm256_shuffle_epi8 (a, rotate16)
+#define WORK_ROR63(a) _mm256_or_si256 (_mm256_srli_epi64 (a, 63), _mm256_add_epi64 (a, a))
+	auto const rotate24 (_mm256_setr_epi8 (3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10));
+	auto const rotate16 (_mm256_setr_epi8 (2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9));
+	__m256i m[16];
+	m[0] = _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (nonces_a));
+	uint64_t words[4][4];
+	transpose_roots (roots_a, 4, words[0]);
+	for (auto i (0); i < 4; ++i)
+	{
+		m[i + 1] = _mm256_loadu_si256 (reinterpret_cast<__m256i const *> (words[i]));
+	}
+	for (auto i (5); i < 16; ++i)
+	{
+		m[i] = _mm256_setzero_si256 ();
+	}
+	__m256i v[16] = {
+		_mm256_set1_epi64x (work_h0), _mm256_set1_epi64x (blake2b_iv[1]), _mm256_set1_epi64x (blake2b_iv[2]), _mm256_set1_epi64x (blake2b_iv[3]),
+		_mm256_set1_epi64x (blake2b_iv[4]), _mm256_set1_epi64x (blake2b_iv[5]), _mm256_set1_epi64x (blake2b_iv[6]), _mm256_set1_epi64x (blake2b_iv[7]),
+		_mm256_set1_epi64x (blake2b_iv[0]), _mm256_set1_epi64x (blake2b_iv[1]), _mm256_set1_epi64x (blake2b_iv[2]), _mm256_set1_epi64x (blake2b_iv[3]),
+		_mm256_set1_epi64x (blake2b_iv[4] ^ work_message_size), _mm256_set1_epi64x (blake2b_iv[5]), _mm256_set1_epi64x (~blake2b_iv[6]), _mm256_set1_epi64x (blake2b_iv[7])
+	};
+	WORK_ROUNDS
+	auto result (_mm256_xor_si256 (_mm256_set1_epi64x (work_h0), _mm256_xor_si256 (v[0], v[8])));
+	_mm256_storeu_si256 (reinterpret_cast<__m256i *> (values_a), result);
+#undef WORK_ADD
+#undef WORK_XOR
+#undef WORK_ROR32
+#undef WORK_ROR24
+#undef WORK_ROR16
+#undef WORK_ROR63
+}
+
+__attribute__ ((target ("avx512f"))) void work_values_avx512 (cga::uint256_union const * const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+#define WORK_ADD(a, b) _mm512_add_epi64 (a, b)
+#define WORK_XOR(a, b) _mm512_xor_si512 (a, b)
+#define WORK_ROR32(a) _mm512_ror_epi64 (a, 32)
+#define WORK_ROR24(a) _mm512_ror_epi64 (a, 24)
+#define WORK_ROR16(a) _mm512_ror_epi64 (a, 16)
+#define WORK_ROR63(a) _mm512_ror_epi64 (a, 63)
+	__m512i m[16];
+	m[0] = _mm512_loadu_si512 (nonces_a);
+	uint64_t words[4][8];
+	transpose_roots (roots_a, 8, words[0]);
+	for (auto i (0); i < 4; ++i)
+	{
+		m[i + 1] = _mm512_loadu_si512 (words[i]);
+	}
+	for (auto i (5); i < 16; ++i)
+	{
+		m[i] = _mm512_setzero_si512 ();
+	}
+	__m512i v[16] = {
+		_mm512_set1_epi64 (work_h0), _mm512_set1_epi64 (blake2b_iv[1]), _mm512_set1_epi64 (blake2b_iv[2]), _mm512_set1_epi64 (blake2b_iv[3]),
+		_mm512_set1_epi64 (blake2b_iv[4]), _mm512_set1_epi64 (blake2b_iv[5]), _mm512_set1_epi64 (blake2b_iv[6]), _mm512_set1_epi64 (blake2b_iv[7]),
+		_mm512_set1_epi64 (blake2b_iv[0]), _mm512_set1_epi64 (blake2b_iv[1]), _mm512_set1_epi64 (blake2b_iv[2]), _mm512_set1_epi64 (blake2b_iv[3]),
+		_mm512_set1_epi64 (blake2b_iv[4] ^ work_message_size), _mm512_set1_epi64 (blake2b_iv[5]), _mm512_set1_epi64 (~blake2b_iv[6]), _mm512_set1_epi64 (blake2b_iv[7])
+	};
+	WORK_ROUNDS
+	auto result (_mm512_xor_si512 (_mm512_set1_epi64 (work_h0), _mm512_xor_si512 (v[0], v[8])));
+	_mm512_storeu_si512 (values_a, result);
+#undef WORK_ADD
+#undef WORK_XOR
+#undef WORK_ROR32
+#undef WORK_ROR24
+#undef WORK_ROR16
+#undef WORK_ROR63
+}
+#endif
+
+#undef WORK_G
+#undef WORK_ROUNDS
+
+cga::work_kernel detect_best_kernel ()
+{
+	auto result (cga::work_kernel::scalar);
+	if (cga::work_kernel_supported (cga::work_kernel::avx512))
+	{
+		result = cga::work_kernel::avx512;
+	}
+	else if (cga::work_kernel_supported (cga::work_kernel::avx2))
+	{
+		result = cga::work_kernel::avx2;
+	}
+	return result;
+}
+}
+
+size_t cga::work_kernel_lanes (cga::work_kernel kernel_a)
+{
+	size_t result (1);
+	switch (kernel_a)
+	{
+		case cga::work_kernel::scalar:
+			result = 1;
+			break;
+		case cga::work_kernel::avx2:
+			result = 4;
+			break;
+		case cga::work_kernel::avx512:
+			result = 8;
+			break;
+	}
+	return result;
+}
+
+std::string cga::work_kernel_name (cga::work_kernel kernel_a)
+{
+	std::string result;
+	switch (kernel_a)
+	{
+		case cga::work_kernel::scalar:
+			result = "scalar";
+			break;
+		case cga::work_kernel::avx2:
+			result = "avx2";
+			break;
+		case cga::work_kernel::avx512:
+			result = "avx512";
+			break;
+	}
+	return result;
+}
+
+bool cga::work_kernel_supported (cga::work_kernel kernel_a)
+{
+	auto result (false);
+	switch (kernel_a)
+	{
+		case cga::work_kernel::scalar:
+			result = true;
+			break;
+		case cga::work_kernel::avx2:
+#if CGA_WORK_KERNEL_X86
+			result = __builtin_cpu_supports ("avx2");
+#endif
+			break;
+		case cga::work_kernel::avx512:
+#if CGA_WORK_KERNEL_X86
+			result = __builtin_cpu_supports ("avx512f");
+#endif
+			break;
+	}
+	return result;
+}
+
+cga::work_kernel cga::work_kernel_best ()
+{
+	static cga::work_kernel const result (detect_best_kernel ());
+	return result;
+}
+
+void cga::work_values (cga::work_kernel kernel_a, cga::uint256_union const & root_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	cga::uint256_union const * roots[work_kernel_max_lanes];
+	for (auto & root : roots)
+	{
+		root = &root_a;
+	}
+	work_values (kernel_a, roots, nonces_a, values_a);
+}
+
+void cga::work_values (cga::work_kernel kernel_a, cga::uint256_union const * const * roots_a, uint64_t const * nonces_a, uint64_t * values_a)
+{
+	assert (work_kernel_supported (kernel_a));
+	switch (kernel_a)
+	{
+		case cga::work_kernel::scalar:
+			work_values_scalar (roots_a, nonces_a, values_a);
+			break;
+		case cga::work_kernel::avx2:
+#if CGA_WORK_KERNEL_X86
+			work_values_avx2 (roots_a, nonces_a, values_a);
+#endif
+			break;
+		case cga::work_kernel::avx512:
+#if CGA_WORK_KERNEL_X86
+			work_values_avx512 (roots_a, nonces_a, values_a);
+#endif
+			break;
+	}
+}
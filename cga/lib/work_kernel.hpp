@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cga/lib/numbers.hpp>
+
+#include <string>
+
+namespace cga
+{
+/**
+ * Blake2b kernels specialised for proof of work, hashing an 8 byte nonce followed by a 32 byte root into an 8 byte digest.
+ * The whole message fits in a single compression so the generic blake2b_update/blake2b_final bookkeeping is skipped
+ * and the vector kernels evaluate one nonce per 64 bit lane.
+ */
+enum class work_kernel : uint8_t
+{
+	scalar,
+	avx2,
+	avx512
+};
+size_t constexpr work_kernel_max_lanes = 8;
+/** Number of nonces evaluated per call */
+size_t work_kernel_lanes (cga::work_kernel);
+std::string work_kernel_name (cga::work_kernel);
+/** True if both this build and the running CPU can execute the kernel */
+bool work_kernel_supported (cga::work_kernel);
+/** Widest supported kernel, detected once at first use */
+cga::work_kernel work_kernel_best ();
+/** Compute the work value of work_kernel_lanes (kernel) nonces against a root */
+void work_values (cga::work_kernel, cga::uint256_union const &, uint64_t const *, uint64_t *);
+/** Compute the work value of work_kernel_lanes (kernel) nonces, each lane hashed against its own root */
+void work_values (cga::work_kernel, cga::uint256_union const * const *, uint64_t const *, uint64_t *);
+}
@@ -5,13 +5,25 @@
 #include <cga/secure/blockstore.hpp>
 
 std::chrono::milliseconds constexpr cga::block_processor::confirmation_request_delay;
+size_t constexpr cga::block_processor::max_verified_blocks;
+size_t constexpr cga::block_processor::max_post_commit;
 
 cga::block_processor::block_processor (cga::node & node_a) :
 generator (node_a, cga::is_test_network ? std::chrono::milliseconds (10) : std::chrono::milliseconds (500)),
 stopped (false),
 active (false),
+verifying (false),
+committing (false),
 next_log (std::chrono::steady_clock::now ()),
-node (node_a)
+node (node_a),
+verification_thread ([this]() {
+	cga::thread_role::set (cga::thread_role::name::block_verification);
+	verification_loop ();
+}),
+post_commit_thread ([this]() {
+	cga::thread_role::set (cga::thread_role::name::block_post_commit);
+	post_commit_loop ();
+})
 {
 }
 
@@ -28,13 +40,21 @@ void cga::block_processor::stop ()
 		stopped = true;
 	}
 	condition.notify_all ();
+	if (verification_thread.joinable ())
+	{
+		verification_thread.join ();
+	}
+	if (post_commit_thread.joinable ())
+	{
+		post_commit_thread.join ();
+	}
 }
 
 void cga::block_processor::flush ()
 {
 	node.checker.flush ();
 	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && (have_blocks () || active))
+	while (!stopped && (have_blocks () || active || verifying || committing || !post_commit.empty ()))
 	{
 		condition.wait (lock);
 	}
@@ -47,6 +67,12 @@ bool cga::block_processor::full ()
 	return (blocks.size () + state_blocks.size ()) > full_size;
 }
 
+size_t cga::block_processor::size ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	return blocks.size () + state_blocks.size () + forced.size ();
+}
+
 void cga::block_processor::add (std::shared_ptr<cga::block> block_a, uint64_t origination)
 {
 	cga::unchecked_info info (block_a, 0, origination, cga::signature_verification::unknown);
@@ -57,6 +83,7 @@ void cga::block_processor::add (cga::unchecked_info const & info_a)
 {
 	if (!cga::work_validate (info_a.block->root (), info_a.block->block_work ()))
 	{
+		auto duplicate (false);
 		{
 			auto hash (info_a.block->hash ());
 			std::lock_guard<std::mutex> lock (mutex);
@@ -70,10 +97,22 @@ void cga::block_processor::add (cga::unchecked_info const & info_a)
 				{
 					blocks.push_back (info_a);
 				}
-				blocks_hashes.insert (hash);
+				blocks_hashes.emplace (hash, std::chrono::steady_clock::now ());
+				node.tracer.record (hash, cga::block_tracer::stage::block_processor_add);
+			}
+			else
+			{
+				duplicate = true;
 			}
 		}
-		condition.notify_all ();
+		if (!duplicate)
+		{
+			condition.notify_all ();
+		}
+		else
+		{
+			node.stats.inc (cga::stat::type::block_processor, cga::stat::detail::duplicate);
+		}
 	}
 	else
 	{
@@ -96,13 +135,15 @@ void cga::block_processor::process_blocks ()
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!stopped)
 	{
-		if (have_blocks ())
+		// Hold back while the post-commit stage catches up
+		if ((!blocks.empty () || !forced.empty ()) && post_commit.size () < max_post_commit)
 		{
 			active = true;
 			lock.unlock ();
 			process_batch (lock);
 			lock.lock ();
 			active = false;
+			condition.notify_all ();
 		}
 		else
 		{
@@ -130,19 +171,36 @@ bool cga::block_processor::have_blocks ()
 	return !blocks.empty () || !forced.empty () || !state_blocks.empty ();
 }
 
-void cga::block_processor::verify_state_blocks (cga::transaction const & transaction_a, std::unique_lock<std::mutex> & lock_a, size_t max_count)
+void cga::block_processor::verification_loop ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		// Hold back while the ledger stage catches up
+		if (!state_blocks.empty () && blocks.size () < max_verified_blocks)
+		{
+			verifying = true;
+			size_t max_verification_batch (node.flags.fast_bootstrap ? max_verified_blocks : 2048 * (node.config.signature_checker_threads + 1));
+			verify_state_blocks (lock, std::min (max_verification_batch, max_verified_blocks - blocks.size ()));
+			verifying = false;
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+}
+
+void cga::block_processor::verify_state_blocks (std::unique_lock<std::mutex> & lock_a, size_t max_count)
 {
 	assert (!mutex.try_lock ());
 	cga::timer<std::chrono::milliseconds> timer_l (cga::timer_state::started);
 	std::deque<cga::unchecked_info> items;
 	for (auto i (0); i < max_count && !state_blocks.empty (); i++)
 	{
-		auto item (state_blocks.front ());
+		items.push_back (state_blocks.front ());
 		state_blocks.pop_front ();
-		if (!node.ledger.store.block_exists (transaction_a, item.block->type (), item.block->hash ()))
-		{
-			items.push_back (item);
-		}
 	}
 	lock_a.unlock ();
 	if (!items.empty ())
@@ -168,6 +226,7 @@ void cga::block_processor::verify_state_blocks (cga::transaction const & transac
 		{
 			auto item (items[i]);
 			hashes.push_back (item.block->hash ());
+			node.tracer.record (hashes.back (), cga::block_tracer::stage::signature_batch);
 			messages.push_back (hashes.back ().bytes.data ());
 			lengths.push_back (sizeof (decltype (hashes)::value_type));
 			cga::account account (item.block->account ());
@@ -186,6 +245,15 @@ void cga::block_processor::verify_state_blocks (cga::transaction const & transac
 		}
 		cga::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signatures.data (), verifications.data () };
 		node.checker.verify (check);
+		if (node.tracer.enabled ())
+		{
+			auto now (std::chrono::steady_clock::now ());
+			for (auto & hash : hashes)
+			{
+				node.tracer.record (hash, cga::block_tracer::stage::verified, now);
+			}
+		}
+		size_t verified_count (0);
 		lock_a.lock ();
 		for (auto i (0); i < size; ++i)
 		{
@@ -205,136 +273,198 @@ void cga::block_processor::verify_state_blocks (cga::transaction const & transac
 					item.verified = cga::signature_verification::unknown;
 					blocks.push_back (item);
 				}
+				++verified_count;
 			}
 			else if (verifications[i] == 1)
 			{
 				// Non epoch blocks
 				item.verified = cga::signature_verification::valid;
 				blocks.push_back (item);
+				++verified_count;
+			}
+			else
+			{
+				blocks_hashes.erase (item.block->hash ());
 			}
 			items.pop_front ();
 		}
+		lock_a.unlock ();
+		condition.notify_all ();
+		node.stats.add (cga::stat::type::block_processor, cga::stat::detail::verified, cga::stat::dir::in, verified_count);
+		node.stats.add (cga::stat::type::block_processor, cga::stat::detail::bad_signature, cga::stat::dir::in, size - verified_count);
 		if (node.config.logging.timing_logging ())
 		{
 			BOOST_LOG (node.log) << boost::str (boost::format ("Batch verified %1% state blocks in %2% %3%") % size % timer_l.stop ().count () % timer_l.unit ());
 		}
 	}
-	else
-	{
-		lock_a.lock ();
-	}
+	lock_a.lock ();
 }
 
 void cga::block_processor::process_batch (std::unique_lock<std::mutex> & lock_a)
 {
 	cga::timer<std::chrono::milliseconds> timer_l;
-	lock_a.lock ();
-	timer_l.start ();
-	// Limit state blocks verification time
-	size_t max_verification_batch (node.flags.fast_bootstrap ? std::numeric_limits<size_t>::max () : 2048 * (node.config.signature_checker_threads + 1));
-	if (!state_blocks.empty ())
-	{
-		auto transaction (node.store.tx_begin_read ());
-		while (!state_blocks.empty () && timer_l.before_deadline (std::chrono::seconds (2)))
-		{
-			verify_state_blocks (transaction, lock_a, max_verification_batch);
-		}
-	}
-	lock_a.unlock ();
-	auto transaction (node.store.tx_begin_write ());
-	timer_l.restart ();
-	lock_a.lock ();
-	// Processing blocks
-	auto first_time (true);
+	std::deque<cga::post_commit_info> post_commit_l;
 	unsigned number_of_blocks_processed (0), number_of_forced_processed (0);
-	while ((!blocks.empty () || !forced.empty ()) && (timer_l.before_deadline (node.config.block_processor_batch_max_time) || (node.flags.fast_bootstrap && number_of_blocks_processed < 256 * 1024)))
-	{
-		auto log_this_record (false);
-		if (node.config.logging.timing_logging ())
+	// Queued with the other writers so the batch shares their commit, the lock is only taken and released on the writer thread
+	node.store.tx_queue_write ([this, &lock_a, &timer_l, &post_commit_l, &number_of_blocks_processed, &number_of_forced_processed](cga::transaction const & transaction) {
+		timer_l.start ();
+		lock_a.lock ();
+		// Processing blocks
+		auto first_time (true);
+		while (timer_l.before_deadline (node.config.block_processor_batch_max_time) || (node.flags.fast_bootstrap && number_of_blocks_processed < 256 * 1024))
 		{
-			if (should_log (first_time))
+			if (blocks.empty () && forced.empty ())
 			{
-				log_this_record = true;
+				/* Commit as soon as the queue runs dry rather than waiting on the verification stage with the write
+				 transaction open, other writers would be held off. A new batch starts when verified blocks arrive */
+				break;
 			}
-		}
-		else
-		{
-			if (((blocks.size () + state_blocks.size () + forced.size ()) > 64 && should_log (false)))
+			auto log_this_record (false);
+			if (node.config.logging.timing_logging ())
 			{
-				log_this_record = true;
+				if (should_log (first_time))
+				{
+					log_this_record = true;
+				}
+			}
+			else
+			{
+				if (((blocks.size () + state_blocks.size () + forced.size ()) > 64 && should_log (false)))
+				{
+					log_this_record = true;
+				}
 			}
-		}
 
-		if (log_this_record)
-		{
-			first_time = false;
-			BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks (+ %2% state blocks) (+ %3% forced) in processing queue") % blocks.size () % state_blocks.size () % forced.size ());
-		}
-		cga::unchecked_info info;
-		bool force (false);
-		if (forced.empty ())
-		{
-			info = blocks.front ();
-			blocks.pop_front ();
-			blocks_hashes.erase (info.block->hash ());
+			if (log_this_record)
+			{
+				first_time = false;
+				BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks (+ %2% state blocks) (+ %3% forced) in processing queue") % blocks.size () % state_blocks.size () % forced.size ());
+			}
+			cga::unchecked_info info;
+			bool force (false);
+			if (forced.empty ())
+			{
+				info = blocks.front ();
+				blocks.pop_front ();
+				auto existing (blocks_hashes.find (info.block->hash ()));
+				if (existing != blocks_hashes.end ())
+				{
+					node.stats.record (cga::stat::histogram::block_processor_queue, std::chrono::steady_clock::now () - existing->second);
+					blocks_hashes.erase (existing);
+				}
+			}
+			else
+			{
+				info = cga::unchecked_info (forced.front (), 0, cga::seconds_since_epoch (), cga::signature_verification::unknown);
+				forced.pop_front ();
+				force = true;
+				number_of_forced_processed++;
+			}
+			lock_a.unlock ();
+			// Room was made for the verification stage
+			condition.notify_all ();
+			auto hash (info.block->hash ());
+			if (force)
+			{
+				auto successor (node.ledger.successor (transaction, cga::uint512_union (info.block->previous (), info.block->root ())));
+				if (successor != nullptr && successor->hash () != hash)
+				{
+					// Replace our block with the winner and roll back any dependent blocks
+					BOOST_LOG (node.log) << boost::str (boost::format ("Rolling back %1% and replacing with %2%") % successor->hash ().to_string () % hash.to_string ());
+					std::vector<cga::block_hash> rollback_list;
+					if (node.ledger.rollback (transaction, successor->hash (), rollback_list))
+					{
+						// The winner will be rejected as a fork below
+						BOOST_LOG (node.log) << boost::str (boost::format ("Failed to roll back %1% because it or a successor was cemented") % successor->hash ().to_string ());
+					}
+					BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks rolled back") % rollback_list.size ());
+					lock_a.lock ();
+					// Prevent rolled back blocks second insertion
+					auto inserted (rolled_back.insert (cga::rolled_hash{ std::chrono::steady_clock::now (), successor->hash () }));
+					if (inserted.second)
+					{
+						// Possible election winner change
+						rolled_back.get<1> ().erase (hash);
+						// Prevent overflow
+						if (rolled_back.size () > rolled_back_max)
+						{
+							rolled_back.erase (rolled_back.begin ());
+						}
+					}
+					lock_a.unlock ();
+					// Deleting from votes cache
+					for (auto & i : rollback_list)
+					{
+						node.votes_cache.remove (i);
+					}
+				}
+			}
+			number_of_blocks_processed++;
+			auto process_result (process_one (transaction, info, post_commit_l));
+			(void)process_result;
+			lock_a.lock ();
 		}
-		else
+		lock_a.unlock ();
+	})
+	.get ();
+	node.stats.add (cga::stat::type::block_processor, cga::stat::detail::processed, cga::stat::dir::in, number_of_blocks_processed);
+	// Write transaction is committed, hand the remaining work to the post-commit stage
+	enqueue_post_commit (post_commit_l);
+
+	if (node.config.logging.timing_logging ())
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("Processed %1% blocks (%2% blocks were forced) in %3% %4%") % number_of_blocks_processed % number_of_forced_processed % timer_l.stop ().count () % timer_l.unit ());
+	}
+}
+
+void cga::block_processor::enqueue_post_commit (std::deque<cga::post_commit_info> & items_a)
+{
+	if (!items_a.empty ())
+	{
 		{
-			info = cga::unchecked_info (forced.front (), 0, cga::seconds_since_epoch (), cga::signature_verification::unknown);
-			forced.pop_front ();
-			force = true;
-			number_of_forced_processed++;
+			std::lock_guard<std::mutex> lock (mutex);
+			committing = true;
+			post_commit.insert (post_commit.end (), std::make_move_iterator (items_a.begin ()), std::make_move_iterator (items_a.end ()));
 		}
-		lock_a.unlock ();
-		auto hash (info.block->hash ());
-		if (force)
+		condition.notify_all ();
+	}
+}
+
+void cga::block_processor::post_commit_loop ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!post_commit.empty ())
 		{
-			auto successor (node.ledger.successor (transaction, cga::uint512_union (info.block->previous (), info.block->root ())));
-			if (successor != nullptr && successor->hash () != hash)
-			{
-				// Replace our block with the winner and roll back any dependent blocks
-				BOOST_LOG (node.log) << boost::str (boost::format ("Rolling back %1% and replacing with %2%") % successor->hash ().to_string () % hash.to_string ());
-				std::vector<cga::block_hash> rollback_list;
-				node.ledger.rollback (transaction, successor->hash (), rollback_list);
-				BOOST_LOG (node.log) << boost::str (boost::format ("%1% blocks rolled back") % rollback_list.size ());
-				lock_a.lock ();
-				// Prevent rolled back blocks second insertion
-				auto inserted (rolled_back.insert (cga::rolled_hash{ std::chrono::steady_clock::now (), successor->hash () }));
-				if (inserted.second)
+			std::deque<cga::post_commit_info> items;
+			items.swap (post_commit);
+			committing = true;
+			lock.unlock ();
+			// Room was made for the ledger stage
+			condition.notify_all ();
+			for (auto & item : items)
+			{
+				node.tracer.record (item.block->hash (), cga::block_tracer::stage::post_commit);
+				if (item.live)
 				{
-					// Possible election winner change
-					rolled_back.get<1> ().erase (hash);
-					// Prevent overflow
-					if (rolled_back.size () > rolled_back_max)
-					{
-						rolled_back.erase (rolled_back.begin ());
-					}
+					process_live (item.block->hash (), item.block);
 				}
-				lock_a.unlock ();
-				// Deleting from votes cache
-				for (auto & i : rollback_list)
+				for (auto & dependent : item.dependents)
 				{
-					node.votes_cache.remove (i);
+					add (dependent);
 				}
 			}
+			node.stats.add (cga::stat::type::block_processor, cga::stat::detail::post_commit, cga::stat::dir::in, items.size ());
+			lock.lock ();
+			committing = !post_commit.empty ();
+			condition.notify_all ();
 		}
-		number_of_blocks_processed++;
-		auto process_result (process_one (transaction, info));
-		(void)process_result;
-		lock_a.lock ();
-		/* Verify more state blocks if blocks deque is empty
-		 Because verification is long process, avoid large deque verification inside of write transaction */
-		if (blocks.empty () && !state_blocks.empty ())
+		else
 		{
-			verify_state_blocks (transaction, lock_a, 256 * (node.config.signature_checker_threads + 1));
+			condition.wait (lock);
 		}
 	}
-	lock_a.unlock ();
-
-	if (node.config.logging.timing_logging ())
-	{
-		BOOST_LOG (node.log) << boost::str (boost::format ("Processed %1% blocks (%2% blocks were forced) in %3% %4%") % number_of_blocks_processed % number_of_forced_processed % timer_l.stop ().count () % timer_l.unit ());
-	}
 }
 
 void cga::block_processor::process_live (cga::block_hash const & hash_a, std::shared_ptr<cga::block> block_a)
@@ -355,10 +485,11 @@ void cga::block_processor::process_live (cga::block_hash const & hash_a, std::sh
 		{
 			// Check if votes were already requested
 			bool send_request (false);
+			auto existing (node_l->active.election (block_a->hash ()));
+			if (existing != nullptr)
 			{
-				std::lock_guard<std::mutex> lock (node_l->active.mutex);
-				auto existing (node_l->active.blocks.find (block_a->hash ()));
-				if (existing != node_l->active.blocks.end () && !existing->second->confirmed && !existing->second->stopped && existing->second->announcements == 0)
+				std::lock_guard<std::mutex> lock (node_l->active.partition_for (existing->root).mutex);
+				if (!existing->confirmed && !existing->stopped && existing->announcements == 0)
 				{
 					send_request = true;
 				}
@@ -372,10 +503,11 @@ void cga::block_processor::process_live (cga::block_hash const & hash_a, std::sh
 	});
 }
 
-cga::process_return cga::block_processor::process_one (cga::transaction const & transaction_a, cga::unchecked_info info_a)
+cga::process_return cga::block_processor::process_one (cga::transaction const & transaction_a, cga::unchecked_info info_a, std::deque<cga::post_commit_info> & post_commit_a)
 {
 	cga::process_return result;
 	auto hash (info_a.block->hash ());
+	node.tracer.record (hash, cga::block_tracer::stage::process_one);
 	result = node.ledger.process (transaction_a, *(info_a.block), info_a.verified);
 	switch (result.code)
 	{
@@ -388,11 +520,9 @@ cga::process_return cga::block_processor::process_one (cga::transaction const &
 				info_a.block->serialize_json (block);
 				BOOST_LOG (node.log) << boost::str (boost::format ("Processing block %1%: %2%") % hash.to_string () % block);
 			}
-			if (info_a.modified > cga::seconds_since_epoch () - 300 && node.block_arrival.recent (hash))
-			{
-				process_live (hash, info_a.block);
-			}
-			queue_unchecked (transaction_a, hash);
+			cga::post_commit_info post_commit_l{ info_a.block, info_a.modified > cga::seconds_since_epoch () - 300 && node.block_arrival.recent (hash) };
+			queue_unchecked (transaction_a, hash, post_commit_l.dependents);
+			post_commit_a.push_back (std::move (post_commit_l));
 			break;
 		}
 		case cga::process_result::gap_previous:
@@ -433,7 +563,12 @@ cga::process_return cga::block_processor::process_one (cga::transaction const &
 			}
 			if (!node.flags.fast_bootstrap)
 			{
-				queue_unchecked (transaction_a, hash);
+				cga::post_commit_info post_commit_l{ info_a.block, false };
+				queue_unchecked (transaction_a, hash, post_commit_l.dependents);
+				if (!post_commit_l.dependents.empty ())
+				{
+					post_commit_a.push_back (std::move (post_commit_l));
+				}
 			}
 			node.active.update_difficulty (*(info_a.block));
 			break;
@@ -509,14 +644,14 @@ cga::process_return cga::block_processor::process_one (cga::transaction const &
 	return result;
 }
 
-cga::process_return cga::block_processor::process_one (cga::transaction const & transaction_a, std::shared_ptr<cga::block> block_a)
+cga::process_return cga::block_processor::process_one (cga::transaction const & transaction_a, std::shared_ptr<cga::block> block_a, std::deque<cga::post_commit_info> & post_commit_a)
 {
 	cga::unchecked_info info (block_a, block_a->account (), 0, cga::signature_verification::unknown);
-	auto result (process_one (transaction_a, info));
+	auto result (process_one (transaction_a, info, post_commit_a));
 	return result;
 }
 
-void cga::block_processor::queue_unchecked (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
+void cga::block_processor::queue_unchecked (cga::transaction const & transaction_a, cga::block_hash const & hash_a, std::vector<cga::unchecked_info> & dependents_a)
 {
 	auto unchecked_blocks (node.store.unchecked_get (transaction_a, hash_a));
 	for (auto & info : unchecked_blocks)
@@ -525,7 +660,7 @@ void cga::block_processor::queue_unchecked (cga::transaction const & transaction
 		{
 			node.store.unchecked_del (transaction_a, cga::unchecked_key (hash_a, info.block->hash ()));
 		}
-		add (info);
+		dependents_a.push_back (info);
 	}
 	std::lock_guard<std::mutex> lock (node.gap_cache.mutex);
 	node.gap_cache.blocks.get<1> ().erase (hash_a);
@@ -5,11 +5,14 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/random_access_index.hpp>
 #include <boost/multi_index_container.hpp>
+#include <boost/thread/thread.hpp>
 #include <chrono>
+#include <deque>
 #include <memory>
 #include <cga/lib/blocks.hpp>
 #include <cga/node/voting.hpp>
 #include <cga/secure/common.hpp>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace cga
@@ -23,9 +26,24 @@ public:
 	std::chrono::steady_clock::time_point time;
 	cga::block_hash hash;
 };
+/**
+ * Work left over after a block was written to the ledger, run once the write transaction is committed
+ */
+class post_commit_info
+{
+public:
+	std::shared_ptr<cga::block> block;
+	// Block arrived recently and should be started as an election and republished
+	bool live;
+	// Blocks from the unchecked table which depended on this block
+	std::vector<cga::unchecked_info> dependents;
+};
 /**
  * Processing blocks is a potentially long IO operation.
  * This class isolates block insertion from other operations like servicing network operations
+ * Blocks move through a pipeline of stages, each on its own thread and separated by bounded queues:
+ * add () deduplicates and checks work, the verification stage batches state block signatures through the signature checker,
+ * the ledger stage is the single writer and the post-commit stage runs observers, elections and unchecked dependents
  */
 class block_processor
 {
@@ -35,30 +53,47 @@ public:
 	void stop ();
 	void flush ();
 	bool full ();
+	// Number of blocks queued ahead of the ledger stage
+	size_t size ();
 	void add (cga::unchecked_info const &);
 	void add (std::shared_ptr<cga::block>, uint64_t = 0);
 	void force (std::shared_ptr<cga::block>);
 	bool should_log (bool);
 	bool have_blocks ();
 	void process_blocks ();
-	cga::process_return process_one (cga::transaction const &, cga::unchecked_info);
-	cga::process_return process_one (cga::transaction const &, std::shared_ptr<cga::block>);
+	/**
+	 * Work left for after the write transaction is appended to the post-commit deque,
+	 * callers pass it to enqueue_post_commit once the transaction has been committed
+	 */
+	cga::process_return process_one (cga::transaction const &, cga::unchecked_info, std::deque<cga::post_commit_info> &);
+	cga::process_return process_one (cga::transaction const &, std::shared_ptr<cga::block>, std::deque<cga::post_commit_info> &);
+	void enqueue_post_commit (std::deque<cga::post_commit_info> &);
 	cga::vote_generator generator;
 	// Delay required for average network propagartion before requesting confirmation
 	static std::chrono::milliseconds constexpr confirmation_request_delay{ 1500 };
+	// Verified blocks waiting for the ledger stage before the verification stage pauses
+	static size_t constexpr max_verified_blocks{ 65536 };
+	// Committed blocks waiting for the post-commit stage before the ledger stage pauses
+	static size_t constexpr max_post_commit{ 65536 };
 
 private:
-	void queue_unchecked (cga::transaction const &, cga::block_hash const &);
-	void verify_state_blocks (cga::transaction const & transaction_a, std::unique_lock<std::mutex> &, size_t = std::numeric_limits<size_t>::max ());
+	void queue_unchecked (cga::transaction const &, cga::block_hash const &, std::vector<cga::unchecked_info> &);
+	void verification_loop ();
+	void verify_state_blocks (std::unique_lock<std::mutex> &, size_t = std::numeric_limits<size_t>::max ());
 	void process_batch (std::unique_lock<std::mutex> &);
+	void post_commit_loop ();
 	void process_live (cga::block_hash const &, std::shared_ptr<cga::block>);
 	bool stopped;
 	bool active;
+	bool verifying;
+	bool committing;
 	std::chrono::steady_clock::time_point next_log;
 	std::deque<cga::unchecked_info> state_blocks;
 	std::deque<cga::unchecked_info> blocks;
-	std::unordered_set<cga::block_hash> blocks_hashes;
+	// Queued blocks and when they were added, used to drop duplicates and time the queue
+	std::unordered_map<cga::block_hash, std::chrono::steady_clock::time_point> blocks_hashes;
 	std::deque<std::shared_ptr<cga::block>> forced;
+	std::deque<cga::post_commit_info> post_commit;
 	boost::multi_index_container<
 	cga::rolled_hash,
 	boost::multi_index::indexed_by<
@@ -69,6 +104,8 @@ private:
 	std::condition_variable condition;
 	cga::node & node;
 	std::mutex mutex;
+	boost::thread verification_thread;
+	boost::thread post_commit_thread;
 
 	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (block_processor & block_processor, const std::string & name);
 };
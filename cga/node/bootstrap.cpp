@@ -17,6 +17,7 @@ constexpr unsigned bootstrap_max_new_connections = 10;
 constexpr unsigned bulk_push_cost_limit = 200;
 
 size_t constexpr cga::frontier_req_client::size_frontier;
+size_t constexpr cga::bulk_pull_client::work_batch_size;
 
 cga::socket::socket (std::shared_ptr<cga::node> node_a) :
 socket_m (node_a->io_ctx),
@@ -502,6 +503,7 @@ void cga::bulk_pull_client::receive_block ()
 		}
 		else
 		{
+			this_l->process_pending ();
 			if (this_l->connection->node->config.logging.bulk_pull_logging ())
 			{
 				BOOST_LOG (this_l->connection->node->log) << boost::str (boost::format ("Error receiving block type: %1%") % ec.message ());
@@ -554,7 +556,7 @@ void cga::bulk_pull_client::received_type ()
 		case cga::block_type::not_a_block:
 		{
 			// Avoid re-using slow peers, or peers that sent the wrong blocks.
-			if (!connection->pending_stop && expected == pull.end)
+			if (process_pending () && !connection->pending_stop && expected == pull.end)
 			{
 				connection->attempt->pool_connection (connection);
 			}
@@ -562,6 +564,7 @@ void cga::bulk_pull_client::received_type ()
 		}
 		default:
 		{
+			process_pending ();
 			if (connection->node->config.logging.network_packet_logging ())
 			{
 				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Unknown type received as block type: %1%") % static_cast<int> (type));
@@ -577,59 +580,17 @@ void cga::bulk_pull_client::received_block (boost::system::error_code const & ec
 	{
 		cga::bufferstream stream (connection->receive_buffer->data (), size_a);
 		std::shared_ptr<cga::block> block (cga::deserialize_block (stream, type_a));
-		if (block != nullptr && !cga::work_validate (*block))
+		if (block != nullptr)
 		{
-			auto hash (block->hash ());
-			if (connection->node->config.logging.bulk_pull_logging ())
-			{
-				std::string block_l;
-				block->serialize_json (block_l);
-				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
-			}
-			// Is block expected?
-			bool block_expected (false);
-			if (hash == expected)
-			{
-				expected = block->previous ();
-				block_expected = true;
-			}
-			else
-			{
-				unexpected_count++;
-			}
-			if (total_blocks == 0 && block_expected)
-			{
-				known_account = block->account ();
-			}
-			if (connection->block_count++ == 0)
+			pending.push_back (block);
+			if (pending.size () < work_batch_size || process_pending ())
 			{
-				connection->start_time = std::chrono::steady_clock::now ();
-			}
-			connection->attempt->total_blocks++;
-			total_blocks++;
-			bool stop_pull (connection->attempt->process_block (block, known_account, total_blocks, block_expected));
-			if (!stop_pull && !connection->hard_stop.load ())
-			{
-				/* Process block in lazy pull if not stopped
-				Stop usual pull request with unexpected block & more than 16k blocks processed
-				to prevent spam */
-				if (connection->attempt->mode != cga::bootstrap_mode::legacy || unexpected_count < 16384)
-				{
-					receive_block ();
-				}
-			}
-			else if (stop_pull && block_expected)
-			{
-				expected = pull.end;
-				connection->attempt->pool_connection (connection);
-			}
-			if (stop_pull)
-			{
-				connection->attempt->lazy_stopped++;
+				receive_block ();
 			}
 		}
 		else
 		{
+			process_pending ();
 			if (connection->node->config.logging.bulk_pull_logging ())
 			{
 				BOOST_LOG (connection->node->log) << "Error deserializing block received from pull request";
@@ -638,6 +599,7 @@ void cga::bulk_pull_client::received_block (boost::system::error_code const & ec
 	}
 	else
 	{
+		process_pending ();
 		if (connection->node->config.logging.bulk_pull_logging ())
 		{
 			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Error bulk receiving block: %1%") % ec.message ());
@@ -645,6 +607,94 @@ void cga::bulk_pull_client::received_block (boost::system::error_code const & ec
 	}
 }
 
+bool cga::bulk_pull_client::process_pending ()
+{
+	std::vector<cga::block_hash> roots;
+	std::vector<uint64_t> works;
+	roots.reserve (pending.size ());
+	works.reserve (pending.size ());
+	for (auto & block : pending)
+	{
+		roots.push_back (block->root ());
+		works.push_back (block->block_work ());
+	}
+	std::vector<int> valid (pending.size ());
+	cga::work_validate_batch (roots.data (), works.data (), pending.size (), valid.data ());
+	auto result (true);
+	for (size_t i (0); i < pending.size () && result; ++i)
+	{
+		if (valid[i] == 1)
+		{
+			result = process_block (pending[i]);
+		}
+		else
+		{
+			connection->node->stats.inc_detail_only (cga::stat::type::error, cga::stat::detail::insufficient_work);
+			if (connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Insufficient work for block %1% received from pull request") % pending[i]->hash ().to_string ());
+			}
+			result = false;
+		}
+	}
+	pending.clear ();
+	return result;
+}
+
+bool cga::bulk_pull_client::process_block (std::shared_ptr<cga::block> block_a)
+{
+	auto result (false);
+	auto hash (block_a->hash ());
+	if (connection->node->config.logging.bulk_pull_logging ())
+	{
+		std::string block_l;
+		block_a->serialize_json (block_l);
+		BOOST_LOG (connection->node->log) << boost::str (boost::format ("Pulled block %1% %2%") % hash.to_string () % block_l);
+	}
+	// Is block expected?
+	bool block_expected (false);
+	if (hash == expected)
+	{
+		expected = block_a->previous ();
+		block_expected = true;
+	}
+	else
+	{
+		unexpected_count++;
+	}
+	if (total_blocks == 0 && block_expected)
+	{
+		known_account = block_a->account ();
+	}
+	if (connection->block_count++ == 0)
+	{
+		connection->start_time = std::chrono::steady_clock::now ();
+	}
+	connection->attempt->total_blocks++;
+	total_blocks++;
+	bool stop_pull (connection->attempt->process_block (block_a, known_account, total_blocks, block_expected));
+	if (!stop_pull && !connection->hard_stop.load ())
+	{
+		/* Process block in lazy pull if not stopped
+		Stop usual pull request with unexpected block & more than 16k blocks processed
+		to prevent spam */
+		if (connection->attempt->mode != cga::bootstrap_mode::legacy || unexpected_count < 16384)
+		{
+			result = true;
+		}
+	}
+	else if (stop_pull && block_expected)
+	{
+		expected = pull.end;
+		connection->attempt->pool_connection (connection);
+	}
+	if (stop_pull)
+	{
+		connection->attempt->lazy_stopped++;
+	}
+	return result;
+}
+
 cga::bulk_push_client::bulk_push_client (std::shared_ptr<cga::bootstrap_client> const & connection_a) :
 connection (connection_a)
 {
@@ -2360,6 +2410,7 @@ void cga::bootstrap_server::run_next ()
 void cga::bulk_pull_server::set_current_end ()
 {
 	include_start = false;
+	pruned_reached = false;
 	assert (request != nullptr);
 	auto transaction (connection->node->store.tx_begin_read ());
 	if (!connection->node->store.block_exists (transaction, request->end))
@@ -2411,6 +2462,22 @@ void cga::bulk_pull_server::set_current_end ()
 		}
 	}
 
+	// A pruned chain can only be served down to its oldest retained block, sending a partial range would look like a complete pull.
+	// Pulls down to a retained end block are checked as they walk, pruning can leave retained blocks below pruned ones
+	if (current != request->end && request->end.is_zero ())
+	{
+		cga::account_info info;
+		if (!connection->node->store.account_get (transaction, connection->node->ledger.account (transaction, current), info) && connection->node->store.pruned_exists (transaction, info.open_block))
+		{
+			if (connection->node->config.logging.bulk_pull_logging ())
+			{
+				BOOST_LOG (connection->node->log) << boost::str (boost::format ("Refusing bulk pull reaching pruned blocks: %1%") % current.to_string ());
+			}
+			current = request->end;
+			include_start = false;
+		}
+	}
+
 	sent_count = 0;
 	if (request->is_count_present ())
 	{
@@ -2424,32 +2491,36 @@ void cga::bulk_pull_server::set_current_end ()
 
 void cga::bulk_pull_server::send_next ()
 {
-	auto block (get_next ());
-	if (block != nullptr)
+	auto hash (get_next ());
+	if (!hash.is_zero ())
 	{
-		{
-			send_buffer->clear ();
-			cga::vectorstream stream (*send_buffer);
-			cga::serialize_block (stream, *block);
-		}
 		auto this_l (shared_from_this ());
 		if (connection->node->config.logging.bulk_pull_logging ())
 		{
-			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % block->hash ().to_string ());
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Sending block: %1%") % hash.to_string ());
 		}
 		connection->socket->async_write (send_buffer, [this_l](boost::system::error_code const & ec, size_t size_a) {
 			this_l->sent_action (ec, size_a);
 		});
 	}
+	else if (pruned_reached)
+	{
+		// Closed without the terminating not_a_block so the client treats the pull as failed and retries it elsewhere
+		if (connection->node->config.logging.bulk_pull_logging ())
+		{
+			BOOST_LOG (connection->node->log) << boost::str (boost::format ("Bulk pull reached pruned blocks before %1%") % request->end.to_string ());
+		}
+		connection->socket->close ();
+	}
 	else
 	{
 		send_finished ();
 	}
 }
 
-std::shared_ptr<cga::block> cga::bulk_pull_server::get_next ()
+cga::block_hash cga::bulk_pull_server::get_next ()
 {
-	std::shared_ptr<cga::block> result;
+	cga::block_hash result (0);
 	bool send_current = false, set_current_to_end = false;
 
 	/*
@@ -2489,10 +2560,19 @@ std::shared_ptr<cga::block> cga::bulk_pull_server::get_next ()
 	if (send_current)
 	{
 		auto transaction (connection->node->store.tx_begin_read ());
-		result = connection->node->store.block_get (transaction, current);
-		if (result != nullptr && set_current_to_end == false)
+		cga::block_view block;
+		auto error (connection->node->store.block_view_get (transaction, current, block));
+		if (!error)
+		{
+			// Copied straight from the database, the view is only valid inside this transaction
+			send_buffer->clear ();
+			cga::vectorstream stream (*send_buffer);
+			block.serialize (stream);
+			result = current;
+		}
+		if (!error && set_current_to_end == false)
 		{
-			auto previous (result->previous ());
+			auto previous (block.previous ());
 			if (!previous.is_zero ())
 			{
 				current = previous;
@@ -2504,6 +2584,7 @@ std::shared_ptr<cga::block> cga::bulk_pull_server::get_next ()
 		}
 		else
 		{
+			pruned_reached = error && connection->node->store.pruned_exists (transaction, current);
 			current = request->end;
 		}
 
@@ -167,6 +167,9 @@ public:
 	void receive_block ();
 	void received_type ();
 	void received_block (boost::system::error_code const &, size_t, cga::block_type);
+	// Validate work for all pending blocks in one batch and process them in order, returns true if the pull should keep reading
+	bool process_pending ();
+	bool process_block (std::shared_ptr<cga::block>);
 	cga::block_hash first ();
 	std::shared_ptr<cga::bootstrap_client> connection;
 	cga::block_hash expected;
@@ -174,6 +177,9 @@ public:
 	cga::pull_info pull;
 	uint64_t total_blocks;
 	uint64_t unexpected_count;
+	// Blocks read from the stream whose work has not been validated yet
+	std::vector<std::shared_ptr<cga::block>> pending;
+	static size_t constexpr work_batch_size = 64;
 };
 class bootstrap_client : public std::enable_shared_from_this<bootstrap_client>
 {
@@ -300,7 +306,8 @@ class bulk_pull_server : public std::enable_shared_from_this<cga::bulk_pull_serv
 public:
 	bulk_pull_server (std::shared_ptr<cga::bootstrap_server> const &, std::unique_ptr<cga::bulk_pull>);
 	void set_current_end ();
-	std::shared_ptr<cga::block> get_next ();
+	// Serializes the next block into send_buffer and returns its hash, zero once there are no more to send
+	cga::block_hash get_next ();
 	void send_next ();
 	void sent_action (boost::system::error_code const &, size_t);
 	void send_finished ();
@@ -312,6 +319,8 @@ public:
 	bool include_start;
 	cga::bulk_pull::count_t max_count;
 	cga::bulk_pull::count_t sent_count;
+	// Set when the walk reaches a pruned block before the requested end
+	bool pruned_reached;
 };
 class bulk_pull_account;
 class bulk_pull_account_server : public std::enable_shared_from_this<cga::bulk_pull_account_server>
@@ -73,6 +73,22 @@ header (header_a)
 {
 }
 
+cga::wire_message::wire_message (cga::message const & message_a)
+{
+	cga::vectorstream stream (bytes);
+	message_a.serialize (stream);
+}
+
+uint8_t const * cga::wire_message::data () const
+{
+	return bytes.data ();
+}
+
+size_t cga::wire_message::size () const
+{
+	return bytes.size ();
+}
+
 cga::block_type cga::message_header::block_type () const
 {
 	return static_cast<cga::block_type> (((extensions & block_type_mask) >> 8).to_ullong ());
@@ -195,11 +211,12 @@ std::string cga::message_parser::status_string ()
 	return "[unknown parse_status]";
 }
 
-cga::message_parser::message_parser (cga::block_uniquer & block_uniquer_a, cga::vote_uniquer & vote_uniquer_a, cga::message_visitor & visitor_a, cga::work_pool & pool_a) :
+cga::message_parser::message_parser (cga::block_uniquer & block_uniquer_a, cga::vote_uniquer & vote_uniquer_a, cga::message_visitor & visitor_a, cga::work_pool & pool_a, bool validate_work_a) :
 block_uniquer (block_uniquer_a),
 vote_uniquer (vote_uniquer_a),
 visitor (visitor_a),
 pool (pool_a),
+validate_work (validate_work_a),
 status (parse_status::success)
 {
 }
@@ -295,7 +312,7 @@ void cga::message_parser::deserialize_publish (cga::stream & stream_a, cga::mess
 	cga::publish incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		if (!cga::work_validate (*incoming.block))
+		if (!validate_work || !cga::work_validate (*incoming.block))
 		{
 			visitor.publish (incoming);
 		}
@@ -316,7 +333,7 @@ void cga::message_parser::deserialize_confirm_req (cga::stream & stream_a, cga::
 	cga::confirm_req incoming (error, stream_a, header_a, &block_uniquer);
 	if (!error && at_end (stream_a))
 	{
-		if (incoming.block == nullptr || !cga::work_validate (*incoming.block))
+		if (!validate_work || incoming.block == nullptr || !cga::work_validate (*incoming.block))
 		{
 			visitor.confirm_req (incoming);
 		}
@@ -339,7 +356,7 @@ void cga::message_parser::deserialize_confirm_ack (cga::stream & stream_a, cga::
 	{
 		for (auto & vote_block : incoming.vote->blocks)
 		{
-			if (!vote_block.which ())
+			if (validate_work && !vote_block.which ())
 			{
 				auto block (boost::get<std::shared_ptr<cga::block>> (vote_block));
 				if (cga::work_validate (*block))
@@ -235,6 +235,19 @@ public:
 	}
 	cga::message_header header;
 };
+/**
+ * Serialized form of a message, built once and shared read-only by every peer it is sent to
+ */
+class wire_message
+{
+public:
+	explicit wire_message (cga::message const &);
+	uint8_t const * data () const;
+	size_t size () const;
+
+private:
+	std::vector<uint8_t> bytes;
+};
 class work_pool;
 class message_parser
 {
@@ -254,7 +267,8 @@ public:
 		invalid_magic,
 		invalid_network
 	};
-	message_parser (cga::block_uniquer &, cga::vote_uniquer &, cga::message_visitor &, cga::work_pool &);
+	// When validate_work is false, proof of work on contained blocks is left for the caller to check, e.g. in batches
+	message_parser (cga::block_uniquer &, cga::vote_uniquer &, cga::message_visitor &, cga::work_pool &, bool = true);
 	void deserialize_buffer (uint8_t const *, size_t);
 	void deserialize_keepalive (cga::stream &, cga::message_header const &);
 	void deserialize_publish (cga::stream &, cga::message_header const &);
@@ -266,6 +280,7 @@ public:
 	cga::vote_uniquer & vote_uniquer;
 	cga::message_visitor & visitor;
 	cga::work_pool & pool;
+	bool validate_work;
 	parse_status status;
 	std::string status_string ();
 	static const size_t max_safe_udp_message_size;
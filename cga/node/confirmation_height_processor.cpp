@@ -0,0 +1,227 @@
+#include <cga/node/confirmation_height_processor.hpp>
+
+#include <cga/node/node.hpp>
+
+size_t constexpr cga::confirmation_height_processor::batch_write_size;
+
+cga::confirmation_height_processor::confirmation_height_processor (cga::node & node_a) :
+node (node_a),
+active (false),
+stopped (false),
+thread ([this]() {
+	cga::thread_role::set (cga::thread_role::name::confirmation_height_processing);
+	run ();
+})
+{
+}
+
+cga::confirmation_height_processor::~confirmation_height_processor ()
+{
+	stop ();
+}
+
+void cga::confirmation_height_processor::add (cga::block_hash const & hash_a)
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		hashes.push_back (hash_a);
+	}
+	condition.notify_all ();
+}
+
+void cga::confirmation_height_processor::stop ()
+{
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
+}
+
+void cga::confirmation_height_processor::flush ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped && (!hashes.empty () || active))
+	{
+		condition.wait (lock);
+	}
+}
+
+void cga::confirmation_height_processor::run ()
+{
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped)
+	{
+		if (!hashes.empty ())
+		{
+			auto hash (hashes.front ());
+			hashes.pop_front ();
+			active = true;
+			lock.unlock ();
+			process (hash);
+			lock.lock ();
+			// Keep accumulating while confirmations are arriving, unless the batch is full
+			if (hashes.empty () || pending_writes.size () >= batch_write_size)
+			{
+				lock.unlock ();
+				write_pending ();
+				lock.lock ();
+			}
+			active = false;
+			condition.notify_all ();
+		}
+		else
+		{
+			condition.wait (lock);
+		}
+	}
+	lock.unlock ();
+	write_pending ();
+}
+
+void cga::confirmation_height_processor::process (cga::block_hash const & hash_a)
+{
+	auto transaction (node.store.tx_begin_read ());
+	// A first confirmation on an upgraded ledger walks every chain from height 0, long walks are split into batches
+	// so the read transaction isn't held for the whole walk and pending writes stay bounded
+	size_t walked (0);
+	auto checkpoint = [this, &transaction, &walked]() {
+		if (++walked >= batch_write_size || pending_writes.size () >= batch_write_size)
+		{
+			walked = 0;
+			transaction.impl.reset ();
+			write_pending ();
+			transaction = node.store.tx_begin_read ();
+		}
+	};
+	std::vector<cga::block_hash> stack;
+	stack.push_back (hash_a);
+	while (!stack.empty ())
+	{
+		checkpoint ();
+		auto current (stack.back ());
+		cga::block_sideband sideband;
+		auto block (node.store.block_get (transaction, current, &sideband));
+		if (block == nullptr || sideband.height == 0)
+		{
+			// Rolled back since being confirmed, or heights aren't known until the sideband upgrade completes
+			node.stats.inc (cga::stat::type::confirmation_height, cga::stat::detail::invalid_block);
+			stack.clear ();
+		}
+		else
+		{
+			auto account (sideband.account);
+			auto confirmed_height (confirmation_height (transaction, account));
+			auto sources_pending (false);
+			if (sideband.height > confirmed_height)
+			{
+				// Every receive above the current confirmation height needs its source cemented first
+				auto height (sideband.height);
+				auto walk (block);
+				while (walk != nullptr && height > confirmed_height)
+				{
+					auto source (node.ledger.block_source (transaction, *walk));
+					if (!source.is_zero () && !node.ledger.is_epoch_link (source))
+					{
+						cga::block_sideband source_sideband;
+						if (node.store.block_get (transaction, source, &source_sideband) != nullptr && source_sideband.height > confirmation_height (transaction, source_sideband.account))
+						{
+							stack.push_back (source);
+							sources_pending = true;
+						}
+					}
+					--height;
+					if (height > confirmed_height)
+					{
+						checkpoint ();
+						walk = node.store.block_get (transaction, walk->previous ());
+					}
+					else
+					{
+						walk = nullptr;
+					}
+				}
+				if (height > confirmed_height)
+				{
+					// Rolled back while the read transaction was renewed
+					node.stats.inc (cga::stat::type::confirmation_height, cga::stat::detail::invalid_block);
+					stack.clear ();
+				}
+				else if (!sources_pending)
+				{
+					std::lock_guard<std::mutex> lock (mutex);
+					pending_writes[account] = { sideband.height, current };
+				}
+			}
+			// Revisited once its sources are cemented, by then they're all below their confirmation heights
+			if (!sources_pending && !stack.empty ())
+			{
+				stack.pop_back ();
+			}
+		}
+	}
+}
+
+uint64_t cga::confirmation_height_processor::confirmation_height (cga::transaction const & transaction_a, cga::account const & account_a)
+{
+	uint64_t result (0);
+	auto existing (pending_writes.find (account_a));
+	if (existing != pending_writes.end ())
+	{
+		result = existing->second.height;
+	}
+	else
+	{
+		cga::account_info info;
+		if (!node.store.account_get (transaction_a, account_a, info))
+		{
+			result = info.confirmation_height;
+		}
+	}
+	return result;
+}
+
+void cga::confirmation_height_processor::write_pending ()
+{
+	std::unordered_map<cga::account, pending_height> writes;
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		writes.swap (pending_writes);
+	}
+	if (!writes.empty ())
+	{
+		auto transaction (node.store.tx_begin_write ());
+		for (auto & i : writes)
+		{
+			cga::account_info info;
+			if (!node.store.account_get (transaction, i.first, info) && i.second.height > info.confirmation_height && node.store.block_exists (transaction, i.second.hash))
+			{
+				node.stats.add (cga::stat::type::confirmation_height, cga::stat::detail::blocks_confirmed, cga::stat::dir::in, i.second.height - info.confirmation_height);
+				info.confirmation_height = i.second.height;
+				node.store.account_put (transaction, i.first, info);
+			}
+		}
+	}
+}
+
+namespace cga
+{
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (confirmation_height_processor & confirmation_height_processor, const std::string & name)
+{
+	size_t hashes_count = 0;
+	size_t pending_writes_count = 0;
+	{
+		std::lock_guard<std::mutex> guard (confirmation_height_processor.mutex);
+		hashes_count = confirmation_height_processor.hashes.size ();
+		pending_writes_count = confirmation_height_processor.pending_writes.size ();
+	}
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "hashes", hashes_count, sizeof (decltype (confirmation_height_processor.hashes)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "pending_writes", pending_writes_count, sizeof (decltype (confirmation_height_processor.pending_writes)::value_type) }));
+	return composite;
+}
+}
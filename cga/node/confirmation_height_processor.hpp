@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cga/lib/numbers.hpp>
+#include <cga/lib/utility.hpp>
+#include <cga/secure/common.hpp>
+
+#include <boost/thread/thread.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace cga
+{
+class node;
+class transaction;
+
+/**
+ * Cements confirmed blocks by raising their account's confirmation height. Confirming a block also confirms
+ * its previous chain and the source chain of every receive in it, these dependencies are walked iteratively
+ * with an explicit stack so deep chains can't exhaust the thread stack. New heights are collected in memory
+ * and written in bulk, one write transaction per batch.
+ */
+class confirmation_height_processor
+{
+public:
+	confirmation_height_processor (cga::node &);
+	~confirmation_height_processor ();
+	void add (cga::block_hash const &);
+	void stop ();
+	/** Blocks until every queued hash has been cemented */
+	void flush ();
+	static size_t constexpr batch_write_size = 4096;
+
+private:
+	class pending_height
+	{
+	public:
+		uint64_t height;
+		// Highest block being cemented, checked before writing in case it was rolled back in the meantime
+		cga::block_hash hash;
+	};
+	void run ();
+	void process (cga::block_hash const &);
+	uint64_t confirmation_height (cga::transaction const &, cga::account const &);
+	void write_pending ();
+	cga::node & node;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<cga::block_hash> hashes;
+	// Heights waiting for the next write batch, only the processing thread modifies it, always holding mutex
+	std::unordered_map<cga::account, pending_height> pending_writes;
+	bool active;
+	bool stopped;
+	boost::thread thread;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (confirmation_height_processor & confirmation_height_processor, const std::string & name);
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (confirmation_height_processor & confirmation_height_processor, const std::string & name);
+}
@@ -2,6 +2,7 @@
 
 #include <cga/lib/utility.hpp>
 #include <cga/node/common.hpp>
+#include <cga/node/stats.hpp>
 #include <cga/secure/versioning.hpp>
 
 #include <boost/endian/conversion.hpp>
@@ -9,7 +10,35 @@
 
 #include <queue>
 
-cga::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs, size_t map_size_a)
+namespace
+{
+/**
+ * The calling thread's read slots, one per environment it has read from
+ */
+class mdb_thread_read_slots
+{
+public:
+	~mdb_thread_read_slots ()
+	{
+		for (auto & i : slots)
+		{
+			std::lock_guard<std::mutex> lock (i.second->mutex);
+			if (!i.second->closed && i.second->handle != nullptr)
+			{
+				mdb_txn_abort (i.second->handle);
+				i.second->handle = nullptr;
+			}
+			i.second->closed = true;
+		}
+	}
+	std::unordered_map<cga::mdb_env const *, std::shared_ptr<cga::mdb_read_slot>> slots;
+};
+thread_local mdb_thread_read_slots thread_read_slots;
+}
+
+cga::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, int max_dbs, size_t map_size_a, std::chrono::steady_clock::duration read_txn_max_age_a) :
+read_txn_max_age (read_txn_max_age_a),
+read_slots_swept (std::chrono::steady_clock::now ())
 {
 	boost::system::error_code error_mkdir, error_chmod;
 	if (path_a.has_parent_path ())
@@ -46,6 +75,19 @@ cga::mdb_env::mdb_env (bool & error_a, boost::filesystem::path const & path_a, i
 
 cga::mdb_env::~mdb_env ()
 {
+	{
+		std::lock_guard<std::mutex> lock (read_slots_mutex);
+		for (auto & i : read_slots)
+		{
+			std::lock_guard<std::mutex> slot_lock (i->mutex);
+			if (!i->closed && i->handle != nullptr)
+			{
+				mdb_txn_abort (i->handle);
+				i->handle = nullptr;
+			}
+			i->closed = true;
+		}
+	}
 	if (environment != nullptr)
 	{
 		mdb_env_close (environment);
@@ -69,6 +111,122 @@ MDB_txn * cga::mdb_env::tx (cga::transaction const & transaction_a) const
 	return *result;
 }
 
+MDB_txn * cga::mdb_env::read_txn_acquire (std::chrono::steady_clock::time_point & begun_a) const
+{
+	MDB_txn * result (nullptr);
+	auto now (std::chrono::steady_clock::now ());
+	auto existing (thread_read_slots.slots.find (this));
+	if (existing != thread_read_slots.slots.end ())
+	{
+		auto slot (existing->second);
+		std::lock_guard<std::mutex> lock (slot->mutex);
+		if (slot->closed)
+		{
+			// Left by an environment which has since closed, possibly at the same address
+			thread_read_slots.slots.erase (existing);
+		}
+		else if (slot->handle != nullptr)
+		{
+			if (now - slot->begun < read_txn_max_age)
+			{
+				auto status (mdb_txn_renew (slot->handle));
+				release_assert (status == 0);
+				result = slot->handle;
+				begun_a = slot->begun;
+				++read_txn_renewals;
+			}
+			else
+			{
+				mdb_txn_abort (slot->handle);
+			}
+			slot->handle = nullptr;
+		}
+	}
+	if (result == nullptr)
+	{
+		auto status (mdb_txn_begin (environment, nullptr, MDB_RDONLY, &result));
+		if (status == MDB_READERS_FULL)
+		{
+			// Idle handles are holding the reader table, give them all back and try again
+			read_slots_sweep (now, true);
+			status = mdb_txn_begin (environment, nullptr, MDB_RDONLY, &result);
+		}
+		release_assert (status == 0);
+		begun_a = now;
+		++read_txn_begins;
+	}
+	return result;
+}
+
+void cga::mdb_env::read_txn_release (MDB_txn * handle_a, std::chrono::steady_clock::time_point begun_a) const
+{
+	auto now (std::chrono::steady_clock::now ());
+	std::shared_ptr<cga::mdb_read_slot> slot;
+	auto existing (thread_read_slots.slots.find (this));
+	if (existing != thread_read_slots.slots.end ())
+	{
+		slot = existing->second;
+	}
+	else
+	{
+		slot = std::make_shared<cga::mdb_read_slot> ();
+		thread_read_slots.slots[this] = slot;
+		std::lock_guard<std::mutex> lock (read_slots_mutex);
+		read_slots.push_back (slot);
+	}
+	auto kept (false);
+	{
+		std::lock_guard<std::mutex> lock (slot->mutex);
+		// Nested read transactions find the slot taken, only the outermost handle is kept
+		if (!slot->closed && slot->handle == nullptr && now - begun_a < read_txn_max_age)
+		{
+			mdb_txn_reset (handle_a);
+			slot->handle = handle_a;
+			slot->begun = begun_a;
+			kept = true;
+		}
+	}
+	if (!kept)
+	{
+		mdb_txn_abort (handle_a);
+	}
+	read_slots_sweep (now, false);
+}
+
+void cga::mdb_env::read_slots_sweep (std::chrono::steady_clock::time_point now_a, bool all_a) const
+{
+	std::unique_lock<std::mutex> lock (read_slots_mutex, std::defer_lock);
+	if (all_a)
+	{
+		lock.lock ();
+	}
+	else
+	{
+		lock.try_lock ();
+	}
+	if (lock.owns_lock () && (all_a || now_a - read_slots_swept >= read_txn_max_age))
+	{
+		read_slots_swept = now_a;
+		for (auto i (read_slots.begin ()); i != read_slots.end ();)
+		{
+			std::lock_guard<std::mutex> slot_lock ((*i)->mutex);
+			if (!(*i)->closed && (*i)->handle != nullptr && (all_a || now_a - (*i)->begun >= read_txn_max_age))
+			{
+				mdb_txn_abort ((*i)->handle);
+				(*i)->handle = nullptr;
+			}
+			if ((*i)->closed)
+			{
+				i = read_slots.erase (i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+}
+
 cga::mdb_val::mdb_val (cga::epoch epoch_a) :
 value ({ 0, nullptr }),
 epoch (epoch_a)
@@ -102,7 +260,7 @@ mdb_val (val_a.db_size (), const_cast<cga::account_info *> (&val_a))
 }
 
 cga::mdb_val::mdb_val (cga::pending_info const & val_a) :
-mdb_val (sizeof (val_a.source) + sizeof (val_a.amount), const_cast<cga::pending_info *> (&val_a))
+mdb_val (val_a.db_size (), const_cast<cga::pending_info *> (&val_a))
 {
 }
 
@@ -111,6 +269,11 @@ mdb_val (sizeof (val_a), const_cast<cga::pending_key *> (&val_a))
 {
 }
 
+cga::mdb_val::mdb_val (cga::delegator_key const & val_a) :
+mdb_val (sizeof (val_a), const_cast<cga::delegator_key *> (&val_a))
+{
+}
+
 cga::mdb_val::mdb_val (cga::unchecked_info const & val_a) :
 buffer (std::make_shared<std::vector<uint8_t>> ())
 {
@@ -166,8 +329,10 @@ cga::mdb_val::operator cga::account_info () const
 {
 	cga::account_info result;
 	result.epoch = epoch;
-	assert (value.mv_size == result.db_size ());
-	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + result.db_size (), reinterpret_cast<uint8_t *> (&result));
+	// Entries written before v16 end without the epoch, which is then taken from the table they were read from.
+	// Entries written before v14 also end at block_count, their confirmation height stays 0 until the account is next written
+	assert (value.mv_size == result.db_size () || value.mv_size == result.db_size () - sizeof (result.epoch) || value.mv_size == result.db_size () - sizeof (result.epoch) - sizeof (result.confirmation_height));
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + std::min (value.mv_size, result.db_size ()), reinterpret_cast<uint8_t *> (&result));
 	return result;
 }
 
@@ -184,7 +349,9 @@ cga::mdb_val::operator cga::pending_info () const
 {
 	cga::pending_info result;
 	result.epoch = epoch;
-	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (cga::pending_info::source) + sizeof (cga::pending_info::amount), reinterpret_cast<uint8_t *> (&result));
+	// Entries written before v16 end without the epoch, which is then taken from the table they were read from
+	assert (value.mv_size == result.db_size () || value.mv_size == result.db_size () - sizeof (result.epoch));
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + std::min (value.mv_size, result.db_size ()), reinterpret_cast<uint8_t *> (&result));
 	return result;
 }
 
@@ -197,6 +364,15 @@ cga::mdb_val::operator cga::pending_key () const
 	return result;
 }
 
+cga::mdb_val::operator cga::delegator_key () const
+{
+	cga::delegator_key result;
+	assert (value.mv_size == sizeof (result));
+	static_assert (sizeof (cga::delegator_key::representative) + sizeof (cga::delegator_key::account) == sizeof (result), "Packed class");
+	std::copy (reinterpret_cast<uint8_t const *> (value.mv_data), reinterpret_cast<uint8_t const *> (value.mv_data) + sizeof (result), reinterpret_cast<uint8_t *> (&result));
+	return result;
+}
+
 cga::mdb_val::operator cga::unchecked_info () const
 {
 	cga::bufferstream stream (reinterpret_cast<uint8_t const *> (value.mv_data), value.mv_size);
@@ -325,16 +501,67 @@ cga::mdb_val::operator MDB_val const & () const
 	return value;
 }
 
-cga::mdb_txn::mdb_txn (cga::mdb_env const & environment_a, bool write_a)
+cga::mdb_txn::mdb_txn (cga::mdb_env const & environment_a, bool write_a) :
+env (environment_a),
+write (write_a)
+{
+	if (write)
+	{
+		auto status (mdb_txn_begin (env, nullptr, 0, &handle));
+		release_assert (status == 0);
+	}
+	else
+	{
+		handle = env.read_txn_acquire (begun);
+	}
+}
+
+cga::mdb_txn::mdb_txn (cga::mdb_env const & environment_a, cga::mdb_txn & parent_a) :
+env (environment_a),
+write (true)
 {
-	auto status (mdb_txn_begin (environment_a, nullptr, write_a ? 0 : MDB_RDONLY, &handle));
+	parent = &parent_a;
+	auto status (mdb_txn_begin (env, parent_a.handle, 0, &handle));
 	release_assert (status == 0);
 }
 
 cga::mdb_txn::~mdb_txn ()
 {
-	auto status (mdb_txn_commit (handle));
-	release_assert (status == 0);
+	if (write)
+	{
+		if (handle != nullptr)
+		{
+			auto status (mdb_txn_commit (handle));
+			release_assert (status == 0);
+			auto committed_l (std::move (committed));
+			for (auto & i : committed_l)
+			{
+				i (parent);
+			}
+			if (parent != nullptr)
+			{
+				// Undone along with the parent's own changes
+				parent->aborted.insert (parent->aborted.end (), std::make_move_iterator (aborted.begin ()), std::make_move_iterator (aborted.end ()));
+			}
+		}
+	}
+	else
+	{
+		env.read_txn_release (handle, begun);
+	}
+}
+
+void cga::mdb_txn::abort ()
+{
+	assert (write && handle != nullptr);
+	mdb_txn_abort (handle);
+	handle = nullptr;
+	committed.clear ();
+	for (auto i (aborted.rbegin ()), n (aborted.rend ()); i != n; ++i)
+	{
+		(*i) ();
+	}
+	aborted.clear ();
 }
 
 cga::mdb_txn::operator MDB_txn * () const
@@ -358,14 +585,7 @@ public:
 	virtual ~block_predecessor_set () = default;
 	void fill_value (cga::block const & block_a)
 	{
-		auto hash (block_a.hash ());
-		cga::block_type type;
-		auto value (store.block_raw_get (transaction, block_a.previous (), type));
-		auto version (store.block_version (transaction, block_a.previous ()));
-		assert (value.mv_size != 0);
-		std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
-		std::copy (hash.bytes.begin (), hash.bytes.end (), data.begin () + store.block_successor_offset (transaction, value, type));
-		store.block_raw_put (transaction, store.block_database (type, version), block_a.previous (), cga::mdb_val (data.size (), data.data ()));
+		store.block_successor_put (transaction, block_a.previous (), block_a.hash ());
 	}
 	void send_block (cga::send_block const & block_a) override
 	{
@@ -561,121 +781,6 @@ void cga::mdb_iterator<T, U>::fill (std::pair<T, U> & value_a) const
 	}
 }
 
-template <typename T, typename U>
-std::pair<cga::mdb_val, cga::mdb_val> * cga::mdb_merge_iterator<T, U>::operator-> ()
-{
-	return least_iterator ().operator-> ();
-}
-
-template <typename T, typename U>
-cga::mdb_merge_iterator<T, U>::mdb_merge_iterator (cga::transaction const & transaction_a, MDB_dbi db1_a, MDB_dbi db2_a) :
-impl1 (std::make_unique<cga::mdb_iterator<T, U>> (transaction_a, db1_a, cga::epoch::epoch_0)),
-impl2 (std::make_unique<cga::mdb_iterator<T, U>> (transaction_a, db2_a, cga::epoch::epoch_1))
-{
-}
-
-template <typename T, typename U>
-cga::mdb_merge_iterator<T, U>::mdb_merge_iterator (std::nullptr_t) :
-impl1 (std::make_unique<cga::mdb_iterator<T, U>> (nullptr, cga::epoch::epoch_0)),
-impl2 (std::make_unique<cga::mdb_iterator<T, U>> (nullptr, cga::epoch::epoch_1))
-{
-}
-
-template <typename T, typename U>
-cga::mdb_merge_iterator<T, U>::mdb_merge_iterator (cga::transaction const & transaction_a, MDB_dbi db1_a, MDB_dbi db2_a, MDB_val const & val_a) :
-impl1 (std::make_unique<cga::mdb_iterator<T, U>> (transaction_a, db1_a, val_a, cga::epoch::epoch_0)),
-impl2 (std::make_unique<cga::mdb_iterator<T, U>> (transaction_a, db2_a, val_a, cga::epoch::epoch_1))
-{
-}
-
-template <typename T, typename U>
-cga::mdb_merge_iterator<T, U>::mdb_merge_iterator (cga::mdb_merge_iterator<T, U> && other_a)
-{
-	impl1 = std::move (other_a.impl1);
-	impl2 = std::move (other_a.impl2);
-}
-
-template <typename T, typename U>
-cga::mdb_merge_iterator<T, U>::~mdb_merge_iterator ()
-{
-}
-
-template <typename T, typename U>
-cga::store_iterator_impl<T, U> & cga::mdb_merge_iterator<T, U>::operator++ ()
-{
-	++least_iterator ();
-	return *this;
-}
-
-template <typename T, typename U>
-bool cga::mdb_merge_iterator<T, U>::is_end_sentinal () const
-{
-	return least_iterator ().is_end_sentinal ();
-}
-
-template <typename T, typename U>
-void cga::mdb_merge_iterator<T, U>::fill (std::pair<T, U> & value_a) const
-{
-	auto & current (least_iterator ());
-	if (current->first.size () != 0)
-	{
-		value_a.first = static_cast<T> (current->first);
-	}
-	else
-	{
-		value_a.first = T ();
-	}
-	if (current->second.size () != 0)
-	{
-		value_a.second = static_cast<U> (current->second);
-	}
-	else
-	{
-		value_a.second = U ();
-	}
-}
-
-template <typename T, typename U>
-bool cga::mdb_merge_iterator<T, U>::operator== (cga::store_iterator_impl<T, U> const & base_a) const
-{
-	assert ((dynamic_cast<cga::mdb_merge_iterator<T, U> const *> (&base_a) != nullptr) && "Incompatible iterator comparison");
-	auto & other (static_cast<cga::mdb_merge_iterator<T, U> const &> (base_a));
-	return *impl1 == *other.impl1 && *impl2 == *other.impl2;
-}
-
-template <typename T, typename U>
-cga::mdb_iterator<T, U> & cga::mdb_merge_iterator<T, U>::least_iterator () const
-{
-	cga::mdb_iterator<T, U> * result;
-	if (impl1->is_end_sentinal ())
-	{
-		result = impl2.get ();
-	}
-	else if (impl2->is_end_sentinal ())
-	{
-		result = impl1.get ();
-	}
-	else
-	{
-		auto key_cmp (mdb_cmp (mdb_cursor_txn (impl1->cursor), mdb_cursor_dbi (impl1->cursor), impl1->current.first, impl2->current.first));
-
-		if (key_cmp < 0)
-		{
-			result = impl1.get ();
-		}
-		else if (key_cmp > 0)
-		{
-			result = impl2.get ();
-		}
-		else
-		{
-			auto val_cmp (mdb_cmp (mdb_cursor_txn (impl1->cursor), mdb_cursor_dbi (impl1->cursor), impl1->current.second, impl2->current.second));
-			result = val_cmp < 0 ? impl1.get () : impl2.get ();
-		}
-	}
-	return *result;
-}
-
 cga::wallet_value::wallet_value (cga::mdb_val const & val_a)
 {
 	assert (val_a.size () == sizeof (*this));
@@ -696,6 +801,7 @@ cga::mdb_val cga::wallet_value::val () const
 }
 
 template class cga::mdb_iterator<cga::pending_key, cga::pending_info>;
+template class cga::mdb_iterator<cga::delegator_key, cga::no_value>;
 template class cga::mdb_iterator<cga::uint256_union, cga::block_info>;
 template class cga::mdb_iterator<cga::uint256_union, cga::uint128_union>;
 template class cga::mdb_iterator<cga::uint256_union, cga::uint256_union>;
@@ -744,73 +850,247 @@ cga::store_iterator<cga::account, std::shared_ptr<cga::vote>> cga::mdb_store::vo
 	return cga::store_iterator<cga::account, std::shared_ptr<cga::vote>> (nullptr);
 }
 
-cga::mdb_store::mdb_store (bool & error_a, cga::logging & logging_a, boost::filesystem::path const & path_a, int lmdb_max_dbs, bool drop_unchecked, size_t const batch_size) :
-logging (logging_a),
-env (error_a, path_a, lmdb_max_dbs)
+cga::mdb_write_queue::mdb_write_queue (cga::mdb_env & env_a, std::chrono::milliseconds max_latency_a, size_t max_ops_a) :
+max_latency (max_latency_a),
+max_ops (max_ops_a),
+env (env_a),
+stopped (false),
+thread ([this]() {
+	cga::thread_role::set (cga::thread_role::name::write_queue);
+	run ();
+})
 {
-	auto slow_upgrade (false);
-	if (!error_a)
+}
+
+cga::mdb_write_queue::~mdb_write_queue ()
+{
+	stop ();
+}
+
+std::future<void> cga::mdb_write_queue::add (std::function<void(cga::transaction const &)> const & action_a)
+{
+	entry entry_l{ action_a, std::promise<void> (), std::chrono::steady_clock::now () };
+	auto result (entry_l.promise.get_future ());
+	std::unique_lock<std::mutex> lock (mutex);
+	if (!stopped)
 	{
-		auto transaction (tx_begin_write ());
-		error_a |= mdb_dbi_open (env.tx (transaction), "frontiers", MDB_CREATE, &frontiers) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "accounts", MDB_CREATE, &accounts_v0) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "accounts_v1", MDB_CREATE, &accounts_v1) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "send", MDB_CREATE, &send_blocks) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "receive", MDB_CREATE, &receive_blocks) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "open", MDB_CREATE, &open_blocks) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "change", MDB_CREATE, &change_blocks) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "state", MDB_CREATE, &state_blocks_v0) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "state_v1", MDB_CREATE, &state_blocks_v1) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "pending", MDB_CREATE, &pending_v0) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "pending_v1", MDB_CREATE, &pending_v1) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "representation", MDB_CREATE, &representation) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "unchecked", MDB_CREATE, &unchecked) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "vote", MDB_CREATE, &vote) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "online_weight", MDB_CREATE, &online_weight) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "meta", MDB_CREATE, &meta) != 0;
-		error_a |= mdb_dbi_open (env.tx (transaction), "peers", MDB_CREATE, &peers) != 0;
-		if (!full_sideband (transaction))
-		{
-			error_a |= mdb_dbi_open (env.tx (transaction), "blocks_info", MDB_CREATE, &blocks_info) != 0;
-		}
-		if (!error_a)
+		queue.push_back (std::move (entry_l));
+		auto notify (queue.size () == 1 || queue.size () >= max_ops);
+		lock.unlock ();
+		if (notify)
 		{
-			do_upgrades (transaction, slow_upgrade);
-			if (drop_unchecked)
-			{
-				unchecked_clear (transaction);
-			}
+			condition.notify_all ();
 		}
 	}
-	if (slow_upgrade)
+	else
 	{
-		upgrades = std::thread ([this, batch_size]() {
-			cga::thread_role::set (cga::thread_role::name::slow_db_upgrade);
-			do_slow_upgrades (batch_size);
-		});
+		lock.unlock ();
+		// Writer thread is gone, commit on the calling thread instead
+		std::deque<entry> entries;
+		entries.push_back (std::move (entry_l));
+		commit (entries);
 	}
+	return result;
 }
 
-cga::mdb_store::~mdb_store ()
+void cga::mdb_write_queue::stop ()
 {
-	stop ();
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+	if (thread.joinable ())
+	{
+		thread.join ();
+	}
 }
 
-void cga::mdb_store::stop ()
+void cga::mdb_write_queue::run ()
 {
-	stopped = true;
-	if (upgrades.joinable ())
+	std::unique_lock<std::mutex> lock (mutex);
+	while (!stopped || !queue.empty ())
 	{
-		upgrades.join ();
+		if (!queue.empty ())
+		{
+			// Give other writers a chance to join the batch, unless it is already full or the node is stopping
+			auto deadline (queue.front ().added + max_latency);
+			if (queue.size () < max_ops && !stopped && std::chrono::steady_clock::now () < deadline)
+			{
+				condition.wait_until (lock, deadline);
+			}
+			else
+			{
+				std::deque<entry> entries;
+				if (queue.size () <= max_ops)
+				{
+					entries.swap (queue);
+				}
+				else
+				{
+					auto end (queue.begin () + max_ops);
+					entries.insert (entries.end (), std::make_move_iterator (queue.begin ()), std::make_move_iterator (end));
+					queue.erase (queue.begin (), end);
+				}
+				lock.unlock ();
+				commit (entries);
+				lock.lock ();
+			}
+		}
+		else
+		{
+			condition.wait (lock);
+		}
 	}
 }
 
-cga::transaction cga::mdb_store::tx_begin_write ()
+void cga::mdb_write_queue::commit (std::deque<entry> & entries_a)
 {
-	return tx_begin (true);
-}
-
-cga::transaction cga::mdb_store::tx_begin_read ()
+	std::vector<std::exception_ptr> errors (entries_a.size ());
+	{
+		auto transaction (env.tx_begin (true));
+		for (size_t i (0); i < entries_a.size (); ++i)
+		{
+			// Each write runs in a nested transaction so one which throws doesn't leave partial changes in the batch
+			cga::transaction nested{ std::make_unique<cga::mdb_txn> (env, *boost::polymorphic_downcast<cga::mdb_txn *> (transaction.impl.get ())) };
+			try
+			{
+				entries_a[i].action (nested);
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception ();
+				boost::polymorphic_downcast<cga::mdb_txn *> (nested.impl.get ())->abort ();
+			}
+		}
+	}
+	for (size_t i (0); i < entries_a.size (); ++i)
+	{
+		if (errors[i] == nullptr)
+		{
+			entries_a[i].promise.set_value ();
+		}
+		else
+		{
+			entries_a[i].promise.set_exception (errors[i]);
+		}
+	}
+}
+
+namespace
+{
+// Block type and epoch precede every entry in the blocks table
+size_t constexpr block_prefix_size = 2;
+
+size_t & block_count_entry (cga::block_counts & counts_a, cga::block_type type_a, cga::epoch epoch_a)
+{
+	size_t * result (nullptr);
+	switch (type_a)
+	{
+		case cga::block_type::send:
+			result = &counts_a.send;
+			break;
+		case cga::block_type::receive:
+			result = &counts_a.receive;
+			break;
+		case cga::block_type::open:
+			result = &counts_a.open;
+			break;
+		case cga::block_type::change:
+			result = &counts_a.change;
+			break;
+		case cga::block_type::state:
+			result = epoch_a == cga::epoch::epoch_1 ? &counts_a.state_v1 : &counts_a.state_v0;
+			break;
+		default:
+			assert (false);
+			break;
+	}
+	return *result;
+}
+}
+
+cga::mdb_store::mdb_store (bool & error_a, cga::logging & logging_a, cga::stat & stats_a, boost::filesystem::path const & path_a, int lmdb_max_dbs, bool drop_unchecked, size_t const batch_size, std::chrono::milliseconds write_queue_max_latency, size_t write_queue_max_ops) :
+logging (logging_a),
+stats (stats_a),
+env (error_a, path_a, lmdb_max_dbs),
+write_queue (env, write_queue_max_latency, write_queue_max_ops)
+{
+	auto slow_upgrade (false);
+	if (!error_a)
+	{
+		auto transaction (tx_begin_write ());
+		error_a |= mdb_dbi_open (env.tx (transaction), "frontiers", MDB_CREATE, &frontiers) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "accounts", MDB_CREATE, &accounts) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "accounts_v1", MDB_CREATE, &accounts_v1) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "send", MDB_CREATE, &send_blocks) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "receive", MDB_CREATE, &receive_blocks) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "open", MDB_CREATE, &open_blocks) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "change", MDB_CREATE, &change_blocks) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "state", MDB_CREATE, &state_blocks_v0) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "state_v1", MDB_CREATE, &state_blocks_v1) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "pending", MDB_CREATE, &pending) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "pending_v1", MDB_CREATE, &pending_v1) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "representation", MDB_CREATE, &representation) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "unchecked", MDB_CREATE, &unchecked) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "vote", MDB_CREATE, &vote) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "online_weight", MDB_CREATE, &online_weight) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "meta", MDB_CREATE, &meta) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "peers", MDB_CREATE, &peers) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "pruned", MDB_CREATE, &pruned) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "delegators", MDB_CREATE, &delegators) != 0;
+		error_a |= mdb_dbi_open (env.tx (transaction), "blocks", MDB_CREATE, &blocks) != 0;
+		if (!full_sideband (transaction))
+		{
+			error_a |= mdb_dbi_open (env.tx (transaction), "blocks_info", MDB_CREATE, &blocks_info) != 0;
+		}
+		if (!error_a)
+		{
+			legacy_block_tables = version_get (transaction) < 15;
+			do_upgrades (transaction, slow_upgrade);
+			if (drop_unchecked)
+			{
+				unchecked_clear (transaction);
+			}
+			// Room for the ledger to double before the filter needs rebuilding
+			block_filter = block_filter_build (transaction, std::max<size_t> (block_count (transaction).sum () * 2, 1024 * 1024));
+			block_filter_enabled = true;
+		}
+	}
+	if (slow_upgrade)
+	{
+		upgrades = std::thread ([this, batch_size]() {
+			cga::thread_role::set (cga::thread_role::name::slow_db_upgrade);
+			do_slow_upgrades (batch_size);
+		});
+	}
+}
+
+cga::mdb_store::~mdb_store ()
+{
+	stop ();
+}
+
+void cga::mdb_store::stop ()
+{
+	stopped = true;
+	if (upgrades.joinable ())
+	{
+		upgrades.join ();
+	}
+	if (block_filter_rebuilder.joinable ())
+	{
+		block_filter_rebuilder.join ();
+	}
+	write_queue.stop ();
+}
+
+cga::transaction cga::mdb_store::tx_begin_write ()
+{
+	return tx_begin (true);
+}
+
+cga::transaction cga::mdb_store::tx_begin_read ()
 {
 	return tx_begin (false);
 }
@@ -820,15 +1100,25 @@ cga::transaction cga::mdb_store::tx_begin (bool write_a)
 	return env.tx_begin (write_a);
 }
 
+std::future<void> cga::mdb_store::tx_queue_write (std::function<void(cga::transaction const &)> const & action_a)
+{
+	return write_queue.add (action_a);
+}
+
+void cga::mdb_store::tx_queue_stop ()
+{
+	write_queue.stop ();
+}
+
 void cga::mdb_store::initialize (cga::transaction const & transaction_a, cga::genesis const & genesis_a)
 {
 	auto hash_l (genesis_a.hash ());
-	assert (latest_v0_begin (transaction_a) == latest_v0_end ());
-	assert (latest_v1_begin (transaction_a) == latest_v1_end ());
+	assert (latest_begin (transaction_a) == latest_end ());
 	cga::block_sideband sideband (cga::block_type::open, cga::genesis_account, 0, cga::genesis_amount, 1, cga::seconds_since_epoch ());
 	block_put (transaction_a, hash_l, *genesis_a.open, sideband);
-	account_put (transaction_a, genesis_account, { hash_l, genesis_a.open->hash (), genesis_a.open->hash (), std::numeric_limits<cga::uint128_t>::max (), cga::seconds_since_epoch (), 1, cga::epoch::epoch_0 });
+	account_put (transaction_a, genesis_account, { hash_l, genesis_a.open->hash (), genesis_a.open->hash (), std::numeric_limits<cga::uint128_t>::max (), cga::seconds_since_epoch (), 1, 1, cga::epoch::epoch_0 });
 	representation_put (transaction_a, genesis_account, std::numeric_limits<cga::uint128_t>::max ());
+	delegator_put (transaction_a, cga::delegator_key (genesis_account, genesis_account));
 	frontier_put (transaction_a, hash_l, genesis_account);
 }
 
@@ -970,9 +1260,24 @@ void cga::mdb_store::do_upgrades (cga::transaction const & transaction_a, bool &
 			upgrade_v11_to_v12 (transaction_a);
 			// [[fallthrough]];
 		case 12:
+			merge_epoch_tables (transaction_a);
 			slow_upgrade = true;
 			break;
 		case 13:
+			upgrade_v13_to_v14 (transaction_a);
+			// [[fallthrough]];
+		case 14:
+			// Blocks are moved into a single table in the background, version 16 is written once that completes
+			merge_epoch_tables (transaction_a);
+			slow_upgrade = true;
+			break;
+		case 15:
+			upgrade_v15_to_v16 (transaction_a);
+			// [[fallthrough]];
+		case 16:
+			upgrade_v16_to_v17 (transaction_a);
+			// [[fallthrough]];
+		case 17:
 			break;
 		default:
 			assert (false);
@@ -985,7 +1290,7 @@ void cga::mdb_store::upgrade_v1_to_v2 (cga::transaction const & transaction_a)
 	cga::account account (1);
 	while (!account.is_zero ())
 	{
-		cga::mdb_iterator<cga::uint256_union, cga::account_info_v1> i (transaction_a, accounts_v0, cga::mdb_val (account));
+		cga::mdb_iterator<cga::uint256_union, cga::account_info_v1> i (transaction_a, accounts, cga::mdb_val (account));
 		std::cerr << std::hex;
 		if (i != cga::mdb_iterator<cga::uint256_union, cga::account_info_v1> (nullptr))
 		{
@@ -1002,7 +1307,7 @@ void cga::mdb_store::upgrade_v1_to_v2 (cga::transaction const & transaction_a)
 				block = block_get (transaction_a, block->previous ());
 			}
 			v2.open_block = block->hash ();
-			auto status (mdb_put (env.tx (transaction_a), accounts_v0, cga::mdb_val (account), v2.val (), 0));
+			auto status (mdb_put (env.tx (transaction_a), accounts, cga::mdb_val (account), v2.val (), 0));
 			release_assert (status == 0);
 			account = account.number () + 1;
 		}
@@ -1017,7 +1322,7 @@ void cga::mdb_store::upgrade_v2_to_v3 (cga::transaction const & transaction_a)
 {
 	version_put (transaction_a, 3);
 	mdb_drop (env.tx (transaction_a), representation, 0);
-	for (auto i (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (transaction_a, accounts_v0)), n (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (nullptr)); *i != *n; ++(*i))
+	for (auto i (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (transaction_a, accounts)), n (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (nullptr)); *i != *n; ++(*i))
 	{
 		cga::account account_l ((*i)->first);
 		cga::account_info_v5 info ((*i)->second);
@@ -1035,13 +1340,13 @@ void cga::mdb_store::upgrade_v3_to_v4 (cga::transaction const & transaction_a)
 {
 	version_put (transaction_a, 4);
 	std::queue<std::pair<cga::pending_key, cga::pending_info>> items;
-	for (auto i (cga::store_iterator<cga::block_hash, cga::pending_info_v3> (std::make_unique<cga::mdb_iterator<cga::block_hash, cga::pending_info_v3>> (transaction_a, pending_v0))), n (cga::store_iterator<cga::block_hash, cga::pending_info_v3> (nullptr)); i != n; ++i)
+	for (auto i (cga::store_iterator<cga::block_hash, cga::pending_info_v3> (std::make_unique<cga::mdb_iterator<cga::block_hash, cga::pending_info_v3>> (transaction_a, pending))), n (cga::store_iterator<cga::block_hash, cga::pending_info_v3> (nullptr)); i != n; ++i)
 	{
 		cga::block_hash hash (i->first);
 		cga::pending_info_v3 info (i->second);
 		items.push (std::make_pair (cga::pending_key (info.destination, hash), cga::pending_info (info.source, info.amount, cga::epoch::epoch_0)));
 	}
-	mdb_drop (env.tx (transaction_a), pending_v0, 0);
+	mdb_drop (env.tx (transaction_a), pending, 0);
 	while (!items.empty ())
 	{
 		pending_put (transaction_a, items.front ().first, items.front ().second);
@@ -1052,7 +1357,7 @@ void cga::mdb_store::upgrade_v3_to_v4 (cga::transaction const & transaction_a)
 void cga::mdb_store::upgrade_v4_to_v5 (cga::transaction const & transaction_a)
 {
 	version_put (transaction_a, 5);
-	for (auto i (cga::store_iterator<cga::account, cga::account_info_v5> (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (transaction_a, accounts_v0))), n (cga::store_iterator<cga::account, cga::account_info_v5> (nullptr)); i != n; ++i)
+	for (auto i (cga::store_iterator<cga::account, cga::account_info_v5> (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (transaction_a, accounts))), n (cga::store_iterator<cga::account, cga::account_info_v5> (nullptr)); i != n; ++i)
 	{
 		cga::account_info_v5 info (i->second);
 		cga::block_hash successor (0);
@@ -1090,7 +1395,7 @@ void cga::mdb_store::upgrade_v5_to_v6 (cga::transaction const & transaction_a)
 {
 	version_put (transaction_a, 6);
 	std::deque<std::pair<cga::account, cga::account_info>> headers;
-	for (auto i (cga::store_iterator<cga::account, cga::account_info_v5> (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (transaction_a, accounts_v0))), n (cga::store_iterator<cga::account, cga::account_info_v5> (nullptr)); i != n; ++i)
+	for (auto i (cga::store_iterator<cga::account, cga::account_info_v5> (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info_v5>> (transaction_a, accounts))), n (cga::store_iterator<cga::account, cga::account_info_v5> (nullptr)); i != n; ++i)
 	{
 		cga::account account (i->first);
 		cga::account_info_v5 info_old (i->second);
@@ -1103,7 +1408,7 @@ void cga::mdb_store::upgrade_v5_to_v6 (cga::transaction const & transaction_a)
 			assert (block != nullptr);
 			hash = block->previous ();
 		}
-		cga::account_info info (info_old.head, info_old.rep_block, info_old.open_block, info_old.balance, info_old.modified, block_count, cga::epoch::epoch_0);
+		cga::account_info info (info_old.head, info_old.rep_block, info_old.open_block, info_old.balance, info_old.modified, block_count, 0, cga::epoch::epoch_0);
 		headers.push_back (std::make_pair (account, info));
 	}
 	for (auto i (headers.begin ()), n (headers.end ()); i != n; ++i)
@@ -1188,8 +1493,15 @@ void cga::mdb_store::do_slow_upgrades (size_t const batch_size)
 			break;
 		case 12:
 			upgrade_v12_to_v13 (batch_size);
-			break;
+			// Only returns early when stopping, which the block table upgrade checks before starting
+			// [[fallthrough]];
 		case 13:
+		case 14:
+			upgrade_v14_to_v15 (batch_size);
+			break;
+		case 15:
+		case 16:
+		case 17:
 			break;
 		default:
 			assert (false);
@@ -1248,7 +1560,8 @@ void cga::mdb_store::upgrade_v12_to_v13 (size_t const batch_size)
 				if (sideband.height == 0)
 				{
 					sideband.height = height;
-					block_put (transaction, hash, *block, sideband, block_version (transaction, hash));
+					// Rewritten in place, it's already in the block filter
+					block_write (transaction, hash, *block, sideband, block_version (transaction, hash));
 					cost += 16;
 				}
 				else
@@ -1269,6 +1582,145 @@ void cga::mdb_store::upgrade_v12_to_v13 (size_t const batch_size)
 	{
 		BOOST_LOG (logging.log) << boost::str (boost::format ("Completed sideband upgrade"));
 		version_put (transaction, 13);
+		upgrade_v13_to_v14 (transaction);
+	}
+}
+
+void cga::mdb_store::upgrade_v13_to_v14 (cga::transaction const & transaction_a)
+{
+	// Accounts keep their old layout until rewritten, only genesis needs to be cemented up front
+	cga::account_info info;
+	if (!account_get (transaction_a, cga::genesis_account, info) && info.confirmation_height == 0)
+	{
+		info.confirmation_height = 1;
+		account_put (transaction_a, cga::genesis_account, info);
+	}
+	version_put (transaction_a, 14);
+}
+
+void cga::mdb_store::upgrade_v14_to_v15 (size_t const batch_size)
+{
+	auto transaction (tx_begin_write ());
+	std::pair<cga::block_type, cga::epoch> const legacy_tables[]{ { cga::block_type::state, cga::epoch::epoch_1 }, { cga::block_type::state, cga::epoch::epoch_0 }, { cga::block_type::send, cga::epoch::epoch_0 }, { cga::block_type::receive, cga::epoch::epoch_0 }, { cga::block_type::open, cga::epoch::epoch_0 }, { cga::block_type::change, cga::epoch::epoch_0 } };
+	uint64_t moved (0);
+	size_t completed (0);
+	for (auto i (std::begin (legacy_tables)), n (std::end (legacy_tables)); i != n && !stopped; ++i)
+	{
+		auto table (block_database (i->first, i->second));
+		auto empty (false);
+		while (!stopped && !empty)
+		{
+			// Moved blocks are deleted so each batch starts from the front of the table, an interrupted upgrade resumes where it stopped
+			std::vector<std::pair<cga::block_hash, std::vector<uint8_t>>> batch;
+			for (cga::mdb_iterator<cga::block_hash, cga::no_value> j (transaction, table), k (nullptr); j != k && batch.size () < batch_size; ++j)
+			{
+				auto data (reinterpret_cast<uint8_t const *> (j->second.data ()));
+				std::vector<uint8_t> value;
+				value.reserve (block_prefix_size + j->second.size ());
+				value.push_back (static_cast<uint8_t> (i->first));
+				value.push_back (static_cast<uint8_t> (i->second));
+				value.insert (value.end (), data, data + j->second.size ());
+				batch.emplace_back (cga::block_hash (j->first), std::move (value));
+			}
+			empty = batch.empty ();
+			if (!empty)
+			{
+				auto counts (block_counts_get (transaction));
+				for (auto & block : batch)
+				{
+					auto status1 (mdb_put (env.tx (transaction), blocks, cga::mdb_val (block.first), cga::mdb_val (block.second.size (), block.second.data ()), 0));
+					release_assert (status1 == 0);
+					auto status2 (mdb_del (env.tx (transaction), table, cga::mdb_val (block.first), nullptr));
+					release_assert (status2 == 0);
+					++block_count_entry (counts, i->first, i->second);
+				}
+				block_counts_put (transaction, counts);
+				moved += batch.size ();
+				BOOST_LOG (logging.log) << boost::str (boost::format ("Moving blocks into the unified block table... %1% moved") % moved);
+				auto tx (boost::polymorphic_downcast<cga::mdb_txn *> (transaction.impl.get ()));
+				auto status0 (mdb_txn_commit (*tx));
+				release_assert (status0 == MDB_SUCCESS);
+				std::this_thread::yield ();
+				auto status3 (mdb_txn_begin (env, nullptr, 0, &tx->handle));
+				release_assert (status3 == MDB_SUCCESS);
+			}
+		}
+		if (empty)
+		{
+			++completed;
+		}
+	}
+	if (completed == std::extent<decltype (legacy_tables)>::value)
+	{
+		BOOST_LOG (logging.log) << boost::str (boost::format ("Completed block table upgrade"));
+		// The epoch tables were merged before the slow upgrades started, which is all version 16 needs
+		version_put (transaction, 16);
+		upgrade_v16_to_v17 (transaction);
+	}
+}
+
+void cga::mdb_store::upgrade_v15_to_v16 (cga::transaction const & transaction_a)
+{
+	merge_epoch_tables (transaction_a);
+	version_put (transaction_a, 16);
+}
+
+void cga::mdb_store::upgrade_v16_to_v17 (cga::transaction const & transaction_a)
+{
+	// Rebuilt from scratch, entries may have been added by the ledger while a slow upgrade was running
+	auto status (mdb_drop (env.tx (transaction_a), delegators, 0));
+	release_assert (status == 0);
+	for (auto i (latest_begin (transaction_a)), n (latest_end ()); i != n; ++i)
+	{
+		cga::account_info info (i->second);
+		cga::block_view rep_block;
+		auto error (block_view_get (transaction_a, info.rep_block, rep_block));
+		assert (!error);
+		delegator_put (transaction_a, cga::delegator_key (rep_block.representative (), i->first));
+	}
+	version_put (transaction_a, 17);
+}
+
+void cga::mdb_store::merge_epoch_tables (cga::transaction const & transaction_a)
+{
+	// Entries already carrying their epoch are skipped, so this is cheap to rerun if a slow upgrade restarts
+	std::deque<std::pair<cga::account, cga::account_info>> accounts_l;
+	for (cga::mdb_iterator<cga::account, cga::account_info> i (transaction_a, accounts, cga::epoch::epoch_0), n (nullptr); i != n; ++i)
+	{
+		cga::account_info info (i->second);
+		if (i->second.size () != info.db_size ())
+		{
+			accounts_l.push_back (std::make_pair (cga::account (i->first), info));
+		}
+	}
+	for (cga::mdb_iterator<cga::account, cga::account_info> i (transaction_a, accounts_v1, cga::epoch::epoch_1), n (nullptr); i != n; ++i)
+	{
+		accounts_l.push_back (std::make_pair (cga::account (i->first), cga::account_info (i->second)));
+	}
+	auto status1 (mdb_drop (env.tx (transaction_a), accounts_v1, 0));
+	release_assert (status1 == 0);
+	for (auto & i : accounts_l)
+	{
+		account_put (transaction_a, i.first, i.second);
+	}
+	std::deque<std::pair<cga::pending_key, cga::pending_info>> pending_l;
+	for (cga::mdb_iterator<cga::pending_key, cga::pending_info> i (transaction_a, pending, cga::epoch::epoch_0), n (nullptr); i != n; ++i)
+	{
+		cga::pending_info info (i->second);
+		if (i->second.size () != info.db_size ())
+		{
+			pending_l.push_back (std::make_pair (cga::pending_key (i->first), info));
+		}
+	}
+	for (cga::mdb_iterator<cga::pending_key, cga::pending_info> i (transaction_a, pending_v1, cga::epoch::epoch_1), n (nullptr); i != n; ++i)
+	{
+		pending_l.push_back (std::make_pair (cga::pending_key (i->first), cga::pending_info (i->second)));
+	}
+	auto status2 (mdb_drop (env.tx (transaction_a), pending_v1, 0));
+	release_assert (status2 == 0);
+	for (auto & i : pending_l)
+	{
+		pending_put (transaction_a, i.first, i.second);
 	}
 }
 
@@ -1284,23 +1736,33 @@ cga::uint128_t cga::mdb_store::block_balance (cga::transaction const & transacti
 	cga::block_sideband sideband;
 	auto block (block_get (transaction_a, hash_a, &sideband));
 	cga::uint128_t result;
-	switch (block->type ())
+	if (block != nullptr)
 	{
-		case cga::block_type::open:
-		case cga::block_type::receive:
-		case cga::block_type::change:
-			result = sideband.balance.number ();
-			break;
-		case cga::block_type::send:
-			result = boost::polymorphic_downcast<cga::send_block *> (block.get ())->hashables.balance.number ();
-			break;
-		case cga::block_type::state:
-			result = boost::polymorphic_downcast<cga::state_block *> (block.get ())->hashables.balance.number ();
-			break;
-		case cga::block_type::invalid:
-		case cga::block_type::not_a_block:
-			release_assert (false);
-			break;
+		switch (block->type ())
+		{
+			case cga::block_type::open:
+			case cga::block_type::receive:
+			case cga::block_type::change:
+				result = sideband.balance.number ();
+				break;
+			case cga::block_type::send:
+				result = boost::polymorphic_downcast<cga::send_block *> (block.get ())->hashables.balance.number ();
+				break;
+			case cga::block_type::state:
+				result = boost::polymorphic_downcast<cga::state_block *> (block.get ())->hashables.balance.number ();
+				break;
+			case cga::block_type::invalid:
+			case cga::block_type::not_a_block:
+				release_assert (false);
+				break;
+		}
+	}
+	else
+	{
+		cga::block_info info;
+		auto error (pruned_get (transaction_a, hash_a, info));
+		assert (!error);
+		result = info.balance.number ();
 	}
 	return result;
 }
@@ -1315,9 +1777,37 @@ cga::uint128_t cga::mdb_store::block_balance_computed (cga::transaction const &
 cga::epoch cga::mdb_store::block_version (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
 {
 	cga::mdb_val value;
-	auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, cga::mdb_val (hash_a), value));
+	auto status (mdb_get (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), value));
 	release_assert (status == 0 || status == MDB_NOTFOUND);
-	return status == 0 ? cga::epoch::epoch_1 : cga::epoch::epoch_0;
+	auto result (cga::epoch::epoch_0);
+	if (status == 0)
+	{
+		result = static_cast<cga::epoch> (reinterpret_cast<uint8_t const *> (value.data ())[1]);
+	}
+	else
+	{
+		if (legacy_block_tables)
+		{
+			status = mdb_get (env.tx (transaction_a), state_blocks_v1, cga::mdb_val (hash_a), value);
+			release_assert (status == 0 || status == MDB_NOTFOUND);
+			if (status == 0)
+			{
+				result = cga::epoch::epoch_1;
+			}
+		}
+		if (status != 0)
+		{
+			auto status2 (mdb_get (env.tx (transaction_a), pruned, cga::mdb_val (hash_a), value));
+			release_assert (status2 == 0 || status2 == MDB_NOTFOUND);
+			if (status2 == 0)
+			{
+				// Version follows the account and balance
+				assert (value.size () == sizeof (cga::block_info) + 1);
+				result = static_cast<cga::epoch> (reinterpret_cast<uint8_t const *> (value.data ())[sizeof (cga::block_info)]);
+			}
+		}
+	}
+	return result;
 }
 
 void cga::mdb_store::representation_add (cga::transaction const & transaction_a, cga::block_hash const & source_a, cga::uint128_t const & amount_a)
@@ -1381,16 +1871,83 @@ void cga::mdb_store::block_raw_put (cga::transaction const & transaction_a, MDB_
 }
 
 void cga::mdb_store::block_put (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block const & block_a, cga::block_sideband const & sideband_a, cga::epoch epoch_a)
+{
+	// Rewriting a stored block would add a duplicate fingerprint
+	auto exists (block_exists (transaction_a, hash_a));
+	block_write (transaction_a, hash_a, block_a, sideband_a, epoch_a);
+	if (!exists)
+	{
+		// Inserted before the commit so readers never miss a committed block, and taken out again if the write is aborted
+		std::lock_guard<std::shared_timed_mutex> lock (block_filter_mutex);
+		auto generation (block_filter_generation);
+		if (block_filter_rebuilding)
+		{
+			block_filter_pending.push_back (hash_a);
+			transaction_a.on_abort ([this, hash_a]() {
+				std::lock_guard<std::shared_timed_mutex> lock (block_filter_mutex);
+				if (block_filter_rebuilding)
+				{
+					auto existing (std::find (block_filter_pending.begin (), block_filter_pending.end (), hash_a));
+					if (existing != block_filter_pending.end ())
+					{
+						block_filter_pending.erase (existing);
+					}
+				}
+			});
+		}
+		else if (block_filter_enabled)
+		{
+			if (block_filter.insert (hash_a))
+			{
+				transaction_a.on_abort ([this, hash_a, generation]() {
+					block_filter_erase (hash_a, generation);
+				});
+			}
+			else
+			{
+				// Lookups go to LMDB until a larger filter is built from a read transaction, rather than rescanning the ledger inside this write
+				auto capacity (block_filter.capacity () * 2);
+				block_filter_enabled = false;
+				block_filter_rebuilding = true;
+				block_filter = cga::cuckoo_filter (0);
+				block_filter_pending.push_back (hash_a);
+				if (block_filter_rebuilder.joinable ())
+				{
+					// A previous rebuild is done with the lock once it cleared block_filter_rebuilding
+					block_filter_rebuilder.join ();
+				}
+				block_filter_rebuilder = std::thread ([this, capacity]() {
+					cga::thread_role::set (cga::thread_role::name::block_filter_rebuild);
+					block_filter_rebuild (capacity);
+				});
+			}
+		}
+	}
+}
+
+void cga::mdb_store::block_write (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block const & block_a, cga::block_sideband const & sideband_a, cga::epoch epoch_a)
 {
 	assert (block_a.type () == sideband_a.type);
 	assert (sideband_a.successor.is_zero () || block_exists (transaction_a, sideband_a.successor));
 	std::vector<uint8_t> vector;
 	{
 		cga::vectorstream stream (vector);
+		cga::write (stream, static_cast<uint8_t> (block_a.type ()));
+		cga::write (stream, static_cast<uint8_t> (epoch_a));
 		block_a.serialize (stream);
 		sideband_a.serialize (stream);
 	}
-	block_raw_put (transaction_a, block_database (block_a.type (), epoch_a), hash_a, { vector.size (), vector.data () });
+	auto status (mdb_put (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), cga::mdb_val (vector.size (), vector.data ()), 0));
+	release_assert (status == 0);
+	if (legacy_block_tables)
+	{
+		// Blocks rewritten by the sideband upgrade move out of their per type table
+		auto status (mdb_del (env.tx (transaction_a), block_database (block_a.type (), epoch_a), cga::mdb_val (hash_a), nullptr));
+		release_assert (status == 0 || status == MDB_NOTFOUND);
+	}
+	auto counts (block_counts_get (transaction_a));
+	++block_count_entry (counts, block_a.type (), epoch_a);
+	block_counts_put (transaction_a, counts);
 	cga::block_predecessor_set predecessor (transaction_a, *this);
 	block_a.visit (predecessor);
 	assert (block_a.previous ().is_zero () || block_successor (transaction_a, block_a.previous ()) == hash_a);
@@ -1451,78 +2008,187 @@ boost::optional<MDB_val> cga::mdb_store::block_raw_get_by_type (cga::transaction
 MDB_val cga::mdb_store::block_raw_get (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block_type & type_a)
 {
 	cga::mdb_val result;
-	// Table lookups are ordered by match probability
-	cga::block_type block_types[]{ cga::block_type::state, cga::block_type::send, cga::block_type::receive, cga::block_type::open, cga::block_type::change };
-	for (auto current_type : block_types)
+	if (block_filter_may_contain (hash_a))
 	{
-		auto mdb_val (block_raw_get_by_type (transaction_a, hash_a, current_type));
-		if (mdb_val.is_initialized ())
+		cga::mdb_val value;
+		auto status (mdb_get (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), value));
+		release_assert (status == 0 || status == MDB_NOTFOUND);
+		if (status == 0)
 		{
-			type_a = current_type;
-			result = mdb_val.get ();
-			break;
+			assert (value.size () > block_prefix_size);
+			auto data (reinterpret_cast<uint8_t *> (value.data ()));
+			type_a = static_cast<cga::block_type> (data[0]);
+			result = cga::mdb_val (value.size () - block_prefix_size, data + block_prefix_size);
+		}
+		else if (legacy_block_tables)
+		{
+			// Table lookups are ordered by match probability
+			cga::block_type block_types[]{ cga::block_type::state, cga::block_type::send, cga::block_type::receive, cga::block_type::open, cga::block_type::change };
+			for (auto current_type : block_types)
+			{
+				auto mdb_val (block_raw_get_by_type (transaction_a, hash_a, current_type));
+				if (mdb_val.is_initialized ())
+				{
+					type_a = current_type;
+					result = mdb_val.get ();
+					break;
+				}
+			}
 		}
+		block_filter_observe (result.size () != 0);
 	}
 
 	return result;
 }
 
-template <typename T>
-std::shared_ptr<cga::block> cga::mdb_store::block_random (cga::transaction const & transaction_a, MDB_dbi database)
+cga::cuckoo_filter cga::mdb_store::block_filter_build (cga::transaction const & transaction_a, size_t capacity_a)
 {
-	cga::block_hash hash;
-	cga::random_pool::generate_block (hash.bytes.data (), hash.bytes.size ());
-	cga::store_iterator<cga::block_hash, std::shared_ptr<T>> existing (std::make_unique<cga::mdb_iterator<cga::block_hash, std::shared_ptr<T>>> (transaction_a, database, cga::mdb_val (hash)));
-	if (existing == cga::store_iterator<cga::block_hash, std::shared_ptr<T>> (nullptr))
+	cga::cuckoo_filter result (capacity_a);
+	auto full (false);
+	std::vector<MDB_dbi> tables{ blocks };
+	if (legacy_block_tables)
 	{
-		existing = cga::store_iterator<cga::block_hash, std::shared_ptr<T>> (std::make_unique<cga::mdb_iterator<cga::block_hash, std::shared_ptr<T>>> (transaction_a, database));
+		tables.insert (tables.end (), { send_blocks, receive_blocks, open_blocks, change_blocks, state_blocks_v0, state_blocks_v1 });
 	}
-	auto end (cga::store_iterator<cga::block_hash, std::shared_ptr<T>> (nullptr));
-	assert (existing != end);
-	return block_get (transaction_a, cga::block_hash (existing->first));
+	for (auto table : tables)
+	{
+		for (auto i (cga::store_iterator<cga::block_hash, cga::no_value> (std::make_unique<cga::mdb_iterator<cga::block_hash, cga::no_value>> (transaction_a, table))), n (cga::store_iterator<cga::block_hash, cga::no_value> (nullptr)); i != n && !full; ++i)
+		{
+			full = !result.insert (i->first);
+		}
+	}
+	if (full)
+	{
+		result = block_filter_build (transaction_a, capacity_a * 2);
+	}
+	return result;
 }
 
-std::shared_ptr<cga::block> cga::mdb_store::block_random (cga::transaction const & transaction_a)
+void cga::mdb_store::block_filter_rebuild (size_t capacity_a)
 {
-	auto count (block_count (transaction_a));
-	release_assert (std::numeric_limits<CryptoPP::word32>::max () > count.sum ());
-	auto region = static_cast<size_t> (cga::random_pool::generate_word32 (0, static_cast<CryptoPP::word32> (count.sum () - 1)));
-	std::shared_ptr<cga::block> result;
-	if (region < count.send)
+	auto done (false);
+	while (!done)
 	{
-		result = block_random<cga::send_block> (transaction_a, send_blocks);
-	}
-	else
+		auto filter (block_filter_build (tx_begin_read (), capacity_a));
+		std::lock_guard<std::shared_timed_mutex> lock (block_filter_mutex);
+		// Puts committed before the snapshot are inserted twice, a duplicate can only turn into a false positive
+		done = true;
+		for (auto i (block_filter_pending.begin ()), n (block_filter_pending.end ()); i != n && done; ++i)
+		{
+			done = filter.insert (*i);
+		}
+		if (done)
+		{
+			block_filter = std::move (filter);
+			++block_filter_generation;
+			block_filter_pending.clear ();
+			block_filter_rebuilding = false;
+			block_filter_enabled = true;
+			BOOST_LOG (logging.log) << boost::str (boost::format ("Rebuilt block filter with capacity %1%") % block_filter.capacity ());
+		}
+		else
+		{
+			capacity_a = filter.capacity () * 2;
+		}
+	}
+}
+
+bool cga::mdb_store::block_filter_may_contain (cga::block_hash const & hash_a)
+{
+	auto result (true);
+	if (block_filter_enabled)
+	{
+		std::shared_lock<std::shared_timed_mutex> lock (block_filter_mutex);
+		// Rechecked, a put may have found it full and emptied it for rebuilding
+		result = !block_filter_enabled || block_filter.may_contain (hash_a);
+		if (!result)
+		{
+			block_filter_negatives.fetch_add (1, std::memory_order_relaxed);
+		}
+	}
+	return result;
+}
+
+void cga::mdb_store::block_filter_erase (cga::block_hash const & hash_a, uint64_t generation_a)
+{
+	std::lock_guard<std::shared_timed_mutex> lock (block_filter_mutex);
+	// A filter rebuilt since may not hold the hash, erasing it there could remove another key's fingerprint
+	if (block_filter_enabled && block_filter_generation == generation_a)
+	{
+		block_filter.erase (hash_a);
+	}
+}
+
+void cga::mdb_store::block_filter_observe (bool exists_a)
+{
+	if (block_filter_enabled)
+	{
+		(exists_a ? block_filter_positives : block_filter_false_positives).fetch_add (1, std::memory_order_relaxed);
+	}
+}
+
+std::shared_ptr<cga::block> cga::mdb_store::block_random (cga::transaction const & transaction_a, MDB_dbi database)
+{
+	cga::block_hash hash;
+	cga::random_pool::generate_block (hash.bytes.data (), hash.bytes.size ());
+	cga::store_iterator<cga::block_hash, cga::no_value> existing (std::make_unique<cga::mdb_iterator<cga::block_hash, cga::no_value>> (transaction_a, database, cga::mdb_val (hash)));
+	if (existing == cga::store_iterator<cga::block_hash, cga::no_value> (nullptr))
+	{
+		existing = cga::store_iterator<cga::block_hash, cga::no_value> (std::make_unique<cga::mdb_iterator<cga::block_hash, cga::no_value>> (transaction_a, database));
+	}
+	auto end (cga::store_iterator<cga::block_hash, cga::no_value> (nullptr));
+	assert (existing != end);
+	return block_get (transaction_a, cga::block_hash (existing->first));
+}
+
+std::shared_ptr<cga::block> cga::mdb_store::block_random (cga::transaction const & transaction_a)
+{
+	MDB_stat blocks_stats;
+	auto status (mdb_stat (env.tx (transaction_a), blocks, &blocks_stats));
+	release_assert (status == 0);
+	auto count (block_count_legacy (transaction_a));
+	release_assert (std::numeric_limits<CryptoPP::word32>::max () > blocks_stats.ms_entries + count.sum ());
+	auto region = static_cast<size_t> (cga::random_pool::generate_word32 (0, static_cast<CryptoPP::word32> (blocks_stats.ms_entries + count.sum () - 1)));
+	std::shared_ptr<cga::block> result;
+	if (region < blocks_stats.ms_entries)
+	{
+		result = block_random (transaction_a, blocks);
+	}
+	else if ((region -= blocks_stats.ms_entries) < count.send)
+	{
+		result = block_random (transaction_a, send_blocks);
+	}
+	else
 	{
 		region -= count.send;
 		if (region < count.receive)
 		{
-			result = block_random<cga::receive_block> (transaction_a, receive_blocks);
+			result = block_random (transaction_a, receive_blocks);
 		}
 		else
 		{
 			region -= count.receive;
 			if (region < count.open)
 			{
-				result = block_random<cga::open_block> (transaction_a, open_blocks);
+				result = block_random (transaction_a, open_blocks);
 			}
 			else
 			{
 				region -= count.open;
 				if (region < count.change)
 				{
-					result = block_random<cga::change_block> (transaction_a, change_blocks);
+					result = block_random (transaction_a, change_blocks);
 				}
 				else
 				{
 					region -= count.change;
 					if (region < count.state_v0)
 					{
-						result = block_random<cga::state_block> (transaction_a, state_blocks_v0);
+						result = block_random (transaction_a, state_blocks_v0);
 					}
 					else
 					{
-						result = block_random<cga::state_block> (transaction_a, state_blocks_v1);
+						result = block_random (transaction_a, state_blocks_v1);
 					}
 				}
 			}
@@ -1579,13 +2245,33 @@ cga::block_hash cga::mdb_store::block_successor (cga::transaction const & transa
 
 void cga::mdb_store::block_successor_clear (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
 {
-	cga::block_type type;
-	auto value (block_raw_get (transaction_a, hash_a, type));
-	auto version (block_version (transaction_a, hash_a));
-	assert (value.mv_size != 0);
-	std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
-	std::fill_n (data.begin () + block_successor_offset (transaction_a, value, type), sizeof (cga::uint256_union), 0);
-	block_raw_put (transaction_a, block_database (type, version), hash_a, cga::mdb_val (data.size (), data.data ()));
+	block_successor_put (transaction_a, hash_a, cga::block_hash (0));
+}
+
+void cga::mdb_store::block_successor_put (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block_hash const & successor_a)
+{
+	cga::mdb_val value;
+	auto status (mdb_get (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	if (status == 0)
+	{
+		std::vector<uint8_t> data (reinterpret_cast<uint8_t *> (value.data ()), reinterpret_cast<uint8_t *> (value.data ()) + value.size ());
+		// Successor leads the sideband
+		std::copy (successor_a.bytes.begin (), successor_a.bytes.end (), data.end () - cga::block_sideband::size (static_cast<cga::block_type> (data[0])));
+		auto status2 (mdb_put (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), cga::mdb_val (data.size (), data.data ()), 0));
+		release_assert (status2 == 0);
+	}
+	else
+	{
+		// Not moved out of its per type table yet, updated in place
+		cga::block_type type;
+		auto value (block_raw_get (transaction_a, hash_a, type));
+		auto version (block_version (transaction_a, hash_a));
+		assert (value.mv_size != 0);
+		std::vector<uint8_t> data (static_cast<uint8_t *> (value.mv_data), static_cast<uint8_t *> (value.mv_data) + value.mv_size);
+		std::copy (successor_a.bytes.begin (), successor_a.bytes.end (), data.begin () + block_successor_offset (transaction_a, value, type));
+		block_raw_put (transaction_a, block_database (type, version), hash_a, cga::mdb_val (data.size (), data.data ()));
+	}
 }
 
 std::shared_ptr<cga::block> cga::mdb_store::block_get (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block_sideband * sideband_a)
@@ -1605,6 +2291,11 @@ std::shared_ptr<cga::block> cga::mdb_store::block_get (cga::transaction const &
 			{
 				auto error (sideband_a->deserialize (stream));
 				assert (!error);
+				// Only stored for blocks which don't carry their account, filled in so it's valid for every type
+				if (type == cga::block_type::state || type == cga::block_type::open)
+				{
+					sideband_a->account = result->account ();
+				}
 			}
 			else
 			{
@@ -1620,135 +2311,198 @@ std::shared_ptr<cga::block> cga::mdb_store::block_get (cga::transaction const &
 	return result;
 }
 
+bool cga::mdb_store::block_view_get (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block_view & view_a)
+{
+	cga::block_type type;
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	auto result (value.mv_size == 0);
+	if (!result)
+	{
+		auto data (static_cast<uint8_t const *> (value.mv_data));
+		auto block_size (cga::block::size (type));
+		cga::block_sideband sideband;
+		sideband.type = type;
+		if (full_sideband (transaction_a) || entry_has_sideband (value, type))
+		{
+			cga::bufferstream stream (data + block_size, value.mv_size - block_size);
+			auto error (sideband.deserialize (stream));
+			assert (!error);
+		}
+		else
+		{
+			// Reconstruct sideband data for block.
+			sideband.account = block_account_computed (transaction_a, hash_a);
+			sideband.balance = block_balance_computed (transaction_a, hash_a);
+			sideband.successor = block_successor (transaction_a, hash_a);
+			sideband.height = 0;
+			sideband.timestamp = 0;
+		}
+		view_a = cga::block_view (type, data, sideband);
+	}
+	return result;
+}
+
 void cga::mdb_store::block_del (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
 {
-	auto status (mdb_del (env.tx (transaction_a), state_blocks_v1, cga::mdb_val (hash_a), nullptr));
+	cga::mdb_val value;
+	auto status (mdb_get (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), value));
 	release_assert (status == 0 || status == MDB_NOTFOUND);
-	if (status != 0)
+	if (status == 0)
+	{
+		auto data (reinterpret_cast<uint8_t const *> (value.data ()));
+		auto type (static_cast<cga::block_type> (data[0]));
+		auto epoch (static_cast<cga::epoch> (data[1]));
+		auto status (mdb_del (env.tx (transaction_a), blocks, cga::mdb_val (hash_a), nullptr));
+		release_assert (status == 0);
+		auto counts (block_counts_get (transaction_a));
+		assert (block_count_entry (counts, type, epoch) > 0);
+		--block_count_entry (counts, type, epoch);
+		block_counts_put (transaction_a, counts);
+	}
+	else
 	{
-		auto status (mdb_del (env.tx (transaction_a), state_blocks_v0, cga::mdb_val (hash_a), nullptr));
+		release_assert (legacy_block_tables);
+		auto status (mdb_del (env.tx (transaction_a), state_blocks_v1, cga::mdb_val (hash_a), nullptr));
 		release_assert (status == 0 || status == MDB_NOTFOUND);
 		if (status != 0)
 		{
-			auto status (mdb_del (env.tx (transaction_a), send_blocks, cga::mdb_val (hash_a), nullptr));
+			auto status (mdb_del (env.tx (transaction_a), state_blocks_v0, cga::mdb_val (hash_a), nullptr));
 			release_assert (status == 0 || status == MDB_NOTFOUND);
 			if (status != 0)
 			{
-				auto status (mdb_del (env.tx (transaction_a), receive_blocks, cga::mdb_val (hash_a), nullptr));
+				auto status (mdb_del (env.tx (transaction_a), send_blocks, cga::mdb_val (hash_a), nullptr));
 				release_assert (status == 0 || status == MDB_NOTFOUND);
 				if (status != 0)
 				{
-					auto status (mdb_del (env.tx (transaction_a), open_blocks, cga::mdb_val (hash_a), nullptr));
+					auto status (mdb_del (env.tx (transaction_a), receive_blocks, cga::mdb_val (hash_a), nullptr));
 					release_assert (status == 0 || status == MDB_NOTFOUND);
 					if (status != 0)
 					{
-						auto status (mdb_del (env.tx (transaction_a), change_blocks, cga::mdb_val (hash_a), nullptr));
-						release_assert (status == 0);
+						auto status (mdb_del (env.tx (transaction_a), open_blocks, cga::mdb_val (hash_a), nullptr));
+						release_assert (status == 0 || status == MDB_NOTFOUND);
+						if (status != 0)
+						{
+							auto status (mdb_del (env.tx (transaction_a), change_blocks, cga::mdb_val (hash_a), nullptr));
+							release_assert (status == 0);
+						}
 					}
 				}
 			}
 		}
 	}
-}
-
-bool cga::mdb_store::block_exists (cga::transaction const & transaction_a, cga::block_type type, cga::block_hash const & hash_a)
-{
-	auto exists (false);
-	cga::mdb_val junk;
-
-	switch (type)
+	// Only reached once one of the deletes above found the block. Taken out of the filter once the delete commits, an aborted delete keeps the block
 	{
-		case cga::block_type::send:
-		{
-			auto status (mdb_get (env.tx (transaction_a), send_blocks, cga::mdb_val (hash_a), junk));
-			assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case cga::block_type::receive:
-		{
-			auto status (mdb_get (env.tx (transaction_a), receive_blocks, cga::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case cga::block_type::open:
-		{
-			auto status (mdb_get (env.tx (transaction_a), open_blocks, cga::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case cga::block_type::change:
-		{
-			auto status (mdb_get (env.tx (transaction_a), change_blocks, cga::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			break;
-		}
-		case cga::block_type::state:
-		{
-			auto status (mdb_get (env.tx (transaction_a), state_blocks_v0, cga::mdb_val (hash_a), junk));
-			release_assert (status == 0 || status == MDB_NOTFOUND);
-			exists = status == 0;
-			if (!exists)
-			{
-				auto status (mdb_get (env.tx (transaction_a), state_blocks_v1, cga::mdb_val (hash_a), junk));
-				release_assert (status == 0 || status == MDB_NOTFOUND);
-				exists = status == 0;
-			}
-			break;
-		}
-		case cga::block_type::invalid:
-		case cga::block_type::not_a_block:
-			break;
+		std::lock_guard<std::shared_timed_mutex> lock (block_filter_mutex);
+		auto generation (block_filter_generation);
+		transaction_a.on_commit ([this, hash_a, generation]() {
+			block_filter_erase (hash_a, generation);
+		});
 	}
+}
 
-	return exists;
+bool cga::mdb_store::block_exists (cga::transaction const & transaction_a, cga::block_type type_a, cga::block_hash const & hash_a)
+{
+	auto type (cga::block_type::invalid);
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	return value.mv_size != 0 && type == type_a;
 }
 
-bool cga::mdb_store::block_exists (cga::transaction const & tx_a, cga::block_hash const & hash_a)
+bool cga::mdb_store::block_exists (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
 {
-	// clang-format off
-	return
-		block_exists (tx_a, cga::block_type::send, hash_a) ||
-		block_exists (tx_a, cga::block_type::receive, hash_a) ||
-		block_exists (tx_a, cga::block_type::open, hash_a) ||
-		block_exists (tx_a, cga::block_type::change, hash_a) ||
-		block_exists (tx_a, cga::block_type::state, hash_a);
-	// clang-format on
+	auto type (cga::block_type::invalid);
+	auto value (block_raw_get (transaction_a, hash_a, type));
+	return value.mv_size != 0;
 }
 
 cga::block_counts cga::mdb_store::block_count (cga::transaction const & transaction_a)
+{
+	auto result (block_counts_get (transaction_a));
+	auto legacy (block_count_legacy (transaction_a));
+	result.send += legacy.send;
+	result.receive += legacy.receive;
+	result.open += legacy.open;
+	result.change += legacy.change;
+	result.state_v0 += legacy.state_v0;
+	result.state_v1 += legacy.state_v1;
+	return result;
+}
+
+cga::block_counts cga::mdb_store::block_count_legacy (cga::transaction const & transaction_a)
 {
 	cga::block_counts result;
-	MDB_stat send_stats;
-	auto status1 (mdb_stat (env.tx (transaction_a), send_blocks, &send_stats));
-	release_assert (status1 == 0);
-	MDB_stat receive_stats;
-	auto status2 (mdb_stat (env.tx (transaction_a), receive_blocks, &receive_stats));
-	release_assert (status2 == 0);
-	MDB_stat open_stats;
-	auto status3 (mdb_stat (env.tx (transaction_a), open_blocks, &open_stats));
-	release_assert (status3 == 0);
-	MDB_stat change_stats;
-	auto status4 (mdb_stat (env.tx (transaction_a), change_blocks, &change_stats));
-	release_assert (status4 == 0);
-	MDB_stat state_v0_stats;
-	auto status5 (mdb_stat (env.tx (transaction_a), state_blocks_v0, &state_v0_stats));
-	release_assert (status5 == 0);
-	MDB_stat state_v1_stats;
-	auto status6 (mdb_stat (env.tx (transaction_a), state_blocks_v1, &state_v1_stats));
-	release_assert (status6 == 0);
-	result.send = send_stats.ms_entries;
-	result.receive = receive_stats.ms_entries;
-	result.open = open_stats.ms_entries;
-	result.change = change_stats.ms_entries;
-	result.state_v0 = state_v0_stats.ms_entries;
-	result.state_v1 = state_v1_stats.ms_entries;
+	if (legacy_block_tables)
+	{
+		MDB_stat send_stats;
+		auto status1 (mdb_stat (env.tx (transaction_a), send_blocks, &send_stats));
+		release_assert (status1 == 0);
+		MDB_stat receive_stats;
+		auto status2 (mdb_stat (env.tx (transaction_a), receive_blocks, &receive_stats));
+		release_assert (status2 == 0);
+		MDB_stat open_stats;
+		auto status3 (mdb_stat (env.tx (transaction_a), open_blocks, &open_stats));
+		release_assert (status3 == 0);
+		MDB_stat change_stats;
+		auto status4 (mdb_stat (env.tx (transaction_a), change_blocks, &change_stats));
+		release_assert (status4 == 0);
+		MDB_stat state_v0_stats;
+		auto status5 (mdb_stat (env.tx (transaction_a), state_blocks_v0, &state_v0_stats));
+		release_assert (status5 == 0);
+		MDB_stat state_v1_stats;
+		auto status6 (mdb_stat (env.tx (transaction_a), state_blocks_v1, &state_v1_stats));
+		release_assert (status6 == 0);
+		result.send = send_stats.ms_entries;
+		result.receive = receive_stats.ms_entries;
+		result.open = open_stats.ms_entries;
+		result.change = change_stats.ms_entries;
+		result.state_v0 = state_v0_stats.ms_entries;
+		result.state_v1 = state_v1_stats.ms_entries;
+	}
+	return result;
+}
+
+cga::block_counts cga::mdb_store::block_counts_get (cga::transaction const & transaction_a)
+{
+	cga::uint256_union block_counts_key (4);
+	cga::mdb_val value;
+	auto status (mdb_get (env.tx (transaction_a), meta, cga::mdb_val (block_counts_key), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	cga::block_counts result;
+	if (status == 0)
+	{
+		cga::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+		uint64_t send, receive, open, change, state_v0, state_v1;
+		auto error (cga::try_read (stream, send) || cga::try_read (stream, receive) || cga::try_read (stream, open) || cga::try_read (stream, change) || cga::try_read (stream, state_v0) || cga::try_read (stream, state_v1));
+		assert (!error);
+		if (!error)
+		{
+			result.send = send;
+			result.receive = receive;
+			result.open = open;
+			result.change = change;
+			result.state_v0 = state_v0;
+			result.state_v1 = state_v1;
+		}
+	}
 	return result;
 }
 
+void cga::mdb_store::block_counts_put (cga::transaction const & transaction_a, cga::block_counts const & counts_a)
+{
+	cga::uint256_union block_counts_key (4);
+	std::vector<uint8_t> vector;
+	{
+		cga::vectorstream stream (vector);
+		cga::write (stream, static_cast<uint64_t> (counts_a.send));
+		cga::write (stream, static_cast<uint64_t> (counts_a.receive));
+		cga::write (stream, static_cast<uint64_t> (counts_a.open));
+		cga::write (stream, static_cast<uint64_t> (counts_a.change));
+		cga::write (stream, static_cast<uint64_t> (counts_a.state_v0));
+		cga::write (stream, static_cast<uint64_t> (counts_a.state_v1));
+	}
+	auto status (mdb_put (env.tx (transaction_a), meta, cga::mdb_val (block_counts_key), cga::mdb_val (vector.size (), vector.data ()), 0));
+	release_assert (status == 0);
+}
+
 bool cga::mdb_store::root_exists (cga::transaction const & transaction_a, cga::uint256_union const & root_a)
 {
 	return block_exists (transaction_a, root_a) || account_exists (transaction_a, root_a);
@@ -1756,22 +2510,81 @@ bool cga::mdb_store::root_exists (cga::transaction const & transaction_a, cga::u
 
 bool cga::mdb_store::source_exists (cga::transaction const & transaction_a, cga::block_hash const & source_a)
 {
-	return block_exists (transaction_a, cga::block_type::state, source_a) || block_exists (transaction_a, cga::block_type::send, source_a);
+	// Any stored block counts, receiving from one which isn't a send is then rejected as unreceivable rather than a gap
+	return block_exists (transaction_a, source_a) || pruned_exists (transaction_a, source_a);
 }
 
 cga::account cga::mdb_store::block_account (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
 {
 	cga::block_sideband sideband;
 	auto block (block_get (transaction_a, hash_a, &sideband));
-	cga::account result (block->account ());
-	if (result.is_zero ())
+	cga::account result (0);
+	if (block != nullptr)
 	{
-		result = sideband.account;
+		result = block->account ();
+		if (result.is_zero ())
+		{
+			result = sideband.account;
+		}
+	}
+	else
+	{
+		cga::block_info info;
+		auto error (pruned_get (transaction_a, hash_a, info));
+		assert (!error);
+		result = info.account;
 	}
 	assert (!result.is_zero ());
 	return result;
 }
 
+void cga::mdb_store::block_prune (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
+{
+	assert (full_sideband (transaction_a));
+	cga::block_info info (block_account (transaction_a, hash_a), block_balance (transaction_a, hash_a));
+	auto version (block_version (transaction_a, hash_a));
+	std::vector<uint8_t> data;
+	{
+		cga::vectorstream stream (data);
+		info.serialize (stream);
+		cga::write (stream, static_cast<uint8_t> (version));
+	}
+	auto status (mdb_put (env.tx (transaction_a), pruned, cga::mdb_val (hash_a), cga::mdb_val (data.size (), data.data ()), 0));
+	release_assert (status == 0);
+	block_del (transaction_a, hash_a);
+}
+
+bool cga::mdb_store::pruned_exists (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
+{
+	cga::mdb_val value;
+	auto status (mdb_get (env.tx (transaction_a), pruned, cga::mdb_val (hash_a), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	return status == 0;
+}
+
+bool cga::mdb_store::pruned_get (cga::transaction const & transaction_a, cga::block_hash const & hash_a, cga::block_info & info_a)
+{
+	cga::mdb_val value;
+	auto status (mdb_get (env.tx (transaction_a), pruned, cga::mdb_val (hash_a), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	bool result (true);
+	if (status == 0)
+	{
+		cga::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
+		result = info_a.deserialize (stream);
+		assert (!result);
+	}
+	return result;
+}
+
+size_t cga::mdb_store::pruned_count (cga::transaction const & transaction_a)
+{
+	MDB_stat pruned_stats;
+	auto status (mdb_stat (env.tx (transaction_a), pruned, &pruned_stats));
+	release_assert (status == 0);
+	return pruned_stats.ms_entries;
+}
+
 // Return account containing hash
 cga::account cga::mdb_store::block_account_computed (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
 {
@@ -1817,13 +2630,8 @@ cga::account cga::mdb_store::block_account_computed (cga::transaction const & tr
 
 void cga::mdb_store::account_del (cga::transaction const & transaction_a, cga::account const & account_a)
 {
-	auto status1 (mdb_del (env.tx (transaction_a), accounts_v1, cga::mdb_val (account_a), nullptr));
-	if (status1 != 0)
-	{
-		release_assert (status1 == MDB_NOTFOUND);
-		auto status2 (mdb_del (env.tx (transaction_a), accounts_v0, cga::mdb_val (account_a), nullptr));
-		release_assert (status2 == 0);
-	}
+	auto status (mdb_del (env.tx (transaction_a), accounts, cga::mdb_val (account_a), nullptr));
+	release_assert (status == 0);
 }
 
 bool cga::mdb_store::account_exists (cga::transaction const & transaction_a, cga::account const & account_a)
@@ -1835,32 +2643,13 @@ bool cga::mdb_store::account_exists (cga::transaction const & transaction_a, cga
 bool cga::mdb_store::account_get (cga::transaction const & transaction_a, cga::account const & account_a, cga::account_info & info_a)
 {
 	cga::mdb_val value;
-	auto status1 (mdb_get (env.tx (transaction_a), accounts_v1, cga::mdb_val (account_a), value));
-	release_assert (status1 == 0 || status1 == MDB_NOTFOUND);
-	bool result (false);
-	cga::epoch epoch;
-	if (status1 == 0)
-	{
-		epoch = cga::epoch::epoch_1;
-	}
-	else
-	{
-		auto status2 (mdb_get (env.tx (transaction_a), accounts_v0, cga::mdb_val (account_a), value));
-		release_assert (status2 == 0 || status2 == MDB_NOTFOUND);
-		if (status2 == 0)
-		{
-			epoch = cga::epoch::epoch_0;
-		}
-		else
-		{
-			result = true;
-		}
-	}
-	if (!result)
+	auto status (mdb_get (env.tx (transaction_a), accounts, cga::mdb_val (account_a), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	bool result (true);
+	if (status == 0)
 	{
-		cga::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		info_a.epoch = epoch;
-		info_a.deserialize (stream);
+		info_a = cga::account_info (value);
+		result = false;
 	}
 	return result;
 }
@@ -1892,63 +2681,30 @@ void cga::mdb_store::frontier_del (cga::transaction const & transaction_a, cga::
 
 size_t cga::mdb_store::account_count (cga::transaction const & transaction_a)
 {
-	MDB_stat stats1;
-	auto status1 (mdb_stat (env.tx (transaction_a), accounts_v0, &stats1));
-	release_assert (status1 == 0);
-	MDB_stat stats2;
-	auto status2 (mdb_stat (env.tx (transaction_a), accounts_v1, &stats2));
-	release_assert (status2 == 0);
-	auto result (stats1.ms_entries + stats2.ms_entries);
-	return result;
+	MDB_stat stats;
+	auto status (mdb_stat (env.tx (transaction_a), accounts, &stats));
+	release_assert (status == 0);
+	return stats.ms_entries;
 }
 
 void cga::mdb_store::account_put (cga::transaction const & transaction_a, cga::account const & account_a, cga::account_info const & info_a)
 {
-	MDB_dbi db;
-	switch (info_a.epoch)
-	{
-		case cga::epoch::invalid:
-		case cga::epoch::unspecified:
-			assert (false);
-		case cga::epoch::epoch_0:
-			db = accounts_v0;
-			break;
-		case cga::epoch::epoch_1:
-			db = accounts_v1;
-			break;
-	}
-	auto status (mdb_put (env.tx (transaction_a), db, cga::mdb_val (account_a), cga::mdb_val (info_a), 0));
+	assert (info_a.epoch == cga::epoch::epoch_0 || info_a.epoch == cga::epoch::epoch_1);
+	auto status (mdb_put (env.tx (transaction_a), accounts, cga::mdb_val (account_a), cga::mdb_val (info_a), 0));
 	release_assert (status == 0);
 }
 
 void cga::mdb_store::pending_put (cga::transaction const & transaction_a, cga::pending_key const & key_a, cga::pending_info const & pending_a)
 {
-	MDB_dbi db;
-	switch (pending_a.epoch)
-	{
-		case cga::epoch::invalid:
-		case cga::epoch::unspecified:
-			assert (false);
-		case cga::epoch::epoch_0:
-			db = pending_v0;
-			break;
-		case cga::epoch::epoch_1:
-			db = pending_v1;
-			break;
-	}
-	auto status (mdb_put (env.tx (transaction_a), db, cga::mdb_val (key_a), cga::mdb_val (pending_a), 0));
+	assert (pending_a.epoch == cga::epoch::epoch_0 || pending_a.epoch == cga::epoch::epoch_1);
+	auto status (mdb_put (env.tx (transaction_a), pending, cga::mdb_val (key_a), cga::mdb_val (pending_a), 0));
 	release_assert (status == 0);
 }
 
 void cga::mdb_store::pending_del (cga::transaction const & transaction_a, cga::pending_key const & key_a)
 {
-	auto status1 (mdb_del (env.tx (transaction_a), pending_v1, mdb_val (key_a), nullptr));
-	if (status1 != 0)
-	{
-		release_assert (status1 == MDB_NOTFOUND);
-		auto status2 (mdb_del (env.tx (transaction_a), pending_v0, mdb_val (key_a), nullptr));
-		release_assert (status2 == 0);
-	}
+	auto status (mdb_del (env.tx (transaction_a), pending, mdb_val (key_a), nullptr));
+	release_assert (status == 0);
 }
 
 bool cga::mdb_store::pending_exists (cga::transaction const & transaction_a, cga::pending_key const & key_a)
@@ -1960,45 +2716,26 @@ bool cga::mdb_store::pending_exists (cga::transaction const & transaction_a, cga
 bool cga::mdb_store::pending_get (cga::transaction const & transaction_a, cga::pending_key const & key_a, cga::pending_info & pending_a)
 {
 	cga::mdb_val value;
-	auto status1 (mdb_get (env.tx (transaction_a), pending_v1, mdb_val (key_a), value));
-	release_assert (status1 == 0 || status1 == MDB_NOTFOUND);
-	bool result (false);
-	cga::epoch epoch;
-	if (status1 == 0)
-	{
-		epoch = cga::epoch::epoch_1;
-	}
-	else
-	{
-		auto status2 (mdb_get (env.tx (transaction_a), pending_v0, mdb_val (key_a), value));
-		release_assert (status2 == 0 || status2 == MDB_NOTFOUND);
-		if (status2 == 0)
-		{
-			epoch = cga::epoch::epoch_0;
-		}
-		else
-		{
-			result = true;
-		}
-	}
-	if (!result)
+	auto status (mdb_get (env.tx (transaction_a), pending, mdb_val (key_a), value));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
+	bool result (true);
+	if (status == 0)
 	{
-		cga::bufferstream stream (reinterpret_cast<uint8_t const *> (value.data ()), value.size ());
-		pending_a.epoch = epoch;
-		pending_a.deserialize (stream);
+		pending_a = cga::pending_info (value);
+		result = false;
 	}
 	return result;
 }
 
 cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_begin (cga::transaction const & transaction_a, cga::pending_key const & key_a)
 {
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_merge_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending_v0, pending_v1, mdb_val (key_a)));
+	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending, mdb_val (key_a)));
 	return result;
 }
 
 cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_begin (cga::transaction const & transaction_a)
 {
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_merge_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending_v0, pending_v1));
+	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending));
 	return result;
 }
 
@@ -2008,39 +2745,29 @@ cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending
 	return result;
 }
 
-cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_v0_begin (cga::transaction const & transaction_a, cga::pending_key const & key_a)
+void cga::mdb_store::delegator_put (cga::transaction const & transaction_a, cga::delegator_key const & key_a)
 {
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending_v0, mdb_val (key_a)));
-	return result;
-}
-
-cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_v0_begin (cga::transaction const & transaction_a)
-{
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending_v0));
-	return result;
-}
-
-cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_v0_end ()
-{
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (nullptr);
-	return result;
+	cga::mdb_val zero (0);
+	auto status (mdb_put (env.tx (transaction_a), delegators, cga::mdb_val (key_a), zero, 0));
+	release_assert (status == 0);
 }
 
-cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_v1_begin (cga::transaction const & transaction_a, cga::pending_key const & key_a)
+void cga::mdb_store::delegator_del (cga::transaction const & transaction_a, cga::delegator_key const & key_a)
 {
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending_v1, mdb_val (key_a)));
-	return result;
+	// Not found while a slow upgrade is running, the index is rebuilt once it completes
+	auto status (mdb_del (env.tx (transaction_a), delegators, cga::mdb_val (key_a), nullptr));
+	release_assert (status == 0 || status == MDB_NOTFOUND);
 }
 
-cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_v1_begin (cga::transaction const & transaction_a)
+cga::store_iterator<cga::delegator_key, cga::no_value> cga::mdb_store::delegators_begin (cga::transaction const & transaction_a, cga::delegator_key const & key_a)
 {
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (std::make_unique<cga::mdb_iterator<cga::pending_key, cga::pending_info>> (transaction_a, pending_v1));
+	cga::store_iterator<cga::delegator_key, cga::no_value> result (std::make_unique<cga::mdb_iterator<cga::delegator_key, cga::no_value>> (transaction_a, delegators, cga::mdb_val (key_a)));
 	return result;
 }
 
-cga::store_iterator<cga::pending_key, cga::pending_info> cga::mdb_store::pending_v1_end ()
+cga::store_iterator<cga::delegator_key, cga::no_value> cga::mdb_store::delegators_end ()
 {
-	cga::store_iterator<cga::pending_key, cga::pending_info> result (nullptr);
+	cga::store_iterator<cga::delegator_key, cga::no_value> result (nullptr);
 	return result;
 }
 
@@ -2206,6 +2933,11 @@ void cga::mdb_store::flush (cga::transaction const & transaction_a)
 		auto status1 (mdb_put (env.tx (transaction_a), vote, cga::mdb_val (i->first), cga::mdb_val (vector.size (), vector.data ()), 0));
 		release_assert (status1 == 0);
 	}
+	stats.add (cga::stat::type::block_filter, cga::stat::detail::filter_negative, cga::stat::dir::in, block_filter_negatives.exchange (0));
+	stats.add (cga::stat::type::block_filter, cga::stat::detail::filter_positive, cga::stat::dir::in, block_filter_positives.exchange (0));
+	stats.add (cga::stat::type::block_filter, cga::stat::detail::filter_false_positive, cga::stat::dir::in, block_filter_false_positives.exchange (0));
+	stats.add (cga::stat::type::read_transaction, cga::stat::detail::renewed, cga::stat::dir::in, env.read_txn_renewals.exchange (0));
+	stats.add (cga::stat::type::read_transaction, cga::stat::detail::begun, cga::stat::dir::in, env.read_txn_begins.exchange (0));
 }
 std::shared_ptr<cga::vote> cga::mdb_store::vote_current (cga::transaction const & transaction_a, cga::account const & account_a)
 {
@@ -2267,13 +2999,13 @@ std::shared_ptr<cga::vote> cga::mdb_store::vote_max (cga::transaction const & tr
 
 cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_begin (cga::transaction const & transaction_a, cga::account const & account_a)
 {
-	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_merge_iterator<cga::account, cga::account_info>> (transaction_a, accounts_v0, accounts_v1, cga::mdb_val (account_a)));
+	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info>> (transaction_a, accounts, cga::mdb_val (account_a)));
 	return result;
 }
 
 cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_begin (cga::transaction const & transaction_a)
 {
-	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_merge_iterator<cga::account, cga::account_info>> (transaction_a, accounts_v0, accounts_v1));
+	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info>> (transaction_a, accounts));
 	return result;
 }
 
@@ -2282,39 +3014,3 @@ cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_end
 	cga::store_iterator<cga::account, cga::account_info> result (nullptr);
 	return result;
 }
-
-cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_v0_begin (cga::transaction const & transaction_a, cga::account const & account_a)
-{
-	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info>> (transaction_a, accounts_v0, cga::mdb_val (account_a)));
-	return result;
-}
-
-cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_v0_begin (cga::transaction const & transaction_a)
-{
-	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info>> (transaction_a, accounts_v0));
-	return result;
-}
-
-cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_v0_end ()
-{
-	cga::store_iterator<cga::account, cga::account_info> result (nullptr);
-	return result;
-}
-
-cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_v1_begin (cga::transaction const & transaction_a, cga::account const & account_a)
-{
-	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info>> (transaction_a, accounts_v1, cga::mdb_val (account_a)));
-	return result;
-}
-
-cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_v1_begin (cga::transaction const & transaction_a)
-{
-	cga::store_iterator<cga::account, cga::account_info> result (std::make_unique<cga::mdb_iterator<cga::account, cga::account_info>> (transaction_a, accounts_v1));
-	return result;
-}
-
-cga::store_iterator<cga::account, cga::account_info> cga::mdb_store::latest_v1_end ()
-{
-	cga::store_iterator<cga::account, cga::account_info> result (nullptr);
-	return result;
-}
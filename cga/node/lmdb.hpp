@@ -4,11 +4,19 @@
 #include <boost/optional.hpp>
 #include <lmdb/libraries/liblmdb/lmdb.h>
 
+#include <cga/lib/cuckoo_filter.hpp>
 #include <cga/lib/numbers.hpp>
 #include <cga/node/logging.hpp>
 #include <cga/secure/blockstore.hpp>
 #include <cga/secure/common.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
 #include <thread>
 
 namespace cga
@@ -18,13 +26,31 @@ class mdb_txn : public transaction_impl
 {
 public:
 	mdb_txn (cga::mdb_env const &, bool = false);
+	// Nested write transaction, committed into its parent
+	mdb_txn (cga::mdb_env const &, cga::mdb_txn &);
 	mdb_txn (cga::mdb_txn const &) = delete;
-	mdb_txn (cga::mdb_txn &&) = default;
 	~mdb_txn ();
+	// Discards a write transaction's changes instead of committing them
+	void abort ();
 	cga::mdb_txn & operator= (cga::mdb_txn const &) = delete;
-	cga::mdb_txn & operator= (cga::mdb_txn &&) = default;
 	operator MDB_txn * () const;
 	MDB_txn * handle;
+	cga::mdb_env const & env;
+	bool write;
+	// When the handle was begun, read handles are renewed in place until they reach the environment's maximum age
+	std::chrono::steady_clock::time_point begun;
+};
+/**
+ * Read transaction handle a thread keeps for its next read transaction, reset between uses so it doesn't pin any pages
+ */
+class mdb_read_slot
+{
+public:
+	std::mutex mutex;
+	MDB_txn * handle{ nullptr };
+	std::chrono::steady_clock::time_point begun;
+	// Set once the owning thread exits or the environment closes, the slot is never used again
+	bool closed{ false };
 };
 /**
  * RAII wrapper for MDB_env
@@ -32,12 +58,30 @@ public:
 class mdb_env
 {
 public:
-	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128, size_t map_size = 128ULL * 1024 * 1024 * 1024);
+	mdb_env (bool &, boost::filesystem::path const &, int max_dbs = 128, size_t map_size = 128ULL * 1024 * 1024 * 1024, std::chrono::steady_clock::duration read_txn_max_age = std::chrono::seconds (30));
 	~mdb_env ();
 	operator MDB_env * () const;
 	cga::transaction tx_begin (bool = false) const;
 	MDB_txn * tx (cga::transaction const &) const;
+	// Renews the calling thread's idle read handle if it has one young enough, otherwise begins a new one
+	MDB_txn * read_txn_acquire (std::chrono::steady_clock::time_point &) const;
+	// Resets the handle and keeps it for the calling thread's next read transaction, unless it already has one
+	void read_txn_release (MDB_txn *, std::chrono::steady_clock::time_point) const;
 	MDB_env * environment;
+	/**
+	 * Idle handles don't pin pages but each holds a reader table entry, handles older than this are aborted
+	 * instead of renewed so threads which stop reading give their entries back
+	 */
+	std::chrono::steady_clock::duration const read_txn_max_age;
+	mutable std::atomic<uint64_t> read_txn_renewals{ 0 };
+	mutable std::atomic<uint64_t> read_txn_begins{ 0 };
+
+private:
+	// Aborts idle handles past the maximum age, or every idle handle when the reader table is full
+	void read_slots_sweep (std::chrono::steady_clock::time_point, bool) const;
+	mutable std::mutex read_slots_mutex;
+	mutable std::vector<std::shared_ptr<cga::mdb_read_slot>> read_slots;
+	mutable std::chrono::steady_clock::time_point read_slots_swept;
 };
 
 /**
@@ -52,6 +96,7 @@ public:
 	mdb_val (MDB_val const &, cga::epoch = cga::epoch::unspecified);
 	mdb_val (cga::pending_info const &);
 	mdb_val (cga::pending_key const &);
+	mdb_val (cga::delegator_key const &);
 	mdb_val (cga::unchecked_info const &);
 	mdb_val (size_t, void *);
 	mdb_val (cga::uint128_union const &);
@@ -66,6 +111,7 @@ public:
 	explicit operator cga::block_info () const;
 	explicit operator cga::pending_info () const;
 	explicit operator cga::pending_key () const;
+	explicit operator cga::delegator_key () const;
 	explicit operator cga::unchecked_info () const;
 	explicit operator cga::uint128_union () const;
 	explicit operator cga::uint256_union () const;
@@ -113,35 +159,41 @@ private:
 	MDB_txn * tx (cga::transaction const &) const;
 };
 
+class logging;
+class stat;
 /**
- * Iterates the key/value pairs of two stores merged together
+ * Group commit for read-write transactions
+ * Writes are queued as closures and a single writer thread applies them in batches, one transaction and one sync per batch.
+ * A batch is committed once it holds max_ops writes or its oldest write has waited max_latency.
+ * Each write runs in a nested transaction, side effects registered with transaction::on_commit are only applied once the batch is durable.
  */
-template <typename T, typename U>
-class mdb_merge_iterator : public store_iterator_impl<T, U>
+class mdb_write_queue
 {
 public:
-	mdb_merge_iterator (cga::transaction const &, MDB_dbi, MDB_dbi);
-	mdb_merge_iterator (std::nullptr_t);
-	mdb_merge_iterator (cga::transaction const &, MDB_dbi, MDB_dbi, MDB_val const &);
-	mdb_merge_iterator (cga::mdb_merge_iterator<T, U> &&);
-	mdb_merge_iterator (cga::mdb_merge_iterator<T, U> const &) = delete;
-	~mdb_merge_iterator ();
-	cga::store_iterator_impl<T, U> & operator++ () override;
-	std::pair<cga::mdb_val, cga::mdb_val> * operator-> ();
-	bool operator== (cga::store_iterator_impl<T, U> const &) const override;
-	bool is_end_sentinal () const override;
-	void fill (std::pair<T, U> &) const override;
-	void clear ();
-	cga::mdb_merge_iterator<T, U> & operator= (cga::mdb_merge_iterator<T, U> &&) = default;
-	cga::mdb_merge_iterator<T, U> & operator= (cga::mdb_merge_iterator<T, U> const &) = delete;
+	mdb_write_queue (cga::mdb_env &, std::chrono::milliseconds, size_t);
+	~mdb_write_queue ();
+	std::future<void> add (std::function<void(cga::transaction const &)> const &);
+	void stop ();
+	std::chrono::milliseconds const max_latency;
+	size_t const max_ops;
 
 private:
-	cga::mdb_iterator<T, U> & least_iterator () const;
-	std::unique_ptr<cga::mdb_iterator<T, U>> impl1;
-	std::unique_ptr<cga::mdb_iterator<T, U>> impl2;
+	class entry
+	{
+	public:
+		std::function<void(cga::transaction const &)> action;
+		std::promise<void> promise;
+		std::chrono::steady_clock::time_point added;
+	};
+	void run ();
+	void commit (std::deque<entry> &);
+	cga::mdb_env & env;
+	std::deque<entry> queue;
+	bool stopped;
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::thread thread;
 };
-
-class logging;
 /**
  * mdb implementation of the block store
  */
@@ -150,19 +202,23 @@ class mdb_store : public block_store
 	friend class cga::block_predecessor_set;
 
 public:
-	mdb_store (bool &, cga::logging &, boost::filesystem::path const &, int lmdb_max_dbs = 128, bool drop_unchecked = false, size_t batch_size = 512);
+	mdb_store (bool &, cga::logging &, cga::stat &, boost::filesystem::path const &, int lmdb_max_dbs = 128, bool drop_unchecked = false, size_t batch_size = 512, std::chrono::milliseconds write_queue_max_latency = std::chrono::milliseconds (10), size_t write_queue_max_ops = 1024);
 	~mdb_store ();
 
 	cga::transaction tx_begin_write () override;
 	cga::transaction tx_begin_read () override;
 	cga::transaction tx_begin (bool write = false) override;
 
+	std::future<void> tx_queue_write (std::function<void(cga::transaction const &)> const &) override;
+	void tx_queue_stop () override;
+
 	void initialize (cga::transaction const &, cga::genesis const &) override;
 	void block_put (cga::transaction const &, cga::block_hash const &, cga::block const &, cga::block_sideband const &, cga::epoch version = cga::epoch::epoch_0) override;
 	size_t block_successor_offset (cga::transaction const &, MDB_val, cga::block_type);
 	cga::block_hash block_successor (cga::transaction const &, cga::block_hash const &) override;
 	void block_successor_clear (cga::transaction const &, cga::block_hash const &) override;
 	std::shared_ptr<cga::block> block_get (cga::transaction const &, cga::block_hash const &, cga::block_sideband * = nullptr) override;
+	bool block_view_get (cga::transaction const &, cga::block_hash const &, cga::block_view &) override;
 	std::shared_ptr<cga::block> block_random (cga::transaction const &) override;
 	void block_del (cga::transaction const &, cga::block_hash const &) override;
 	bool block_exists (cga::transaction const &, cga::block_hash const &) override;
@@ -171,6 +227,10 @@ public:
 	bool root_exists (cga::transaction const &, cga::uint256_union const &) override;
 	bool source_exists (cga::transaction const &, cga::block_hash const &) override;
 	cga::account block_account (cga::transaction const &, cga::block_hash const &) override;
+	void block_prune (cga::transaction const &, cga::block_hash const &) override;
+	bool pruned_exists (cga::transaction const &, cga::block_hash const &) override;
+	bool pruned_get (cga::transaction const &, cga::block_hash const &, cga::block_info &) override;
+	size_t pruned_count (cga::transaction const &) override;
 
 	void frontier_put (cga::transaction const &, cga::block_hash const &, cga::account const &) override;
 	cga::account frontier_get (cga::transaction const &, cga::block_hash const &) override;
@@ -181,12 +241,6 @@ public:
 	void account_del (cga::transaction const &, cga::account const &) override;
 	bool account_exists (cga::transaction const &, cga::account const &) override;
 	size_t account_count (cga::transaction const &) override;
-	cga::store_iterator<cga::account, cga::account_info> latest_v0_begin (cga::transaction const &, cga::account const &) override;
-	cga::store_iterator<cga::account, cga::account_info> latest_v0_begin (cga::transaction const &) override;
-	cga::store_iterator<cga::account, cga::account_info> latest_v0_end () override;
-	cga::store_iterator<cga::account, cga::account_info> latest_v1_begin (cga::transaction const &, cga::account const &) override;
-	cga::store_iterator<cga::account, cga::account_info> latest_v1_begin (cga::transaction const &) override;
-	cga::store_iterator<cga::account, cga::account_info> latest_v1_end () override;
 	cga::store_iterator<cga::account, cga::account_info> latest_begin (cga::transaction const &, cga::account const &) override;
 	cga::store_iterator<cga::account, cga::account_info> latest_begin (cga::transaction const &) override;
 	cga::store_iterator<cga::account, cga::account_info> latest_end () override;
@@ -195,16 +249,15 @@ public:
 	void pending_del (cga::transaction const &, cga::pending_key const &) override;
 	bool pending_get (cga::transaction const &, cga::pending_key const &, cga::pending_info &) override;
 	bool pending_exists (cga::transaction const &, cga::pending_key const &) override;
-	cga::store_iterator<cga::pending_key, cga::pending_info> pending_v0_begin (cga::transaction const &, cga::pending_key const &) override;
-	cga::store_iterator<cga::pending_key, cga::pending_info> pending_v0_begin (cga::transaction const &) override;
-	cga::store_iterator<cga::pending_key, cga::pending_info> pending_v0_end () override;
-	cga::store_iterator<cga::pending_key, cga::pending_info> pending_v1_begin (cga::transaction const &, cga::pending_key const &) override;
-	cga::store_iterator<cga::pending_key, cga::pending_info> pending_v1_begin (cga::transaction const &) override;
-	cga::store_iterator<cga::pending_key, cga::pending_info> pending_v1_end () override;
 	cga::store_iterator<cga::pending_key, cga::pending_info> pending_begin (cga::transaction const &, cga::pending_key const &) override;
 	cga::store_iterator<cga::pending_key, cga::pending_info> pending_begin (cga::transaction const &) override;
 	cga::store_iterator<cga::pending_key, cga::pending_info> pending_end () override;
 
+	void delegator_put (cga::transaction const &, cga::delegator_key const &) override;
+	void delegator_del (cga::transaction const &, cga::delegator_key const &) override;
+	cga::store_iterator<cga::delegator_key, cga::no_value> delegators_begin (cga::transaction const &, cga::delegator_key const &) override;
+	cga::store_iterator<cga::delegator_key, cga::no_value> delegators_end () override;
+
 	bool block_info_get (cga::transaction const &, cga::block_hash const &, cga::block_info &) override;
 	cga::uint128_t block_balance (cga::transaction const &, cga::block_hash const &) override;
 	cga::epoch block_version (cga::transaction const &, cga::block_hash const &) override;
@@ -266,6 +319,12 @@ public:
 	void upgrade_v11_to_v12 (cga::transaction const &);
 	void do_slow_upgrades (size_t const);
 	void upgrade_v12_to_v13 (size_t const);
+	void upgrade_v13_to_v14 (cga::transaction const &);
+	void upgrade_v14_to_v15 (size_t const);
+	void upgrade_v15_to_v16 (cga::transaction const &);
+	void upgrade_v16_to_v17 (cga::transaction const &);
+	// Moves entries out of the epoch 1 account and pending tables, runs before any slow upgrade so they only ever see the merged tables
+	void merge_epoch_tables (cga::transaction const &);
 	bool full_sideband (cga::transaction const &);
 
 	// Requires a write transaction
@@ -287,8 +346,12 @@ public:
 
 	cga::logging & logging;
 
+	cga::stat & stats;
+
 	cga::mdb_env env;
 
+	cga::mdb_write_queue write_queue;
+
 	/**
 	 * Maps head block to owning account
 	 * cga::block_hash -> cga::account
@@ -296,17 +359,24 @@ public:
 	MDB_dbi frontiers{ 0 };
 
 	/**
-	 * Maps account v1 to account information, head, rep, open, balance, timestamp and block count.
-	 * cga::account -> cga::block_hash, cga::block_hash, cga::block_hash, cga::amount, uint64_t, uint64_t
+	 * Maps account to account information, head, rep, open, balance, timestamp, block count, confirmation height and epoch.
+	 * cga::account -> cga::block_hash, cga::block_hash, cga::block_hash, cga::amount, uint64_t, uint64_t, uint64_t, cga::epoch (uint8_t)
 	 */
-	MDB_dbi accounts_v0{ 0 };
+	MDB_dbi accounts{ 0 };
 
 	/**
-	 * Maps account v0 to account information, head, rep, open, balance, timestamp and block count.
-	 * cga::account -> cga::block_hash, cga::block_hash, cga::block_hash, cga::amount, uint64_t, uint64_t
+	 * Epoch 1 accounts from before version 16, emptied into accounts by the upgrade.
+	 * cga::account -> cga::block_hash, cga::block_hash, cga::block_hash, cga::amount, uint64_t, uint64_t, uint64_t
 	 */
 	MDB_dbi accounts_v1{ 0 };
 
+	/**
+	 * Maps block hash to block type, epoch, block and sideband. Replaces the per type tables below, which are
+	 * only used until the version 15 upgrade has moved their blocks here.
+	 * cga::block_hash -> cga::block_type (uint8_t), cga::epoch (uint8_t), cga::block, cga::block_sideband
+	 */
+	MDB_dbi blocks{ 0 };
+
 	/**
 	 * Maps block hash to send block.
 	 * cga::block_hash -> cga::send_block
@@ -344,13 +414,13 @@ public:
 	MDB_dbi state_blocks_v1{ 0 };
 
 	/**
-	 * Maps min_version 0 (destination account, pending block) to (source account, amount).
-	 * cga::account, cga::block_hash -> cga::account, cga::amount
+	 * Maps (destination account, pending block) to (source account, amount, min_version).
+	 * cga::account, cga::block_hash -> cga::account, cga::amount, cga::epoch (uint8_t)
 	 */
-	MDB_dbi pending_v0{ 0 };
+	MDB_dbi pending{ 0 };
 
 	/**
-	 * Maps min_version 1 (destination account, pending block) to (source account, amount).
+	 * Min_version 1 pending entries from before version 16, emptied into pending by the upgrade.
 	 * cga::account, cga::block_hash -> cga::account, cga::amount
 	 */
 	MDB_dbi pending_v1{ 0 };
@@ -397,19 +467,62 @@ public:
 	*/
 	MDB_dbi peers{ 0 };
 
+	/**
+	 * Index of accounts by the representative their rep_block names, maintained by ledger::change_latest.
+	 * cga::account, cga::account -> no_value
+	 */
+	MDB_dbi delegators{ 0 };
+
+	/**
+	 * Blocks whose bodies were removed by ledger pruning.
+	 * cga::block_hash -> cga::account, cga::amount, cga::epoch (uint8_t)
+	 */
+	MDB_dbi pruned{ 0 };
+
 private:
 	bool entry_has_sideband (MDB_val, cga::block_type);
 	cga::account block_account_computed (cga::transaction const &, cga::block_hash const &);
 	cga::uint128_t block_balance_computed (cga::transaction const &, cga::block_hash const &);
 	MDB_dbi block_database (cga::block_type, cga::epoch);
-	template <typename T>
 	std::shared_ptr<cga::block> block_random (cga::transaction const &, MDB_dbi);
 	MDB_val block_raw_get (cga::transaction const &, cga::block_hash const &, cga::block_type &);
 	boost::optional<MDB_val> block_raw_get_by_type (cga::transaction const &, cga::block_hash const &, cga::block_type &);
 	void block_raw_put (cga::transaction const &, MDB_dbi, cga::block_hash const &, MDB_val);
+	void block_write (cga::transaction const &, cga::block_hash const &, cga::block const &, cga::block_sideband const &, cga::epoch);
+	void block_successor_put (cga::transaction const &, cga::block_hash const &, cga::block_hash const &);
+	cga::block_counts block_count_legacy (cga::transaction const &);
+	cga::block_counts block_counts_get (cga::transaction const &);
+	void block_counts_put (cga::transaction const &, cga::block_counts const &);
+	cga::cuckoo_filter block_filter_build (cga::transaction const &, size_t);
+	void block_filter_rebuild (size_t);
+	bool block_filter_may_contain (cga::block_hash const &);
+	void block_filter_erase (cga::block_hash const &, uint64_t);
+	void block_filter_observe (bool);
 	void clear (MDB_dbi);
 	std::atomic<bool> stopped{ false };
 	std::thread upgrades;
+	// Set on startup if the per type block tables may still hold blocks. They stay consulted until restart even once emptied,
+	// readers with a snapshot from before the last upgrade batch could otherwise miss blocks
+	bool legacy_block_tables{ true };
+	/**
+	 * Approximate membership of every hash in the block tables so lookups for blocks we don't have skip LMDB.
+	 * Built once upgrades are done. A put is inserted inside the write transaction and taken out again if it aborts,
+	 * readers can only see that as a false positive. A delete is erased once it commits.
+	 * Once full it is disabled, sending every lookup to LMDB, while a larger one is built in the background.
+	 */
+	cga::cuckoo_filter block_filter{ 0 };
+	std::shared_timed_mutex block_filter_mutex;
+	std::atomic<bool> block_filter_enabled{ false };
+	// Bumped each time a rebuilt filter is swapped in
+	uint64_t block_filter_generation{ 0 };
+	// Hashes put while rebuilding, the rebuild's snapshot may predate them. Erases are dropped which only costs false positives
+	std::vector<cga::block_hash> block_filter_pending;
+	bool block_filter_rebuilding{ false };
+	std::thread block_filter_rebuilder;
+	// Outcomes accumulated here and moved into stats on flush, so lookups don't contend on the stats mutex
+	std::atomic<uint64_t> block_filter_negatives{ 0 };
+	std::atomic<uint64_t> block_filter_positives{ 0 };
+	std::atomic<uint64_t> block_filter_false_positives{ 0 };
 };
 class wallet_value
 {
@@ -0,0 +1,473 @@
+#include <cga/node/metrics.hpp>
+
+#include <cga/node/node.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+uint16_t constexpr cga::metrics_config::metrics_port;
+std::chrono::seconds constexpr cga::metrics_server::timeout;
+size_t constexpr cga::metrics_server::request_max;
+
+cga::error cga::metrics_config::serialize_json (cga::jsonconfig & json) const
+{
+	json.put ("enable", enabled);
+	json.put ("address", address.to_string ());
+	json.put ("port", port);
+	return json.get_error ();
+}
+
+cga::error cga::metrics_config::deserialize_json (cga::jsonconfig & json)
+{
+	json.get_optional<bool> ("enable", enabled);
+	json.get_optional<boost::asio::ip::address_v6> ("address", address);
+	json.get_optional<uint16_t> ("port", port);
+	return json.get_error ();
+}
+
+cga::openmetrics_writer::openmetrics_writer (std::string & buffer_a) :
+buffer (buffer_a),
+labels (false)
+{
+}
+
+void cga::openmetrics_writer::family (char const * name_a, char const * type_a, char const * help_a)
+{
+	append ("# TYPE ");
+	append (name_a);
+	append (" ");
+	append (type_a);
+	append ("\n# HELP ");
+	append (name_a);
+	append (" ");
+	append (help_a);
+	append ("\n");
+}
+
+cga::openmetrics_writer & cga::openmetrics_writer::sample (char const * name_a, char const * suffix_a)
+{
+	append (name_a);
+	append (suffix_a);
+	labels = false;
+	return *this;
+}
+
+cga::openmetrics_writer & cga::openmetrics_writer::label (char const * name_a, char const * value_a)
+{
+	append (labels ? "," : "{");
+	labels = true;
+	append (name_a);
+	append ("=\"");
+	append_escaped (value_a, std::strlen (value_a));
+	append ("\"");
+	return *this;
+}
+
+cga::openmetrics_writer & cga::openmetrics_writer::label (char const * name_a, std::string const & value_a)
+{
+	append (labels ? "," : "{");
+	labels = true;
+	append (name_a);
+	append ("=\"");
+	append_escaped (value_a.data (), value_a.size ());
+	append ("\"");
+	return *this;
+}
+
+void cga::openmetrics_writer::value (uint64_t value_a)
+{
+	append (labels ? "} " : " ");
+	// Digits are produced from the least significant end
+	std::array<char, 20> digits;
+	auto position (digits.size ());
+	do
+	{
+		digits[--position] = static_cast<char> ('0' + value_a % 10);
+		value_a /= 10;
+	} while (value_a != 0);
+	append (digits.data () + position, digits.size () - position);
+	append ("\n");
+}
+
+void cga::openmetrics_writer::value (double value_a)
+{
+	append (labels ? "} " : " ");
+	std::array<char, 64> text;
+	// Exponent form keeps very large values within the buffer
+	auto size (std::snprintf (text.data (), text.size (), "%.10g", value_a));
+	if (size > 0)
+	{
+		append (text.data (), std::min (static_cast<size_t> (size), text.size () - 1));
+	}
+	append ("\n");
+}
+
+void cga::openmetrics_writer::eof ()
+{
+	append ("# EOF\n");
+}
+
+void cga::openmetrics_writer::append (char const * text_a)
+{
+	buffer.append (text_a);
+}
+
+void cga::openmetrics_writer::append (char const * text_a, size_t size_a)
+{
+	buffer.append (text_a, size_a);
+}
+
+void cga::openmetrics_writer::append_escaped (char const * text_a, size_t size_a)
+{
+	for (auto i (text_a), n (text_a + size_a); i != n; ++i)
+	{
+		switch (*i)
+		{
+			case '\\':
+				append ("\\\\");
+				break;
+			case '"':
+				append ("\\\"");
+				break;
+			case '\n':
+				append ("\\n");
+				break;
+			default:
+				buffer.push_back (*i);
+				break;
+		}
+	}
+}
+
+namespace
+{
+/** Writes counters and histogram summaries as samples of the metric family written before logging them */
+class openmetrics_sink : public cga::stat_log_sink
+{
+public:
+	openmetrics_sink (cga::openmetrics_writer & writer_a) :
+	writer (writer_a),
+	stream (nullptr)
+	{
+	}
+
+	// Everything goes through the writer, the stream has no buffer and discards anything written to it
+	std::ostream & out () override
+	{
+		return stream;
+	}
+
+	void write_entry (tm & tm, std::string type, std::string detail, std::string dir, uint64_t value) override
+	{
+		writer.sample ("cga_stat", "_total").label ("type", type).label ("detail", detail).label ("dir", dir).value (value);
+	}
+
+	void write_histogram (tm & tm, std::string name, cga::stat_histogram const & histogram) override
+	{
+		static std::array<std::pair<char const *, double>, 4> const quantiles{ { { "0.5", 0.5 }, { "0.9", 0.9 }, { "0.99", 0.99 }, { "0.999", 0.999 } } };
+		for (auto & quantile : quantiles)
+		{
+			writer.sample ("cga_latency_microseconds").label ("histogram", name).label ("quantile", quantile.first).value (histogram.quantile (quantile.second));
+		}
+		writer.sample ("cga_latency_microseconds", "_sum").label ("histogram", name).value (histogram.sum ());
+		writer.sample ("cga_latency_microseconds", "_count").label ("histogram", name).value (histogram.count ());
+	}
+
+private:
+	cga::openmetrics_writer & writer;
+	std::ostream stream;
+};
+
+void gauge (cga::openmetrics_writer & writer_a, char const * name_a, char const * help_a, uint64_t value_a)
+{
+	writer_a.family (name_a, "gauge", help_a);
+	writer_a.sample (name_a).value (value_a);
+}
+}
+
+cga::metrics_server::metrics_server (cga::node & node_a, cga::metrics_config const & config_a) :
+node (node_a),
+config (config_a),
+acceptor (node_a.io_ctx),
+socket (node_a.io_ctx),
+deadline (node_a.io_ctx),
+request (request_max),
+on (false)
+{
+}
+
+void cga::metrics_server::start ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	auto endpoint (cga::tcp_endpoint (config.address, config.port));
+	boost::system::error_code ec;
+	acceptor.open (endpoint.protocol (), ec);
+	if (!ec)
+	{
+		acceptor.set_option (boost::asio::ip::tcp::acceptor::reuse_address (true), ec);
+	}
+	if (!ec)
+	{
+		acceptor.bind (endpoint, ec);
+	}
+	if (!ec)
+	{
+		acceptor.listen (boost::asio::socket_base::max_listen_connections, ec);
+	}
+	if (!ec)
+	{
+		on = true;
+		accept ();
+	}
+	else
+	{
+		BOOST_LOG (node.log) << boost::str (boost::format ("Error while binding for metrics on port %1%: %2%") % endpoint.port () % ec.message ());
+		boost::system::error_code ignored;
+		acceptor.close (ignored);
+	}
+}
+
+void cga::metrics_server::stop ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	on = false;
+	boost::system::error_code ignored;
+	acceptor.close (ignored);
+	socket.close (ignored);
+	deadline.cancel (ignored);
+}
+
+void cga::metrics_server::accept ()
+{
+	assert (!mutex.try_lock ());
+	acceptor.async_accept (socket, [this](boost::system::error_code const & ec) {
+		std::lock_guard<std::mutex> lock (mutex);
+		if (on)
+		{
+			if (!ec)
+			{
+				deadline.expires_after (timeout);
+				deadline.async_wait ([this](boost::system::error_code const & ec) {
+					std::lock_guard<std::mutex> lock (mutex);
+					// A wait which completed just before the timer was restarted for the next connection leaves it alone
+					if (!ec && deadline.expiry () <= std::chrono::steady_clock::now ())
+					{
+						boost::system::error_code ignored;
+						socket.close (ignored);
+					}
+				});
+				receive ();
+			}
+			else
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Error accepting metrics connection: %1%") % ec.message ());
+				accept ();
+			}
+		}
+	});
+}
+
+void cga::metrics_server::receive ()
+{
+	assert (!mutex.try_lock ());
+	boost::asio::async_read_until (socket, request, "\r\n\r\n", [this](boost::system::error_code const & ec, size_t size_a) {
+		if (!ec)
+		{
+			respond ();
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			close ();
+		}
+	});
+}
+
+void cga::metrics_server::respond ()
+{
+	// Only the request line matters, any query string and headers are ignored
+	auto data (static_cast<char const *> (request.data ().data ()));
+	auto size (request.data ().size ());
+	auto found (size > 4 && std::memcmp (data, "GET ", 4) == 0);
+	if (found)
+	{
+		auto target (data + 4);
+		auto target_end (target);
+		while (target_end != data + size && *target_end != ' ' && *target_end != '?')
+		{
+			++target_end;
+		}
+		auto target_size (static_cast<size_t> (target_end - target));
+		found = (target_size == 1 && *target == '/') || (target_size == 8 && std::memcmp (target, "/metrics", 8) == 0);
+	}
+	if (found)
+	{
+		render (body);
+	}
+	else
+	{
+		body.assign ("Not found\n");
+	}
+	header.assign (found ? "HTTP/1.1 200 OK\r\nContent-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n" : "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\n");
+	header.append ("Content-Length: ");
+	header.append (std::to_string (body.size ()));
+	header.append ("\r\nConnection: close\r\n\r\n");
+	std::lock_guard<std::mutex> lock (mutex);
+	if (on)
+	{
+		std::array<boost::asio::const_buffer, 2> buffers{ { boost::asio::buffer (header), boost::asio::buffer (body) } };
+		boost::asio::async_write (socket, buffers, [this](boost::system::error_code const & ec, size_t size_a) {
+			std::lock_guard<std::mutex> lock (mutex);
+			close ();
+		});
+	}
+}
+
+void cga::metrics_server::close ()
+{
+	assert (!mutex.try_lock ());
+	boost::system::error_code ignored;
+	deadline.cancel (ignored);
+	socket.shutdown (boost::asio::ip::tcp::socket::shutdown_both, ignored);
+	socket.close (ignored);
+	request.consume (request.size ());
+	if (on)
+	{
+		accept ();
+	}
+}
+
+void cga::metrics_server::render (std::string & buffer_a)
+{
+	buffer_a.clear ();
+	cga::openmetrics_writer writer (buffer_a);
+	openmetrics_sink sink (writer);
+	writer.family ("cga_stat", "counter", "Node statistics counters, only those which are not zero");
+	node.stats.log_counters (sink);
+	writer.family ("cga_latency_microseconds", "summary", "Node latency histograms");
+	node.stats.log_histograms (sink);
+
+	writer.family ("cga_queue_depth", "gauge", "Items waiting to be processed");
+	writer.sample ("cga_queue_depth").label ("queue", "block_processor").value (static_cast<uint64_t> (node.block_processor.size ()));
+	writer.sample ("cga_queue_depth").label ("queue", "vote_processor").value (static_cast<uint64_t> (node.vote_processor.size ()));
+	writer.sample ("cga_queue_depth").label ("queue", "udp_buffer").value (static_cast<uint64_t> (node.network.buffer_container.size ()));
+	writer.sample ("cga_queue_depth").label ("queue", "alarm").value (static_cast<uint64_t> (node.alarm.size ()));
+	gauge (writer, "cga_udp_buffer_capacity", "Buffers available for received UDP packets", node.network.buffer_container.capacity ());
+
+	auto containers (collect_seq_con_info (node, "node"));
+	writer.family ("cga_container_entries", "gauge", "Entries held in node containers");
+	render_containers (writer, *containers, false);
+	writer.family ("cga_container_bytes", "gauge", "Estimated memory used by entries in node containers");
+	render_containers (writer, *containers, true);
+
+	auto store_l (dynamic_cast<cga::mdb_store *> (&node.store));
+	if (store_l != nullptr)
+	{
+		MDB_envinfo info;
+		MDB_stat stat;
+		if (!mdb_env_info (store_l->env, &info) && !mdb_env_stat (store_l->env, &stat))
+		{
+			gauge (writer, "cga_lmdb_map_bytes", "Size of the LMDB memory map", info.me_mapsize);
+			gauge (writer, "cga_lmdb_used_bytes", "Pages in use by the LMDB environment", (info.me_last_pgno + 1) * static_cast<uint64_t> (stat.ms_psize));
+			gauge (writer, "cga_lmdb_transaction_id", "Last committed LMDB transaction", info.me_last_txnid);
+			gauge (writer, "cga_lmdb_readers", "LMDB reader table slots in use", info.me_numreaders);
+			gauge (writer, "cga_lmdb_readers_max", "LMDB reader table size", info.me_maxreaders);
+		}
+	}
+
+	render_threads (writer);
+	writer.eof ();
+}
+
+void cga::metrics_server::render_containers (cga::openmetrics_writer & writer_a, cga::seq_con_info_component const & component_a, bool bytes_a)
+{
+	auto size (container_path.size ());
+	if (!component_a.is_composite ())
+	{
+		auto & info (static_cast<cga::seq_con_info_leaf const &> (component_a).get_info ());
+		container_path.append (info.name);
+		writer_a.sample (bytes_a ? "cga_container_bytes" : "cga_container_entries").label ("container", container_path).value (static_cast<uint64_t> (bytes_a ? info.count * info.sizeof_element : info.count));
+	}
+	else
+	{
+		auto & composite (static_cast<cga::seq_con_info_composite const &> (component_a));
+		container_path.append (composite.get_name ());
+		container_path.push_back ('/');
+		for (auto & child : composite.get_children ())
+		{
+			render_containers (writer_a, *child, bytes_a);
+		}
+	}
+	container_path.resize (size);
+}
+
+void cga::metrics_server::render_threads (cga::openmetrics_writer & writer_a)
+{
+#if defined(__linux__)
+	// Threads are summed by name, so series don't change as threads come and go
+	threads.clear ();
+	auto directory (opendir ("/proc/self/task"));
+	if (directory != nullptr)
+	{
+		std::array<char, sizeof ("/proc/self/task//stat") + NAME_MAX> path;
+		std::array<char, 512> stat;
+		for (auto entry (readdir (directory)); entry != nullptr; entry = readdir (directory))
+		{
+			if (entry->d_name[0] != '.')
+			{
+				std::snprintf (path.data (), path.size (), "/proc/self/task/%s/stat", entry->d_name);
+				auto file (::open (path.data (), O_RDONLY));
+				if (file >= 0)
+				{
+					auto size (::read (file, stat.data (), stat.size () - 1));
+					::close (file);
+					stat[size > 0 ? size : 0] = '\0';
+					// The name is in parentheses and may contain anything, fields after the last parenthesis are all numeric
+					auto name_begin (std::strchr (stat.data (), '('));
+					auto name_end (std::strrchr (stat.data (), ')'));
+					unsigned long user;
+					unsigned long system;
+					if (name_begin != nullptr && name_end != nullptr && name_begin < name_end && std::sscanf (name_end + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &user, &system) == 2)
+					{
+						thread_times times;
+						auto name_size (std::min (static_cast<size_t> (name_end - name_begin - 1), times.name.size () - 1));
+						std::memcpy (times.name.data (), name_begin + 1, name_size);
+						times.name[name_size] = '\0';
+						auto existing (std::find_if (threads.begin (), threads.end (), [&times](thread_times const & item_a) {
+							return std::strcmp (item_a.name.data (), times.name.data ()) == 0;
+						}));
+						if (existing != threads.end ())
+						{
+							existing->user += user;
+							existing->system += system;
+						}
+						else
+						{
+							times.user = user;
+							times.system = system;
+							threads.push_back (times);
+						}
+					}
+				}
+			}
+		}
+		closedir (directory);
+	}
+	auto ticks (static_cast<double> (sysconf (_SC_CLK_TCK)));
+	// Summed over the threads alive now, so it drops when a thread exits and can't be a counter
+	writer_a.family ("cga_thread_cpu_seconds", "gauge", "CPU time used by running node threads, summed over threads with the same name");
+	for (auto & times : threads)
+	{
+		writer_a.sample ("cga_thread_cpu_seconds").label ("thread", times.name.data ()).label ("mode", "user").value (times.user / ticks);
+		writer_a.sample ("cga_thread_cpu_seconds").label ("thread", times.name.data ()).label ("mode", "system").value (times.system / ticks);
+	}
+#endif
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cga/lib/config.hpp>
+#include <cga/lib/errors.hpp>
+#include <cga/lib/jsonconfig.hpp>
+
+#include <boost/asio.hpp>
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cga
+{
+class node;
+class seq_con_info_component;
+
+/** Scrape endpoint configuration */
+class metrics_config
+{
+public:
+	cga::error serialize_json (cga::jsonconfig &) const;
+	cga::error deserialize_json (cga::jsonconfig &);
+	bool enabled{ false };
+	boost::asio::ip::address_v6 address{ boost::asio::ip::address_v6::loopback () };
+	uint16_t port{ metrics_port };
+	static uint16_t constexpr metrics_port = cga::is_live_network ? 7133 : 55001;
+};
+
+/**
+ * Appends OpenMetrics text to a buffer. The writer itself allocates nothing once the buffer has grown to the size
+ * of a scrape, so the buffer should be kept and cleared between scrapes.
+ */
+class openmetrics_writer
+{
+public:
+	openmetrics_writer (std::string &);
+	/** Writes the metadata for a metric family, its samples must follow before the next family */
+	void family (char const * name, char const * type, char const * help);
+	/** Starts a sample, followed by any number of labels then exactly one value */
+	cga::openmetrics_writer & sample (char const * name, char const * suffix = "");
+	cga::openmetrics_writer & label (char const * name, char const * value);
+	cga::openmetrics_writer & label (char const * name, std::string const & value);
+	void value (uint64_t);
+	void value (double);
+	void eof ();
+
+private:
+	void append (char const *);
+	void append (char const *, size_t);
+	void append_escaped (char const *, size_t);
+	std::string & buffer;
+	bool labels;
+};
+
+/**
+ * Serves a plain HTTP endpoint rendering node metrics in the OpenMetrics text format for Prometheus,
+ * without going through the RPC server or building a property tree.
+ * Scrapes are served one connection at a time so the socket and buffers are reused from one scrape to the next.
+ */
+class metrics_server
+{
+public:
+	metrics_server (cga::node &, cga::metrics_config const &);
+	void start ();
+	void stop ();
+	/**
+	 * Replaces the contents of the buffer with the current metrics. Container sizes are read through
+	 * collect_seq_con_info, which builds its tree on the heap for every scrape
+	 */
+	void render (std::string &);
+
+private:
+	class thread_times
+	{
+	public:
+		std::array<char, 16> name;
+		uint64_t user;
+		uint64_t system;
+	};
+	void accept ();
+	void receive ();
+	void respond ();
+	void close ();
+	void render_containers (cga::openmetrics_writer &, cga::seq_con_info_component const &, bool);
+	void render_threads (cga::openmetrics_writer &);
+	cga::node & node;
+	cga::metrics_config const & config;
+	boost::asio::ip::tcp::acceptor acceptor;
+	boost::asio::ip::tcp::socket socket;
+	boost::asio::steady_timer deadline;
+	boost::asio::streambuf request;
+	std::string header;
+	std::string body;
+	// Path of the container being rendered, kept to reuse its capacity
+	std::string container_path;
+	std::vector<thread_times> threads;
+	std::mutex mutex;
+	bool on;
+	static std::chrono::seconds constexpr timeout = std::chrono::seconds (5);
+	static size_t constexpr request_max = 8 * 1024;
+};
+}
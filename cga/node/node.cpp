@@ -14,6 +14,12 @@
 #include <boost/polymorphic_cast.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#if defined(__linux__)
+// Drain and flush datagrams in bursts with recvmmsg/sendmmsg, other platforms use one asio operation per datagram
+#define CGA_UDP_MMSG 1
+#include <sys/socket.h>
+#endif
+
 double constexpr cga::node::price_max;
 double constexpr cga::node::free_cutoff;
 std::chrono::seconds constexpr cga::node::period;
@@ -24,15 +30,23 @@ std::chrono::seconds constexpr cga::node::search_pending_interval;
 std::chrono::seconds constexpr cga::node::peer_interval;
 std::chrono::hours constexpr cga::node::unchecked_cleanup_interval;
 std::chrono::milliseconds constexpr cga::node::process_confirmed_interval;
+std::chrono::seconds constexpr cga::node::pruning_interval;
+size_t constexpr cga::node::pruning_batch_size;
 
 int constexpr cga::port_mapping::mapping_timeout;
 int constexpr cga::port_mapping::check_timeout;
 unsigned constexpr cga::active_transactions::request_interval_ms;
 size_t constexpr cga::active_transactions::max_broadcast_queue;
+size_t constexpr cga::active_transactions::partitions_count;
+size_t constexpr cga::network::max_burst;
 size_t constexpr cga::block_arrival::arrival_size_min;
 std::chrono::seconds constexpr cga::block_arrival::arrival_time_min;
 uint64_t constexpr cga::online_reps::weight_period;
 uint64_t constexpr cga::online_reps::weight_samples;
+size_t constexpr cga::vote_processor::max_votes_level_0;
+size_t constexpr cga::vote_processor::max_votes_level_1;
+size_t constexpr cga::vote_processor::max_votes_level_2;
+size_t constexpr cga::vote_processor::max_votes_level_3;
 
 namespace cga
 {
@@ -43,6 +57,7 @@ extern size_t cga_bootstrap_weights_size;
 cga::network::network (cga::node & node_a, uint16_t port) :
 buffer_container (node_a.stats, cga::network::buffer_size, 4096), // 2Mb receive buffer
 socket (node_a.io_ctx, cga::endpoint (boost::asio::ip::address_v6::any (), port)),
+send_flush_scheduled (false),
 resolver (node_a.io_ctx),
 node (node_a),
 on (true)
@@ -107,12 +122,44 @@ void cga::network::receive ()
 	{
 		BOOST_LOG (node.log) << "Receiving packet";
 	}
+#if CGA_UDP_MMSG
+	std::unique_lock<std::mutex> lock (socket_mutex);
+	socket.async_wait (boost::asio::ip::udp::socket::wait_read, [this](boost::system::error_code const & error_a) {
+		auto error (error_a);
+		if (!error && this->on)
+		{
+			error = this->receive_batch ();
+		}
+		if (!error && this->on)
+		{
+			this->receive ();
+		}
+		else
+		{
+			if (error)
+			{
+				if (this->node.config.logging.network_logging ())
+				{
+					BOOST_LOG (this->node.log) << boost::str (boost::format ("UDP Receive error: %1%") % error.message ());
+				}
+			}
+			if (this->on)
+			{
+				this->node.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [this]() { this->receive (); });
+			}
+		}
+	});
+#else
 	std::unique_lock<std::mutex> lock (socket_mutex);
 	auto data (buffer_container.allocate ());
 	socket.async_receive_from (boost::asio::buffer (data->buffer, cga::network::buffer_size), data->endpoint, [this, data](boost::system::error_code const & error, size_t size_a) {
 		if (!error && this->on)
 		{
 			data->size = size_a;
+			if (this->node.tracer.enabled ())
+			{
+				data->arrival = std::chrono::steady_clock::now ();
+			}
 			this->buffer_container.enqueue (data);
 			this->receive ();
 		}
@@ -132,21 +179,90 @@ void cga::network::receive ()
 			}
 		}
 	});
+#endif
 }
 
+#if CGA_UDP_MMSG
+boost::system::error_code cga::network::receive_batch ()
+{
+	boost::system::error_code result;
+	std::vector<cga::udp_data *> slots;
+	auto stolen (buffer_container.allocate (slots, max_burst));
+	std::array<mmsghdr, max_burst> messages;
+	std::array<iovec, max_burst> vectors;
+	for (size_t i (0); i < slots.size (); ++i)
+	{
+		auto data (slots[i]);
+		vectors[i] = { data->buffer, cga::network::buffer_size };
+		messages[i] = mmsghdr{};
+		messages[i].msg_hdr.msg_name = data->endpoint.data ();
+		messages[i].msg_hdr.msg_namelen = data->endpoint.capacity ();
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+	int received (0);
+	if (!slots.empty ())
+	{
+		std::lock_guard<std::mutex> lock (socket_mutex);
+		if (socket.is_open ())
+		{
+			received = recvmmsg (socket.native_handle (), messages.data (), slots.size (), MSG_DONTWAIT, nullptr);
+			if (received < 0)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK)
+				{
+					result = boost::system::error_code (errno, boost::system::system_category ());
+				}
+				received = 0;
+			}
+		}
+	}
+	// Only used for tracing, the clock isn't read otherwise
+	auto arrival (node.tracer.enabled () ? std::chrono::steady_clock::now () : std::chrono::steady_clock::time_point ());
+	for (size_t i (0); i < slots.size (); ++i)
+	{
+		auto data (slots[i]);
+		if (i < static_cast<size_t> (received))
+		{
+			data->size = messages[i].msg_len;
+			data->arrival = arrival;
+			data->endpoint.resize (messages[i].msg_hdr.msg_namelen);
+			buffer_container.enqueue (data);
+		}
+		else if (i == 0 && stolen)
+		{
+			// Nothing was read into it, the unserviced packet it held goes back in the queue
+			buffer_container.enqueue (data);
+		}
+		else
+		{
+			buffer_container.release (data);
+		}
+	}
+	if (stolen && received > 0)
+	{
+		node.stats.inc (cga::stat::type::udp, cga::stat::detail::overflow, cga::stat::dir::in);
+	}
+	return result;
+}
+#endif
+
 void cga::network::process_packets ()
 {
 	auto local_endpoint (endpoint ());
+	std::vector<cga::udp_data *> burst;
 	while (on.load ())
 	{
-		auto data (buffer_container.dequeue ());
-		if (data == nullptr)
+		buffer_container.dequeue (burst, max_burst);
+		if (burst.empty ())
 		{
 			break;
 		}
-		//std::cerr << data->endpoint.address ().to_string ();
-		receive_action (data, local_endpoint);
-		buffer_container.release (data);
+		receive_burst (burst, local_endpoint);
+		for (auto data : burst)
+		{
+			buffer_container.release (data);
+		}
 	}
 }
 
@@ -239,14 +355,14 @@ void cga::network::send_node_id_handshake (cga::endpoint const & endpoint_a, boo
 	});
 }
 
-void cga::network::republish (cga::block_hash const & hash_a, std::shared_ptr<std::vector<uint8_t>> buffer_a, cga::endpoint endpoint_a)
+void cga::network::republish (cga::block_hash const & hash_a, std::shared_ptr<cga::wire_message const> const & message_a, cga::endpoint endpoint_a)
 {
 	if (node.config.logging.network_publish_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Publishing %1% to %2%") % hash_a.to_string () % endpoint_a);
 	}
 	std::weak_ptr<cga::node> node_w (node.shared ());
-	send_buffer (buffer_a->data (), buffer_a->size (), endpoint_a, [node_w, endpoint_a](boost::system::error_code const & ec, size_t size) {
+	send_buffer (message_a->data (), message_a->size (), endpoint_a, [message_a, node_w, endpoint_a](boost::system::error_code const & ec, size_t size) {
 		if (auto node_l = node_w.lock ())
 		{
 			if (ec && node_l->config.logging.network_logging ())
@@ -276,13 +392,12 @@ bool confirm_block (cga::transaction const & transaction_a, cga::node & node_a,
 			node_a.wallets.foreach_representative (transaction_a, [&result, &list_a, &node_a, &transaction_a, &hash](cga::public_key const & pub_a, cga::raw_key const & prv_a) {
 				result = true;
 				auto vote (node_a.store.vote_generate (transaction_a, pub_a, prv_a, std::vector<cga::block_hash> (1, hash)));
-				cga::confirm_ack confirm (vote);
-				auto vote_bytes = confirm.to_bytes ();
+				auto message (std::make_shared<cga::wire_message const> (cga::confirm_ack (vote)));
 				for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
 				{
-					node_a.network.confirm_send (confirm, vote_bytes, *j);
+					node_a.network.confirm_send (vote, message, *j);
 				}
-				node_a.votes_cache.add (vote);
+				node_a.votes_cache.add (vote, message);
 			});
 		}
 		else
@@ -290,23 +405,19 @@ bool confirm_block (cga::transaction const & transaction_a, cga::node & node_a,
 			// Send from cache
 			for (auto & vote : votes)
 			{
-				cga::confirm_ack confirm (vote);
-				auto vote_bytes = confirm.to_bytes ();
 				for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
 				{
-					node_a.network.confirm_send (confirm, vote_bytes, *j);
+					node_a.network.confirm_send (vote.first, vote.second, *j);
 				}
 			}
 		}
 		// Republish if required
 		if (also_publish)
 		{
-			cga::publish publish (block_a);
-			std::shared_ptr<std::vector<uint8_t>> publish_bytes;
-			publish_bytes = publish.to_bytes ();
+			auto message (std::make_shared<cga::wire_message const> (cga::publish (block_a)));
 			for (auto j (list_a.begin ()), m (list_a.end ()); j != m; ++j)
 			{
-				node_a.network.republish (hash, publish_bytes, *j);
+				node_a.network.republish (hash, message, *j);
 			}
 		}
 	}
@@ -327,14 +438,9 @@ void cga::network::confirm_hashes (cga::transaction const & transaction_a, cga::
 	{
 		node.wallets.foreach_representative (transaction_a, [this, &blocks_bundle_a, &peer_a, &transaction_a](cga::public_key const & pub_a, cga::raw_key const & prv_a) {
 			auto vote (this->node.store.vote_generate (transaction_a, pub_a, prv_a, blocks_bundle_a));
-			cga::confirm_ack confirm (vote);
-			std::shared_ptr<std::vector<uint8_t>> bytes (new std::vector<uint8_t>);
-			{
-				cga::vectorstream stream (*bytes);
-				confirm.serialize (stream);
-			}
-			this->node.network.confirm_send (confirm, bytes, peer_a);
-			this->node.votes_cache.add (vote);
+			auto message (std::make_shared<cga::wire_message const> (cga::confirm_ack (vote)));
+			this->node.network.confirm_send (vote, message, peer_a);
+			this->node.votes_cache.add (vote, message);
 		});
 	}
 }
@@ -346,9 +452,7 @@ bool cga::network::send_votes_cache (cga::block_hash const & hash_a, cga::endpoi
 	// Send from cache
 	for (auto & vote : votes)
 	{
-		cga::confirm_ack confirm (vote);
-		auto vote_bytes = confirm.to_bytes ();
-		confirm_send (confirm, vote_bytes, peer_a);
+		confirm_send (vote.first, vote.second, peer_a);
 	}
 	// Returns true if votes were sent
 	bool result (!votes.empty ());
@@ -357,13 +461,15 @@ bool cga::network::send_votes_cache (cga::block_hash const & hash_a, cga::endpoi
 
 void cga::network::republish_block (std::shared_ptr<cga::block> block)
 {
-	auto hash (block->hash ());
+	republish_block (block->hash (), std::make_shared<cga::wire_message const> (cga::publish (block)));
+}
+
+void cga::network::republish_block (cga::block_hash const & hash, std::shared_ptr<cga::wire_message const> const & message_a)
+{
 	auto list (node.peers.list_fanout ());
-	cga::publish message (block);
-	auto bytes = message.to_bytes ();
 	for (auto i (list.begin ()), n (list.end ()); i != n; ++i)
 	{
-		republish (hash, bytes, *i);
+		republish (hash, message_a, *i);
 	}
 	if (node.config.logging.network_logging ())
 	{
@@ -374,13 +480,7 @@ void cga::network::republish_block (std::shared_ptr<cga::block> block)
 void cga::network::republish_block (std::shared_ptr<cga::block> block, cga::endpoint const & peer_a)
 {
 	auto hash (block->hash ());
-	cga::publish message (block);
-	std::vector<uint8_t> bytes;
-	{
-		cga::vectorstream stream (bytes);
-		message.serialize (stream);
-	}
-	republish (hash, std::make_shared<std::vector<uint8_t>> (bytes), peer_a);
+	republish (hash, std::make_shared<cga::wire_message const> (cga::publish (block)), peer_a);
 	if (node.config.logging.network_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Block %1% was republished to peer") % hash.to_string ());
@@ -388,10 +488,20 @@ void cga::network::republish_block (std::shared_ptr<cga::block> block, cga::endp
 }
 
 void cga::network::republish_block_batch (std::deque<std::shared_ptr<cga::block>> blocks_a, unsigned delay_a)
+{
+	std::deque<std::pair<cga::block_hash, std::shared_ptr<cga::wire_message const>>> messages;
+	for (auto & block : blocks_a)
+	{
+		messages.emplace_back (block->hash (), std::make_shared<cga::wire_message const> (cga::publish (block)));
+	}
+	republish_block_batch (std::move (messages), delay_a);
+}
+
+void cga::network::republish_block_batch (std::deque<std::pair<cga::block_hash, std::shared_ptr<cga::wire_message const>>> blocks_a, unsigned delay_a)
 {
 	auto block (blocks_a.front ());
 	blocks_a.pop_front ();
-	republish_block (block);
+	republish_block (block.first, block.second);
 	if (!blocks_a.empty ())
 	{
 		std::weak_ptr<cga::node> node_w (node.shared ());
@@ -413,12 +523,11 @@ void cga::network::republish_block_batch (std::deque<std::shared_ptr<cga::block>
 // These rules are implemented by the caller, not this function.
 void cga::network::republish_vote (std::shared_ptr<cga::vote> vote_a)
 {
-	cga::confirm_ack confirm (vote_a);
-	auto bytes = confirm.to_bytes ();
+	auto message (std::make_shared<cga::wire_message const> (cga::confirm_ack (vote_a)));
 	auto list (node.peers.list_fanout ());
 	for (auto j (list.begin ()), m (list.end ()); j != m; ++j)
 	{
-		node.network.confirm_send (confirm, bytes, *j);
+		node.network.confirm_send (vote_a, message, *j);
 	}
 }
 
@@ -448,8 +557,12 @@ void cga::network::broadcast_confirm_req (std::shared_ptr<cga::block> block_a)
 	broadcast_confirm_req_base (block_a, list, 0);
 }
 
-void cga::network::broadcast_confirm_req_base (std::shared_ptr<cga::block> block_a, std::shared_ptr<std::vector<cga::peer_information>> endpoints_a, unsigned delay_a, bool resumption)
+void cga::network::broadcast_confirm_req_base (std::shared_ptr<cga::block> block_a, std::shared_ptr<std::vector<cga::peer_information>> endpoints_a, unsigned delay_a, bool resumption, std::shared_ptr<cga::wire_message const> message_a)
 {
+	if (message_a == nullptr)
+	{
+		message_a = std::make_shared<cga::wire_message const> (cga::confirm_req (block_a));
+	}
 	const size_t max_reps = 10;
 	if (!resumption && node.config.logging.network_logging ())
 	{
@@ -458,7 +571,7 @@ void cga::network::broadcast_confirm_req_base (std::shared_ptr<cga::block> block
 	auto count (0);
 	while (!endpoints_a->empty () && count < max_reps)
 	{
-		send_confirm_req (endpoints_a->back ().endpoint, block_a);
+		send_confirm_req (endpoints_a->back ().endpoint, message_a);
 		endpoints_a->pop_back ();
 		count++;
 	}
@@ -467,10 +580,10 @@ void cga::network::broadcast_confirm_req_base (std::shared_ptr<cga::block> block
 		delay_a += std::rand () % broadcast_interval_ms;
 
 		std::weak_ptr<cga::node> node_w (node.shared ());
-		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a), [node_w, block_a, endpoints_a, delay_a]() {
+		node.alarm.add (std::chrono::steady_clock::now () + std::chrono::milliseconds (delay_a), [node_w, block_a, endpoints_a, delay_a, message_a]() {
 			if (auto node_l = node_w.lock ())
 			{
-				node_l->network.broadcast_confirm_req_base (block_a, endpoints_a, delay_a, true);
+				node_l->network.broadcast_confirm_req_base (block_a, endpoints_a, delay_a, true, message_a);
 			}
 		});
 	}
@@ -540,15 +653,18 @@ void cga::network::broadcast_confirm_req_batch (std::deque<std::pair<std::shared
 
 void cga::network::send_confirm_req (cga::endpoint const & endpoint_a, std::shared_ptr<cga::block> block)
 {
-	cga::confirm_req message (block);
-	auto bytes = message.to_bytes ();
+	send_confirm_req (endpoint_a, std::make_shared<cga::wire_message const> (cga::confirm_req (block)));
+}
+
+void cga::network::send_confirm_req (cga::endpoint const & endpoint_a, std::shared_ptr<cga::wire_message const> const & message_a)
+{
 	if (node.config.logging.network_message_logging ())
 	{
 		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm req to %1%") % endpoint_a);
 	}
 	std::weak_ptr<cga::node> node_w (node.shared ());
 	node.stats.inc (cga::stat::type::message, cga::stat::detail::confirm_req, cga::stat::dir::out);
-	send_buffer (bytes->data (), bytes->size (), endpoint_a, [bytes, node_w](boost::system::error_code const & ec, size_t size) {
+	send_buffer (message_a->data (), message_a->size (), endpoint_a, [message_a, node_w](boost::system::error_code const & ec, size_t size) {
 		if (auto node_l = node_w.lock ())
 		{
 			if (ec && node_l->config.logging.network_logging ())
@@ -591,10 +707,11 @@ void rep_query (cga::node & node_a, T const & peers_a)
 	std::shared_ptr<cga::block> block (node_a.store.block_random (transaction));
 	auto hash (block->hash ());
 	node_a.rep_crawler.add (hash);
+	auto message (std::make_shared<cga::wire_message const> (cga::confirm_req (block)));
 	for (auto i (peers_a.begin ()), n (peers_a.end ()); i != n; ++i)
 	{
 		node_a.peers.rep_request (*i);
-		node_a.network.send_confirm_req (*i, block);
+		node_a.network.send_confirm_req (*i, message);
 	}
 	std::weak_ptr<cga::node> node_w (node_a.shared ());
 	node_a.alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [node_w, hash]() {
@@ -811,89 +928,222 @@ public:
 };
 }
 
-void cga::network::receive_action (cga::udp_data * data_a, cga::endpoint const & local_endpoint_a)
+namespace
+{
+/** Takes a copy of each realtime message out of the parser so proof of work can be checked for a whole burst before any are processed */
+class message_collector : public cga::message_visitor
 {
-	auto allowed_sender (true);
-	if (!on)
+public:
+	void keepalive (cga::keepalive const & message_a) override
 	{
-		allowed_sender = false;
+		message = std::make_unique<cga::keepalive> (message_a);
 	}
-	else if (data_a->endpoint == local_endpoint_a)
+	void publish (cga::publish const & message_a) override
 	{
-		allowed_sender = false;
+		message = std::make_unique<cga::publish> (message_a);
 	}
-	else if (cga::reserved_address (data_a->endpoint, false) && !node.config.allow_local_peers)
+	void confirm_req (cga::confirm_req const & message_a) override
 	{
-		allowed_sender = false;
+		message = std::make_unique<cga::confirm_req> (message_a);
 	}
-	if (allowed_sender)
+	void confirm_ack (cga::confirm_ack const & message_a) override
 	{
-		network_message_visitor visitor (node, data_a->endpoint);
-		cga::message_parser parser (node.block_uniquer, node.vote_uniquer, visitor, node.work);
-		parser.deserialize_buffer (data_a->buffer, data_a->size);
-		if (parser.status != cga::message_parser::parse_status::success)
-		{
-			node.stats.inc (cga::stat::type::error);
+		message = std::make_unique<cga::confirm_ack> (message_a);
+	}
+	void bulk_pull (cga::bulk_pull const &) override
+	{
+		assert (false);
+	}
+	void bulk_pull_account (cga::bulk_pull_account const &) override
+	{
+		assert (false);
+	}
+	void bulk_push (cga::bulk_push const &) override
+	{
+		assert (false);
+	}
+	void frontier_req (cga::frontier_req const &) override
+	{
+		assert (false);
+	}
+	void node_id_handshake (cga::node_id_handshake const & message_a) override
+	{
+		message = std::make_unique<cga::node_id_handshake> (message_a);
+	}
+	std::unique_ptr<cga::message> message;
+};
 
-			switch (parser.status)
+/** Append the root and work of every block carried by a realtime message */
+void append_work (cga::message const & message_a, std::vector<cga::block_hash> & roots_a, std::vector<uint64_t> & works_a)
+{
+	auto append ([&roots_a, &works_a](cga::block const & block_a) {
+		roots_a.push_back (block_a.root ());
+		works_a.push_back (block_a.block_work ());
+	});
+	switch (message_a.header.type)
+	{
+		case cga::message_type::publish:
+			append (*static_cast<cga::publish const &> (message_a).block);
+			break;
+		case cga::message_type::confirm_req:
+		{
+			auto const & block (static_cast<cga::confirm_req const &> (message_a).block);
+			if (block != nullptr)
 			{
-				case cga::message_parser::parse_status::insufficient_work:
-					// We've already increment error count, update detail only
-					node.stats.inc_detail_only (cga::stat::type::error, cga::stat::detail::insufficient_work);
-					break;
-				case cga::message_parser::parse_status::invalid_magic:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_magic);
-					break;
-				case cga::message_parser::parse_status::invalid_network:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_network);
-					break;
-				case cga::message_parser::parse_status::invalid_header:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_header);
-					break;
-				case cga::message_parser::parse_status::invalid_message_type:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_message_type);
-					break;
-				case cga::message_parser::parse_status::invalid_keepalive_message:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_keepalive_message);
-					break;
-				case cga::message_parser::parse_status::invalid_publish_message:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_publish_message);
-					break;
-				case cga::message_parser::parse_status::invalid_confirm_req_message:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_confirm_req_message);
-					break;
-				case cga::message_parser::parse_status::invalid_confirm_ack_message:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_confirm_ack_message);
-					break;
-				case cga::message_parser::parse_status::invalid_node_id_handshake_message:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_node_id_handshake_message);
-					break;
-				case cga::message_parser::parse_status::outdated_version:
-					node.stats.inc (cga::stat::type::udp, cga::stat::detail::outdated_version);
-					break;
-				case cga::message_parser::parse_status::success:
-					/* Already checked, unreachable */
-					break;
+				append (*block);
 			}
+			break;
+		}
+		case cga::message_type::confirm_ack:
+			for (auto & vote_block : static_cast<cga::confirm_ack const &> (message_a).vote->blocks)
+			{
+				if (!vote_block.which ())
+				{
+					append (*boost::get<std::shared_ptr<cga::block>> (vote_block));
+				}
+			}
+			break;
+		default:
+			break;
+	}
+}
+}
+
+void cga::network::receive_action (cga::udp_data * data_a, cga::endpoint const & local_endpoint_a)
+{
+	receive_burst (std::vector<cga::udp_data *>{ data_a }, local_endpoint_a);
+}
 
-			if (node.config.logging.network_logging () && parser.status != cga::message_parser::parse_status::outdated_version)
+void cga::network::receive_burst (std::vector<cga::udp_data *> const & burst_a, cga::endpoint const & local_endpoint_a)
+{
+	class parsed_message
+	{
+	public:
+		cga::udp_data * data;
+		std::unique_ptr<cga::message> message;
+		// One past the last entry of roots/works belonging to this message
+		size_t work_end;
+	};
+	std::vector<parsed_message> messages;
+	std::vector<cga::block_hash> roots;
+	std::vector<uint64_t> works;
+	for (auto data : burst_a)
+	{
+		auto allowed_sender (true);
+		if (!on)
+		{
+			allowed_sender = false;
+		}
+		else if (data->endpoint == local_endpoint_a)
+		{
+			allowed_sender = false;
+		}
+		else if (cga::reserved_address (data->endpoint, false) && !node.config.allow_local_peers)
+		{
+			allowed_sender = false;
+		}
+		if (allowed_sender)
+		{
+			message_collector collector;
+			cga::message_parser parser (node.block_uniquer, node.vote_uniquer, collector, node.work, false);
+			parser.deserialize_buffer (data->buffer, data->size);
+			if (parser.status != cga::message_parser::parse_status::success)
 			{
-				BOOST_LOG (node.log) << "Could not parse message.  Error: " << parser.status_string ();
+				node.stats.inc (cga::stat::type::error);
+
+				switch (parser.status)
+				{
+					case cga::message_parser::parse_status::insufficient_work:
+						// We've already increment error count, update detail only
+						node.stats.inc_detail_only (cga::stat::type::error, cga::stat::detail::insufficient_work);
+						break;
+					case cga::message_parser::parse_status::invalid_magic:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_magic);
+						break;
+					case cga::message_parser::parse_status::invalid_network:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_network);
+						break;
+					case cga::message_parser::parse_status::invalid_header:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_header);
+						break;
+					case cga::message_parser::parse_status::invalid_message_type:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_message_type);
+						break;
+					case cga::message_parser::parse_status::invalid_keepalive_message:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_keepalive_message);
+						break;
+					case cga::message_parser::parse_status::invalid_publish_message:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_publish_message);
+						break;
+					case cga::message_parser::parse_status::invalid_confirm_req_message:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_confirm_req_message);
+						break;
+					case cga::message_parser::parse_status::invalid_confirm_ack_message:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_confirm_ack_message);
+						break;
+					case cga::message_parser::parse_status::invalid_node_id_handshake_message:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::invalid_node_id_handshake_message);
+						break;
+					case cga::message_parser::parse_status::outdated_version:
+						node.stats.inc (cga::stat::type::udp, cga::stat::detail::outdated_version);
+						break;
+					case cga::message_parser::parse_status::success:
+						/* Already checked, unreachable */
+						break;
+				}
+
+				if (node.config.logging.network_logging () && parser.status != cga::message_parser::parse_status::outdated_version)
+				{
+					BOOST_LOG (node.log) << "Could not parse message.  Error: " << parser.status_string ();
+				}
+			}
+			else
+			{
+				assert (collector.message != nullptr);
+				append_work (*collector.message, roots, works);
+				messages.push_back (parsed_message{ data, std::move (collector.message), roots.size () });
 			}
 		}
 		else
 		{
-			node.stats.add (cga::stat::type::traffic, cga::stat::dir::in, data_a->size);
+			if (node.config.logging.network_logging ())
+			{
+				BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data->endpoint.address ().to_string ());
+			}
+
+			node.stats.inc_detail_only (cga::stat::type::error, cga::stat::detail::bad_sender);
 		}
 	}
-	else
+	// Proof of work for every block in the burst is checked together so the vector kernels are kept full
+	std::vector<int> valid (roots.size ());
+	cga::work_validate_batch (roots.data (), works.data (), roots.size (), valid.data ());
+	size_t work_begin (0);
+	for (auto & parsed : messages)
 	{
-		if (node.config.logging.network_logging ())
+		auto sufficient_work (std::all_of (valid.begin () + work_begin, valid.begin () + parsed.work_end, [](int valid_a) { return valid_a == 1; }));
+		work_begin = parsed.work_end;
+		if (sufficient_work)
 		{
-			BOOST_LOG (node.log) << boost::str (boost::format ("Reserved sender %1%") % data_a->endpoint.address ().to_string ());
+			if (node.tracer.enabled () && parsed.message->header.type == cga::message_type::publish)
+			{
+				auto hash (static_cast<cga::publish const &> (*parsed.message).block->hash ());
+				node.tracer.record (hash, cga::block_tracer::stage::udp_buffer, parsed.data->arrival);
+				node.tracer.record (hash, cga::block_tracer::stage::receive_action);
+			}
+			network_message_visitor visitor (node, parsed.data->endpoint);
+			parsed.message->visit (visitor);
+			node.stats.add (cga::stat::type::traffic, cga::stat::dir::in, parsed.data->size);
+		}
+		else
+		{
+			node.stats.inc (cga::stat::type::error);
+			// We've already increment error count, update detail only
+			node.stats.inc_detail_only (cga::stat::type::error, cga::stat::detail::insufficient_work);
+			if (node.config.logging.network_logging ())
+			{
+				BOOST_LOG (node.log) << "Could not parse message.  Error: insufficient_work";
+			}
 		}
-
-		node.stats.inc_detail_only (cga::stat::type::error, cga::stat::detail::bad_sender);
 	}
 }
 
@@ -909,13 +1159,10 @@ void cga::network::merge_peers (std::array<cga::endpoint, 8> const & peers_a)
 	}
 }
 
-bool cga::operation::operator> (cga::operation const & other_a) const
-{
-	return wakeup > other_a.wakeup;
-}
-
 cga::alarm::alarm (boost::asio::io_context & io_ctx_a) :
 io_ctx (io_ctx_a),
+sleeping_until (std::chrono::steady_clock::time_point::min ()),
+stopped (false),
 thread ([this]() {
 	cga::thread_role::set (cga::thread_role::name::alarm);
 	run ();
@@ -925,51 +1172,72 @@ thread ([this]() {
 
 cga::alarm::~alarm ()
 {
-	add (std::chrono::steady_clock::now (), nullptr);
+	{
+		std::lock_guard<std::mutex> lock (mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
 	thread.join ();
 }
 
 void cga::alarm::run ()
 {
+	std::vector<std::function<void()>> due;
 	std::unique_lock<std::mutex> lock (mutex);
-	auto done (false);
-	while (!done)
+	while (!stopped)
 	{
-		if (!operations.empty ())
+		operations.expire (std::chrono::steady_clock::now (), due);
+		if (!due.empty ())
 		{
-			auto & operation (operations.top ());
-			if (operation.function)
-			{
-				if (operation.wakeup <= std::chrono::steady_clock::now ())
-				{
-					io_ctx.post (operation.function);
-					operations.pop ();
-				}
-				else
-				{
-					auto wakeup (operation.wakeup);
-					condition.wait_until (lock, wakeup);
-				}
-			}
-			else
+			lock.unlock ();
+			for (auto & function : due)
 			{
-				done = true;
+				io_ctx.post (std::move (function));
 			}
+			due.clear ();
+			lock.lock ();
 		}
 		else
 		{
-			condition.wait (lock);
+			sleeping_until = operations.next ();
+			if (sleeping_until == std::chrono::steady_clock::time_point::max ())
+			{
+				condition.wait (lock);
+			}
+			else
+			{
+				condition.wait_until (lock, sleeping_until);
+			}
+			sleeping_until = std::chrono::steady_clock::time_point::min ();
 		}
 	}
 }
 
-void cga::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation)
+cga::timing_wheel::handle cga::alarm::add (std::chrono::steady_clock::time_point const & wakeup_a, std::function<void()> const & operation)
 {
+	// Copied before taking the lock, it may own captures which are expensive to copy
+	auto function (operation);
+	std::unique_lock<std::mutex> lock (mutex);
+	auto result (operations.insert (wakeup_a, std::move (function)));
+	auto notify (wakeup_a < sleeping_until);
+	lock.unlock ();
+	if (notify)
 	{
-		std::lock_guard<std::mutex> lock (mutex);
-		operations.push (cga::operation ({ wakeup_a, operation }));
+		condition.notify_all ();
 	}
-	condition.notify_all ();
+	return result;
+}
+
+bool cga::alarm::cancel (cga::timing_wheel::handle const & handle_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return operations.erase (handle_a);
+}
+
+size_t cga::alarm::size ()
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	return operations.size ();
 }
 
 namespace cga
@@ -977,13 +1245,24 @@ namespace cga
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (alarm & alarm, const std::string & name)
 {
 	auto composite = std::make_unique<seq_con_info_composite> (name);
-	size_t count = 0;
-	{
-		std::lock_guard<std::mutex> guard (alarm.mutex);
-		count = alarm.operations.size ();
+	std::lock_guard<std::mutex> guard (alarm.mutex);
+	auto sizeof_element = cga::timing_wheel::entry_size;
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "operations", alarm.operations.size (), sizeof_element }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "ready", alarm.operations.ready_size (), sizeof_element }));
+	for (size_t level (0); level < cga::timing_wheel::level_count; ++level)
+	{
+		auto level_composite = std::make_unique<seq_con_info_composite> ("level_" + std::to_string (level));
+		for (size_t slot (0); slot < cga::timing_wheel::slot_count; ++slot)
+		{
+			auto count (alarm.operations.occupancy (level, slot));
+			if (count != 0)
+			{
+				level_composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "bucket_" + std::to_string (slot), count, sizeof_element }));
+			}
+		}
+		composite->add_component (std::move (level_composite));
 	}
-	auto sizeof_element = sizeof (decltype (alarm.operations)::value_type);
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "operations", count, sizeof_element }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "overflow", alarm.operations.overflow_size (), sizeof_element }));
 	return composite;
 }
 }
@@ -1001,22 +1280,29 @@ bool cga::node_init::error ()
 
 cga::vote_processor::vote_processor (cga::node & node_a) :
 node (node_a),
-started (false),
-stopped (false),
-active (false),
-thread ([this]() {
-	cga::thread_role::set (cga::thread_role::name::vote_processing);
-	process_loop ();
-})
+stopped (false)
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!started)
+	auto threads (std::max<unsigned> (1, node.config.vote_processor_threads));
+	for (unsigned i (0); i < threads; ++i)
 	{
-		condition.wait (lock);
+		shards.push_back (std::make_unique<cga::vote_processor::shard> ());
 	}
+	for (auto & shard_l : shards)
+	{
+		auto & shard_ref (*shard_l);
+		shard_ref.thread = boost::thread ([this, &shard_ref]() {
+			cga::thread_role::set (cga::thread_role::name::vote_processing);
+			process_loop (shard_ref);
+		});
+	}
+}
+
+cga::vote_processor::shard & cga::vote_processor::shard_for (cga::account const & account_a)
+{
+	return *shards[account_a.qwords[0] % shards.size ()];
 }
 
-void cga::vote_processor::process_loop ()
+void cga::vote_processor::process_loop (cga::vote_processor::shard & shard_a)
 {
 	std::chrono::steady_clock::time_point start_time, end_time;
 	std::chrono::steady_clock::duration elapsed_time;
@@ -1024,19 +1310,13 @@ void cga::vote_processor::process_loop ()
 	uint64_t elapsed_time_ms_int;
 	bool log_this_iteration;
 
-	std::unique_lock<std::mutex> lock (mutex);
-	started = true;
-
-	lock.unlock ();
-	condition.notify_all ();
-	lock.lock ();
-
+	std::unique_lock<std::mutex> lock (shard_a.mutex);
 	while (!stopped)
 	{
-		if (!votes.empty ())
+		if (!shard_a.votes.empty ())
 		{
 			std::deque<std::pair<std::shared_ptr<cga::vote>, cga::endpoint>> votes_l;
-			votes_l.swap (votes);
+			votes_l.swap (shard_a.votes);
 
 			log_this_iteration = false;
 			if (node.config.logging.network_logging () && votes_l.size () > 50)
@@ -1048,30 +1328,21 @@ void cga::vote_processor::process_loop ()
 				log_this_iteration = true;
 				start_time = std::chrono::steady_clock::now ();
 			}
-			active = true;
+			shard_a.active = true;
 			lock.unlock ();
 			verify_votes (votes_l);
 			{
-				std::unique_lock<std::mutex> active_single_lock (node.active.mutex);
 				auto transaction (node.store.tx_begin_read ());
-				uint64_t count (1);
 				for (auto & i : votes_l)
 				{
 					vote_blocking (transaction, i.first, i.second, true);
-					// Free active_transactions mutex each 100 processed votes
-					if (count % 100 == 0)
-					{
-						active_single_lock.unlock ();
-						active_single_lock.lock ();
-					}
-					count++;
 				}
 			}
 			lock.lock ();
-			active = false;
+			shard_a.active = false;
 
 			lock.unlock ();
-			condition.notify_all ();
+			shard_a.condition.notify_all ();
 			lock.lock ();
 
 			if (log_this_iteration)
@@ -1094,7 +1365,7 @@ void cga::vote_processor::process_loop ()
 		}
 		else
 		{
-			condition.wait (lock);
+			shard_a.condition.wait (lock);
 		}
 	}
 }
@@ -1102,34 +1373,40 @@ void cga::vote_processor::process_loop ()
 void cga::vote_processor::vote (std::shared_ptr<cga::vote> vote_a, cga::endpoint endpoint_a)
 {
 	assert (endpoint_a.address ().is_v6 ());
-	std::unique_lock<std::mutex> lock (mutex);
+	auto & shard_l (shard_for (vote_a->account));
+	std::unique_lock<std::mutex> lock (shard_l.mutex);
 	if (!stopped)
 	{
 		bool process (false);
 		/* Random early delection levels
 		Always process votes for test network (process = true)
-		Stop processing with max 144 * 1024 votes */
+		Stop processing with max 144 * 1024 votes across all shards */
 		if (!cga::is_test_network)
 		{
+			auto size (shard_l.votes.size () * shards.size ());
 			// Level 0 (< 0.1%)
-			if (votes.size () < 96 * 1024)
+			if (size < max_votes_level_0)
 			{
 				process = true;
 			}
-			// Level 1 (0.1-1%)
-			else if (votes.size () < 112 * 1024)
-			{
-				process = (representatives_1.find (vote_a->account) != representatives_1.end ());
-			}
-			// Level 2 (1-5%)
-			else if (votes.size () < 128 * 1024)
-			{
-				process = (representatives_2.find (vote_a->account) != representatives_2.end ());
-			}
-			// Level 3 (> 5%)
-			else if (votes.size () < 144 * 1024)
+			else
 			{
-				process = (representatives_3.find (vote_a->account) != representatives_3.end ());
+				std::lock_guard<std::mutex> weights_lock (mutex);
+				// Level 1 (0.1-1%)
+				if (size < max_votes_level_1)
+				{
+					process = (representatives_1.find (vote_a->account) != representatives_1.end ());
+				}
+				// Level 2 (1-5%)
+				else if (size < max_votes_level_2)
+				{
+					process = (representatives_2.find (vote_a->account) != representatives_2.end ());
+				}
+				// Level 3 (> 5%)
+				else if (size < max_votes_level_3)
+				{
+					process = (representatives_3.find (vote_a->account) != representatives_3.end ());
+				}
 			}
 		}
 		else
@@ -1139,14 +1416,15 @@ void cga::vote_processor::vote (std::shared_ptr<cga::vote> vote_a, cga::endpoint
 		}
 		if (process)
 		{
-			votes.push_back (std::make_pair (vote_a, endpoint_a));
+			shard_l.votes.push_back (std::make_pair (vote_a, endpoint_a));
 
 			lock.unlock ();
-			condition.notify_all ();
-			lock.lock ();
+			shard_l.condition.notify_all ();
 		}
 		else
 		{
+			++shard_l.overflow;
+			lock.unlock ();
 			node.stats.inc (cga::stat::type::vote, cga::stat::detail::vote_overflow);
 			if (node.config.logging.vote_logging ())
 			{
@@ -1178,7 +1456,9 @@ void cga::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<cga
 		signatures.push_back (vote.first->signature.bytes.data ());
 	}
 	cga::signature_check_set check = { size, messages.data (), lengths.data (), pub_keys.data (), signatures.data (), verifications.data () };
+	auto start (std::chrono::steady_clock::now ());
 	node.checker.verify (check);
+	node.stats.record (cga::stat::histogram::vote_verify, std::chrono::steady_clock::now () - start);
 	std::remove_reference_t<decltype (votes_a)> result;
 	auto i (0);
 	for (auto & vote : votes_a)
@@ -1193,17 +1473,15 @@ void cga::vote_processor::verify_votes (std::deque<std::pair<std::shared_ptr<cga
 	votes_a.swap (result);
 }
 
-// node.active.mutex lock required
 cga::vote_code cga::vote_processor::vote_blocking (cga::transaction const & transaction_a, std::shared_ptr<cga::vote> vote_a, cga::endpoint endpoint_a, bool validated)
 {
 	assert (endpoint_a.address ().is_v6 ());
-	assert (!node.active.mutex.try_lock ());
 	auto result (cga::vote_code::invalid);
 	if (validated || !vote_a->validate ())
 	{
 		auto max_vote (node.store.vote_max (transaction_a, vote_a));
 		result = cga::vote_code::replay;
-		if (!node.active.vote (vote_a, true))
+		if (!node.active.vote (vote_a))
 		{
 			result = cga::vote_code::vote;
 		}
@@ -1217,8 +1495,7 @@ cga::vote_code cga::vote_processor::vote_blocking (cga::transaction const & tran
 				// Amplify attack considerations: We're sending out a confirm_ack in response to a confirm_ack for no net traffic increase
 				if (max_vote->sequence > vote_a->sequence + 10000)
 				{
-					cga::confirm_ack confirm (max_vote);
-					node.network.confirm_send (confirm, confirm.to_bytes (), endpoint_a);
+					node.network.confirm_send (max_vote, std::make_shared<cga::wire_message const> (cga::confirm_ack (max_vote)), endpoint_a);
 				}
 				break;
 			case cga::vote_code::invalid:
@@ -1251,49 +1528,73 @@ cga::vote_code cga::vote_processor::vote_blocking (cga::transaction const & tran
 
 void cga::vote_processor::stop ()
 {
+	stopped = true;
+	for (auto & shard_l : shards)
 	{
-		std::lock_guard<std::mutex> lock (mutex);
-		stopped = true;
+		{
+			// Synchronize with waiting shard threads so the wakeup cannot be missed
+			std::lock_guard<std::mutex> lock (shard_l->mutex);
+		}
+		shard_l->condition.notify_all ();
 	}
-	condition.notify_all ();
-	if (thread.joinable ())
+	for (auto & shard_l : shards)
 	{
-		thread.join ();
+		if (shard_l->thread.joinable ())
+		{
+			shard_l->thread.join ();
+		}
 	}
 }
 
 void cga::vote_processor::flush ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (active || !votes.empty ())
+	for (auto & shard_l : shards)
 	{
-		condition.wait (lock);
+		std::unique_lock<std::mutex> lock (shard_l->mutex);
+		while (!stopped && (shard_l->active || !shard_l->votes.empty ()))
+		{
+			shard_l->condition.wait (lock);
+		}
 	}
 }
 
+size_t cga::vote_processor::size ()
+{
+	size_t result (0);
+	for (auto & shard_l : shards)
+	{
+		std::lock_guard<std::mutex> lock (shard_l->mutex);
+		result += shard_l->votes.size ();
+	}
+	return result;
+}
+
 void cga::vote_processor::calculate_weights ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
+	std::lock_guard<std::mutex> lock (mutex);
 	if (!stopped)
 	{
 		representatives_1.clear ();
 		representatives_2.clear ();
 		representatives_3.clear ();
 		auto supply (node.online_reps.online_stake ());
-		auto transaction (node.store.tx_begin_read ());
-		for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n; ++i)
+		auto rep_amounts (node.ledger.rep_weights.snapshot ());
+		for (auto & shard : *rep_amounts)
 		{
-			cga::account representative (i->first);
-			auto weight (node.ledger.weight (transaction, representative));
-			if (weight > supply / 1000) // 0.1% or above (level 1)
+			for (auto & i : *shard)
 			{
-				representatives_1.insert (representative);
-				if (weight > supply / 100) // 1% or above (level 2)
+				cga::account representative (i.first);
+				auto weight (node.ledger.weight (representative));
+				if (weight > supply / 1000) // 0.1% or above (level 1)
 				{
-					representatives_2.insert (representative);
-					if (weight > supply / 20) // 5% or above (level 3)
+					representatives_1.insert (representative);
+					if (weight > supply / 100) // 1% or above (level 2)
 					{
-						representatives_3.insert (representative);
+						representatives_2.insert (representative);
+						if (weight > supply / 20) // 5% or above (level 3)
+						{
+							representatives_3.insert (representative);
+						}
 					}
 				}
 			}
@@ -1322,16 +1623,33 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (vote_processor & v
 	size_t representatives_2_count = 0;
 	size_t representatives_3_count = 0;
 
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	auto sizeof_vote = sizeof (decltype (cga::vote_processor::shard::votes)::value_type);
+	for (size_t i (0), n (vote_processor.shards.size ()); i < n; ++i)
 	{
-		std::lock_guard<std::mutex> (vote_processor.mutex);
-		votes_count = vote_processor.votes.size ();
+		auto & shard_l (*vote_processor.shards[i]);
+		size_t shard_votes_count = 0;
+		size_t shard_overflow_count = 0;
+		{
+			std::lock_guard<std::mutex> guard (shard_l.mutex);
+			shard_votes_count = shard_l.votes.size ();
+			shard_overflow_count = shard_l.overflow;
+		}
+		votes_count += shard_votes_count;
+		auto shard_composite = std::make_unique<seq_con_info_composite> ("shard_" + std::to_string (i));
+		shard_composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "votes", shard_votes_count, sizeof_vote }));
+		shard_composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "overflow", shard_overflow_count, 0 }));
+		composite->add_component (std::move (shard_composite));
+	}
+
+	{
+		std::lock_guard<std::mutex> guard (vote_processor.mutex);
 		representatives_1_count = vote_processor.representatives_1.size ();
 		representatives_2_count = vote_processor.representatives_2.size ();
 		representatives_3_count = vote_processor.representatives_3.size ();
 	}
 
-	auto composite = std::make_unique<seq_con_info_composite> (name);
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "votes", votes_count, sizeof (decltype (vote_processor.votes)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "votes", votes_count, sizeof_vote }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representatives_1", representatives_1_count, sizeof (decltype (vote_processor.representatives_1)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representatives_2", representatives_2_count, sizeof (decltype (vote_processor.representatives_2)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "representatives_3", representatives_3_count, sizeof (decltype (vote_processor.representatives_3)::value_type) }));
@@ -1383,9 +1701,11 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (block_processor &
 	size_t blocks_hashes_count = 0;
 	size_t forced_count = 0;
 	size_t rolled_back_count = 0;
+	size_t post_commit_count = 0;
 
 	{
 		std::lock_guard<std::mutex> guard (block_processor.mutex);
+		post_commit_count = block_processor.post_commit.size ();
 		state_blocks_count = block_processor.state_blocks.size ();
 		blocks_count = block_processor.blocks.size ();
 		blocks_hashes_count = block_processor.blocks_hashes.size ();
@@ -1399,6 +1719,7 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (block_processor &
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "blocks_hashes", blocks_hashes_count, sizeof (decltype (block_processor.blocks_hashes)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "forced", forced_count, sizeof (decltype (block_processor.forced)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "rolled_back", rolled_back_count, sizeof (decltype (block_processor.rolled_back)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "post_commit", post_commit_count, sizeof (decltype (block_processor.post_commit)::value_type) }));
 	composite->add_component (collect_seq_con_info (block_processor.generator, "generator"));
 	return composite;
 }
@@ -1415,10 +1736,11 @@ config (config_a),
 flags (flags_a),
 alarm (alarm_a),
 work (work_a),
-store_impl (std::make_unique<cga::mdb_store> (init_a.block_store_init, config.logging, application_path_a / "data.ldb", config_a.lmdb_max_dbs, !flags.disable_unchecked_drop, flags.sideband_batch_size)),
+store_impl (std::make_unique<cga::mdb_store> (init_a.block_store_init, config.logging, stats, application_path_a / "data.ldb", config_a.lmdb_max_dbs, !flags.disable_unchecked_drop, flags.sideband_batch_size, config_a.write_queue_max_latency, config_a.write_queue_max_ops)),
 store (*store_impl),
 wallets_store_impl (std::make_unique<cga::mdb_wallets_store> (init_a.wallets_store_init, application_path_a / "wallets.ldb", config_a.lmdb_max_dbs)),
 wallets_store (*wallets_store_impl),
+tracer (config.block_trace_interval),
 gap_cache (*this),
 ledger (store, stats, config.epoch_block_link, config.epoch_block_signer),
 active (*this),
@@ -1440,6 +1762,8 @@ block_processor_thread ([this]() {
 online_reps (ledger, config.online_weight_minimum.number ()),
 stats (config.stat_config),
 vote_uniquer (block_uniquer),
+confirmation_height_processor (*this),
+metrics (*this, config.metrics_config),
 startup_time (std::chrono::steady_clock::now ())
 {
 	wallets.observer = [this](bool active) {
@@ -1506,7 +1830,7 @@ startup_time (std::chrono::steady_clock::now ())
 		cga::uint128_t rep_weight;
 		cga::uint128_t min_rep_weight;
 		{
-			rep_weight = ledger.weight (transaction, vote_a->account);
+			rep_weight = ledger.weight (vote_a->account);
 			min_rep_weight = online_reps.online_stake () / 1000;
 		}
 		if (rep_weight > min_rep_weight)
@@ -1527,7 +1851,7 @@ startup_time (std::chrono::steady_clock::now ())
 				{
 					BOOST_LOG (log) << boost::str (boost::format ("Found a representative at %1%") % endpoint_a);
 					// Rebroadcasting all active votes to new representative
-					auto blocks (this->active.list_blocks (true));
+					auto blocks (this->active.list_blocks ());
 					for (auto i (blocks.begin ()), n (blocks.end ()); i != n; ++i)
 					{
 						if (*i != nullptr)
@@ -1568,6 +1892,8 @@ startup_time (std::chrono::steady_clock::now ())
 			std::exit (1);
 		}
 
+		ledger.load_cache (transaction);
+
 		node_id = cga::keypair (store.get_node_id (transaction));
 		BOOST_LOG (log) << "Node ID: " << node_id.pub.to_account ();
 	}
@@ -1753,6 +2079,7 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (node & node, const
 	composite->add_component (collect_seq_con_info (node.votes_cache, "votes_cache"));
 	composite->add_component (collect_seq_con_info (node.block_uniquer, "block_uniquer"));
 	composite->add_component (collect_seq_con_info (node.vote_uniquer, "vote_uniquer"));
+	composite->add_component (collect_seq_con_info (node.confirmation_height_processor, "confirmation_height_processor"));
 	return composite;
 }
 }
@@ -1864,14 +2191,14 @@ std::unique_ptr<seq_con_info_component> collect_seq_con_info (gap_cache & gap_ca
 }
 }
 
-void cga::network::confirm_send (cga::confirm_ack const & confirm_a, std::shared_ptr<std::vector<uint8_t>> bytes_a, cga::endpoint const & endpoint_a)
+void cga::network::confirm_send (std::shared_ptr<cga::vote> const & vote_a, std::shared_ptr<cga::wire_message const> const & message_a, cga::endpoint const & endpoint_a)
 {
 	if (node.config.logging.network_publish_logging ())
 	{
-		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm_ack for block(s) %1%to %2% sequence %3%") % confirm_a.vote->hashes_string () % endpoint_a % std::to_string (confirm_a.vote->sequence));
+		BOOST_LOG (node.log) << boost::str (boost::format ("Sending confirm_ack for block(s) %1%to %2% sequence %3%") % vote_a->hashes_string () % endpoint_a % std::to_string (vote_a->sequence));
 	}
 	std::weak_ptr<cga::node> node_w (node.shared ());
-	node.network.send_buffer (bytes_a->data (), bytes_a->size (), endpoint_a, [bytes_a, node_w, endpoint_a](boost::system::error_code const & ec, size_t size_a) {
+	node.network.send_buffer (message_a->data (), message_a->size (), endpoint_a, [message_a, node_w, endpoint_a](boost::system::error_code const & ec, size_t size_a) {
 		if (auto node_l = node_w.lock ())
 		{
 			if (ec && node_l->config.logging.network_logging ())
@@ -1914,6 +2241,10 @@ void cga::node::start ()
 		ongoing_unchecked_cleanup ();
 	}
 	ongoing_store_flush ();
+	if (config.enable_pruning)
+	{
+		ongoing_ledger_pruning ();
+	}
 	ongoing_rep_crawl ();
 	ongoing_rep_calculation ();
 	ongoing_peer_store ();
@@ -1936,6 +2267,10 @@ void cga::node::start ()
 		});
 	}
 	port_mapping.start ();
+	if (config.metrics_config.enabled)
+	{
+		metrics.start ();
+	}
 }
 
 void cga::node::stop ()
@@ -1947,13 +2282,16 @@ void cga::node::stop ()
 		block_processor_thread.join ();
 	}
 	vote_processor.stop ();
+	confirmation_height_processor.stop ();
 	active.stop ();
 	network.stop ();
 	bootstrap_initiator.stop ();
 	bootstrap.stop ();
+	metrics.stop ();
 	port_mapping.stop ();
 	checker.stop ();
 	wallets.stop ();
+	store.tx_queue_stop ();
 }
 
 void cga::node::keepalive_preconfigured (std::vector<std::string> const & peers_a)
@@ -1993,8 +2331,7 @@ std::pair<cga::uint128_t, cga::uint128_t> cga::node::balance_pending (cga::accou
 
 cga::uint128_t cga::node::weight (cga::account const & account_a)
 {
-	auto transaction (store.tx_begin_read ());
-	return ledger.weight (transaction, account_a);
+	return ledger.weight (account_a);
 }
 
 cga::account cga::node::representative (cga::account const & account_a)
@@ -2058,6 +2395,7 @@ void cga::node::ongoing_rep_crawl ()
 void cga::node::ongoing_rep_calculation ()
 {
 	auto now (std::chrono::steady_clock::now ());
+	++ledger.weights_epoch;
 	vote_processor.calculate_weights ();
 	std::weak_ptr<cga::node> node_w (shared_from_this ());
 	alarm.add (now + std::chrono::minutes (10), [node_w]() {
@@ -2092,10 +2430,9 @@ void cga::node::ongoing_bootstrap ()
 
 void cga::node::ongoing_store_flush ()
 {
-	{
-		auto transaction (store.tx_begin_write ());
-		store.flush (transaction);
-	}
+	store.tx_queue_write ([this](cga::transaction const & transaction_a) {
+		store.flush (transaction_a);
+	});
 	std::weak_ptr<cga::node> node_w (shared_from_this ());
 	alarm.add (std::chrono::steady_clock::now () + std::chrono::seconds (5), [node_w]() {
 		if (auto node_l = node_w.lock ())
@@ -2111,13 +2448,14 @@ void cga::node::ongoing_peer_store ()
 	if (!endpoint_peers.empty ())
 	{
 		// Clear all peers then refresh with the current list of peers
-		auto transaction (store.tx_begin_write ());
-		store.peer_clear (transaction);
-		for (const auto & endpoint : endpoint_peers)
-		{
-			cga::endpoint_key endpoint_key (endpoint.address ().to_v6 ().to_bytes (), endpoint.port ());
-			store.peer_put (transaction, std::move (endpoint_key));
-		}
+		store.tx_queue_write ([this, endpoint_peers](cga::transaction const & transaction_a) {
+			store.peer_clear (transaction_a);
+			for (const auto & endpoint : endpoint_peers)
+			{
+				cga::endpoint_key endpoint_key (endpoint.address ().to_v6 ().to_bytes (), endpoint.port ());
+				store.peer_put (transaction_a, std::move (endpoint_key));
+			}
+		});
 	}
 
 	std::weak_ptr<cga::node> node_w (shared_from_this ());
@@ -2200,26 +2538,145 @@ void cga::node::unchecked_cleanup ()
 	// Delete old unchecked keys in batches
 	while (!cleaning_list.empty ())
 	{
-		size_t deleted_count (0);
-		auto transaction (store.tx_begin_write ());
-		while (deleted_count++ < 2 * 1024 && !cleaning_list.empty ())
+		std::vector<cga::unchecked_key> batch;
+		while (batch.size () < 2 * 1024 && !cleaning_list.empty ())
 		{
-			auto key (cleaning_list.front ());
+			batch.push_back (cleaning_list.front ());
 			cleaning_list.pop_front ();
-			store.unchecked_del (transaction, key);
 		}
+		store.tx_queue_write ([this, batch](cga::transaction const & transaction_a) {
+			for (auto & key : batch)
+			{
+				store.unchecked_del (transaction_a, key);
+			}
+		})
+		.wait ();
+	}
+}
+
+void cga::node::ongoing_unchecked_cleanup ()
+{
+	if (!bootstrap_initiator.in_progress ())
+	{
+		unchecked_cleanup ();
+	}
+	auto this_l (shared ());
+	alarm.add (std::chrono::steady_clock::now () + unchecked_cleanup_interval, [this_l]() {
+		this_l->ongoing_unchecked_cleanup ();
+	});
+}
+
+void cga::node::ledger_pruning (std::function<void(bool)> const & done_a)
+{
+	std::deque<cga::block_hash> prunable;
+	auto pass_complete (true);
+	{
+		auto transaction (store.tx_begin_read ());
+		// Needs confirmation heights and sideband heights on every block
+		if (store.version_get (transaction) >= 14)
+		{
+			auto i (store.latest_begin (transaction, pruning_cursor));
+			auto n (store.latest_end ());
+			auto full (false);
+			for (; i != n && !full; ++i)
+			{
+				cga::account account (i->first);
+				cga::account_info info (i->second);
+				// Keep the newest pruning_depth blocks, anything above the block before the confirmation height and everything a representative lookup can walk through
+				cga::block_sideband rep_sideband;
+				auto rep_block (store.block_get (transaction, info.rep_block, &rep_sideband));
+				if (rep_block != nullptr && info.block_count > config.pruning_depth && info.confirmation_height > 1 && rep_sideband.height > 1)
+				{
+					auto max_height (std::min ({ info.block_count - config.pruning_depth, info.confirmation_height - 1, rep_sideband.height - 1 }));
+					auto existing (pruned_heights.find (account));
+					if (existing == pruned_heights.end () || existing->second < max_height)
+					{
+						// Walk down from the frontier to the highest prunable block then collect until reaching pruned history
+						cga::block_sideband sideband;
+						auto hash (info.head);
+						auto block (store.block_get (transaction, hash, &sideband));
+						while (block != nullptr && sideband.height > max_height)
+						{
+							hash = block->previous ();
+							block = store.block_get (transaction, hash, &sideband);
+						}
+						while (block != nullptr && !full)
+						{
+							prunable.push_back (hash);
+							hash = block->previous ();
+							block = hash.is_zero () ? nullptr : store.block_get (transaction, hash, &sideband);
+							full = prunable.size () >= pruning_batch_size;
+						}
+						// A partially collected account is revisited on the next call
+						if (!full)
+						{
+							pruned_heights[account] = max_height;
+						}
+					}
+				}
+				if (!full)
+				{
+					pruning_cursor = account.number () + 1;
+				}
+			}
+			pass_complete = i == n;
+		}
+	}
+	if (pass_complete)
+	{
+		pruning_cursor = 0;
+	}
+	if (prunable.empty ())
+	{
+		done_a (pass_complete);
+	}
+	while (!prunable.empty ())
+	{
+		std::vector<cga::block_hash> batch;
+		while (batch.size () < 2 * 1024 && !prunable.empty ())
+		{
+			batch.push_back (prunable.front ());
+			prunable.pop_front ();
+		}
+		auto last (prunable.empty ());
+		// Not waited on, the caller is an alarm thread. Queued writes are applied in order so the last one completes the batch
+		store.tx_queue_write ([this, batch, last, pass_complete, done_a](cga::transaction const & transaction_a) {
+			if (last)
+			{
+				transaction_a.on_commit ([pass_complete, done_a]() {
+					done_a (pass_complete);
+				});
+				transaction_a.on_abort ([pass_complete, done_a]() {
+					done_a (pass_complete);
+				});
+			}
+			for (auto & hash : batch)
+			{
+				if (store.block_exists (transaction_a, hash))
+				{
+					store.block_prune (transaction_a, hash);
+					stats.inc (cga::stat::type::ledger, cga::stat::detail::pruned);
+				}
+			}
+		});
 	}
 }
 
-void cga::node::ongoing_unchecked_cleanup ()
+void cga::node::ongoing_ledger_pruning ()
 {
-	if (!bootstrap_initiator.in_progress ())
-	{
-		unchecked_cleanup ();
-	}
-	auto this_l (shared ());
-	alarm.add (std::chrono::steady_clock::now () + unchecked_cleanup_interval, [this_l]() {
-		this_l->ongoing_unchecked_cleanup ();
+	// Called from the write queue thread, which mustn't hold the last reference to the node
+	std::weak_ptr<cga::node> node_w (shared_from_this ());
+	ledger_pruning ([node_w](bool pass_complete_a) {
+		if (auto node_l = node_w.lock ())
+		{
+			// Keep going without waiting the full interval while a pass is still in progress
+			node_l->alarm.add (std::chrono::steady_clock::now () + (pass_complete_a ? pruning_interval : std::chrono::seconds (1)), [node_w]() {
+				if (auto node_l = node_w.lock ())
+				{
+					node_l->ongoing_ledger_pruning ();
+				}
+			});
+		}
 	});
 }
 
@@ -2561,12 +3018,25 @@ void cga::node::add_initial_peers ()
 
 void cga::node::block_confirm (std::shared_ptr<cga::block> block_a)
 {
-	active.start (block_a);
-	network.broadcast_confirm_req (block_a);
-	// Calculate votes for local representatives
-	if (config.enable_voting && active.active (*block_a))
+	auto cemented (false);
+	{
+		auto transaction (store.tx_begin_read ());
+		cemented = ledger.block_confirmed (transaction, block_a->hash ());
+	}
+	if (cemented)
+	{
+		// Already final so there's no election to hold, run the confirmation observers directly
+		process_confirmed (block_a);
+	}
+	else
 	{
-		block_processor.generator.add (block_a->hash ());
+		active.start (block_a);
+		network.broadcast_confirm_req (block_a);
+		// Calculate votes for local representatives
+		if (config.enable_voting && active.active (*block_a))
+		{
+			block_processor.generator.add (block_a->hash ());
+		}
 	}
 }
 
@@ -2668,6 +3138,7 @@ void cga::node::process_confirmed (std::shared_ptr<cga::block> block_a, uint8_t
 	auto hash (block_a->hash ());
 	if (ledger.block_exists (block_a->type (), hash))
 	{
+		tracer.record (hash, cga::block_tracer::stage::process_confirmed);
 		auto transaction (store.tx_begin_read ());
 		confirmed_visitor visitor (transaction, *this, block_a, hash);
 		block_a->visit (visitor);
@@ -2684,6 +3155,7 @@ void cga::node::process_confirmed (std::shared_ptr<cga::block> block_a, uint8_t
 		{
 			pending_account = send->hashables.destination;
 		}
+		confirmation_height_processor.add (hash);
 		observers.blocks.notify (block_a, account, amount, is_state_send);
 		if (amount > 0)
 		{
@@ -2773,8 +3245,7 @@ minimum (minimum_a)
 
 void cga::online_reps::observe (cga::account const & rep_a)
 {
-	auto transaction (ledger.store.tx_begin_read ());
-	if (ledger.weight (transaction, rep_a) > cga::Gcga_ratio)
+	if (ledger.weight (rep_a) > cga::Gcga_ratio)
 	{
 		std::lock_guard<std::mutex> lock (mutex);
 		reps.insert (rep_a);
@@ -2783,14 +3254,6 @@ void cga::online_reps::observe (cga::account const & rep_a)
 
 void cga::online_reps::sample ()
 {
-	auto transaction (ledger.store.tx_begin_write ());
-	// Discard oldest entries
-	while (ledger.store.online_weight_count (transaction) >= weight_samples)
-	{
-		auto oldest (ledger.store.online_weight_begin (transaction));
-		assert (oldest != ledger.store.online_weight_end ());
-		ledger.store.online_weight_del (transaction, oldest->first);
-	}
 	// Calculate current active rep weight
 	cga::uint128_t current;
 	std::unordered_set<cga::account> reps_copy;
@@ -2800,15 +3263,28 @@ void cga::online_reps::sample ()
 	}
 	for (auto & i : reps_copy)
 	{
-		current += ledger.weight (transaction, i);
+		current += ledger.weight (i);
 	}
-	ledger.store.online_weight_put (transaction, std::chrono::system_clock::now ().time_since_epoch ().count (), current);
-	auto trend_l (trend (transaction));
+	auto time (std::chrono::system_clock::now ().time_since_epoch ().count ());
+	cga::uint128_t trend_l;
+	ledger.store.tx_queue_write ([this, time, current, &trend_l](cga::transaction const & transaction_a) {
+		// Discard oldest entries
+		while (ledger.store.online_weight_count (transaction_a) >= weight_samples)
+		{
+			auto oldest (ledger.store.online_weight_begin (transaction_a));
+			assert (oldest != ledger.store.online_weight_end ());
+			ledger.store.online_weight_del (transaction_a, oldest->first);
+		}
+		ledger.store.online_weight_put (transaction_a, time, current);
+		trend_l = trend (transaction_a);
+	})
+	.get ();
+	// Updated once the sample is committed, before returning to the caller
 	std::lock_guard<std::mutex> lock (mutex);
 	online = trend_l;
 }
 
-cga::uint128_t cga::online_reps::trend (cga::transaction & transaction_a)
+cga::uint128_t cga::online_reps::trend (cga::transaction const & transaction_a)
 {
 	std::vector<cga::uint128_t> items;
 	items.reserve (weight_samples + 1);
@@ -2980,18 +3456,99 @@ void cga::network::send_buffer (uint8_t const * data_a, size_t size_a, cga::endp
 	}
 	if (on.load ())
 	{
-		socket.async_send_to (boost::asio::buffer (data_a, size_a), endpoint_a, [this, callback_a](boost::system::error_code const & ec, size_t size_a) {
-			callback_a (ec, size_a);
-			this->node.stats.add (cga::stat::type::traffic, cga::stat::dir::out, size_a);
-			if (ec == boost::system::errc::host_unreachable)
+		send_queue.push_back (send_request{ data_a, size_a, endpoint_a, callback_a });
+		if (!send_flush_scheduled)
+		{
+			send_flush_scheduled = true;
+			node.io_ctx.post ([this]() { this->flush_sends (); });
+		}
+	}
+}
+
+void cga::network::flush_sends ()
+{
+	std::vector<send_request> requests;
+	{
+		std::lock_guard<std::mutex> lock (socket_mutex);
+		requests.swap (send_queue);
+		send_flush_scheduled = false;
+	}
+	size_t position (0);
+#if CGA_UDP_MMSG
+	std::array<mmsghdr, max_burst> messages;
+	std::array<iovec, max_burst> vectors;
+	while (position < requests.size ())
+	{
+		auto count (std::min (max_burst, requests.size () - position));
+		for (size_t i (0); i < count; ++i)
+		{
+			auto & request (requests[position + i]);
+			vectors[i] = { const_cast<uint8_t *> (request.data), request.size };
+			messages[i] = mmsghdr{};
+			messages[i].msg_hdr.msg_name = request.endpoint.data ();
+			messages[i].msg_hdr.msg_namelen = request.endpoint.size ();
+			messages[i].msg_hdr.msg_iov = &vectors[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+		size_t sent (0);
+		{
+			std::lock_guard<std::mutex> lock (socket_mutex);
+			if (!on.load () || !socket.is_open ())
 			{
-				this->node.stats.inc (cga::stat::type::error, cga::stat::detail::unreachable_host, cga::stat::dir::out);
+				break;
 			}
-			if (this->node.config.logging.network_packet_logging ())
+			sent = static_cast<size_t> (std::max (0, sendmmsg (socket.native_handle (), messages.data (), count, MSG_DONTWAIT)));
+			if (sent < count)
 			{
-				BOOST_LOG (this->node.log) << "Packet send complete";
+				// Hand the datagram that stopped the burst to asio, it either reports the error or waits for the socket to drain
+				send_async (requests[position + sent]);
 			}
-		});
+		}
+		for (size_t i (0); i < sent; ++i)
+		{
+			send_complete (boost::system::error_code (), messages[i].msg_len, requests[position + i].callback);
+		}
+		position += std::min<size_t> (sent + 1, count);
+	}
+#else
+	{
+		std::lock_guard<std::mutex> lock (socket_mutex);
+		if (on.load ())
+		{
+			for (auto & request : requests)
+			{
+				send_async (request);
+			}
+			position = requests.size ();
+		}
+	}
+#endif
+	// Left unsent because the network stopped, their senders still expect to hear back
+	for (; position < requests.size (); ++position)
+	{
+		requests[position].callback (boost::asio::error::operation_aborted, 0);
+	}
+}
+
+void cga::network::send_async (cga::network::send_request const & request_a)
+{
+	auto callback (request_a.callback);
+	socket.async_send_to (boost::asio::buffer (request_a.data, request_a.size), request_a.endpoint, [this, callback](boost::system::error_code const & ec, size_t size_a) {
+		this->send_complete (ec, size_a, callback);
+	});
+}
+
+void cga::network::send_complete (boost::system::error_code const & ec, size_t size_a, std::function<void(boost::system::error_code const &, size_t)> const & callback_a)
+{
+	callback_a (ec, size_a);
+	node.stats.add (cga::stat::type::traffic, cga::stat::dir::out, size_a);
+	if (ec == boost::system::errc::host_unreachable)
+	{
+		node.stats.inc (cga::stat::type::error, cga::stat::detail::unreachable_host, cga::stat::dir::out);
+	}
+	if (node.config.logging.network_packet_logging ())
+	{
+		BOOST_LOG (node.log) << "Packet send complete";
 	}
 }
 
@@ -3015,14 +3572,17 @@ cga::election_vote_result::election_vote_result (bool replay_a, bool processed_a
 cga::election::election (cga::node & node_a, std::shared_ptr<cga::block> block_a, std::function<void(std::shared_ptr<cga::block>)> const & confirmation_action_a) :
 confirmation_action (confirmation_action_a),
 node (node_a),
+root (block_a->previous (), block_a->root ()),
 election_start (std::chrono::steady_clock::now ()),
 status ({ block_a, 0 }),
 confirmed (false),
 stopped (false),
+weights_epoch (node_a.ledger.weights_epoch.load ()),
 announcements (0)
 {
-	last_votes.insert (std::make_pair (cga::not_an_account (), cga::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash () }));
+	last_votes.insert (std::make_pair (cga::not_an_account (), cga::vote_info{ std::chrono::steady_clock::now (), 0, block_a->hash (), 0 }));
 	blocks.insert (std::make_pair (block_a->hash (), block_a));
+	last_tally.insert (std::make_pair (block_a->hash (), 0));
 }
 
 void cga::election::compute_rep_votes (cga::transaction const & transaction_a)
@@ -3036,45 +3596,27 @@ void cga::election::compute_rep_votes (cga::transaction const & transaction_a)
 	}
 }
 
-void cga::election::confirm_once (cga::transaction const & transaction_a, bool confirmed_back)
+void cga::election::confirm_once (bool confirmed_back)
 {
 	if (!confirmed.exchange (true))
 	{
 		status.election_end = std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::system_clock::now ().time_since_epoch ());
-		status.election_duration = std::chrono::duration_cast<std::chrono::milliseconds> (std::chrono::steady_clock::now () - election_start);
+		auto duration (std::chrono::steady_clock::now () - election_start);
+		status.election_duration = std::chrono::duration_cast<std::chrono::milliseconds> (duration);
+		node.stats.record (cga::stat::histogram::election, duration);
 		auto winner_l (status.winner);
+		node.tracer.record (winner_l->hash (), cga::block_tracer::stage::confirm_once);
 		auto node_l (node.shared ());
 		auto confirmation_action_l (confirmation_action);
-		node.background ([node_l, winner_l, confirmation_action_l]() {
+		node.background ([node_l, winner_l, confirmation_action_l, confirmed_back]() {
 			node_l->process_confirmed (winner_l);
 			confirmation_action_l (winner_l);
-		});
-		if (!confirmed_back)
-		{
-			confirm_back (transaction_a);
-		}
-	}
-}
-
-void cga::election::confirm_back (cga::transaction const & transaction_a)
-{
-	std::deque<cga::block_hash> hashes = { status.winner->previous (), status.winner->source (), status.winner->link () };
-	while (!hashes.empty ())
-	{
-		auto hash (hashes.front ());
-		hashes.pop_front ();
-		if (!hash.is_zero () && !node.ledger.is_epoch_link (hash))
-		{
-			auto existing (node.active.blocks.find (hash));
-			if (existing != node.active.blocks.end () && !existing->second->confirmed && !existing->second->stopped && existing->second->blocks.size () == 1)
+			if (!confirmed_back)
 			{
-				release_assert (existing->second->status.winner->hash () == hash);
-				existing->second->confirm_once (transaction_a, true); // Avoid recursive actions
-				hashes.push_back (existing->second->status.winner->previous ());
-				hashes.push_back (existing->second->status.winner->source ());
-				hashes.push_back (existing->second->status.winner->link ());
+				// Dependencies may be in other partitions so they are confirmed outside this election's lock
+				node_l->active.confirm_back (winner_l);
 			}
-		}
+		});
 	}
 }
 
@@ -3098,16 +3640,25 @@ bool cga::election::have_quorum (cga::tally_t const & tally_a, cga::uint128_t ta
 	return result;
 }
 
+void cga::election::refresh_tally (cga::transaction const & transaction_a)
+{
+	weights_epoch = node.ledger.weights_epoch.load ();
+	last_tally.clear ();
+	for (auto & vote_info : last_votes)
+	{
+		vote_info.second.weight = node.ledger.weight (transaction_a, vote_info.first);
+		last_tally[vote_info.second.hash] += vote_info.second.weight;
+	}
+}
+
 cga::tally_t cga::election::tally (cga::transaction const & transaction_a)
 {
-	std::unordered_map<cga::block_hash, cga::uint128_t> block_weights;
-	for (auto vote_info : last_votes)
+	if (weights_epoch != node.ledger.weights_epoch.load ())
 	{
-		block_weights[vote_info.second.hash] += node.ledger.weight (transaction_a, vote_info.first);
+		refresh_tally (transaction_a);
 	}
-	last_tally = block_weights;
 	cga::tally_t result;
-	for (auto item : block_weights)
+	for (auto & item : last_tally)
 	{
 		auto block (blocks.find (item.first));
 		if (block != blocks.end ())
@@ -3142,7 +3693,7 @@ void cga::election::confirm_if_quorum (cga::transaction const & transaction_a)
 		{
 			log_votes (tally_l);
 		}
-		confirm_once (transaction_a);
+		confirm_once ();
 	}
 }
 
@@ -3206,7 +3757,17 @@ cga::election_vote_result cga::election::vote (cga::account rep, uint64_t sequen
 		}
 		if (should_process)
 		{
-			last_votes[rep] = { std::chrono::steady_clock::now (), sequence, block_hash };
+			if (last_vote_it != last_votes.end ())
+			{
+				last_tally[last_vote_it->second.hash] -= last_vote_it->second.weight;
+			}
+			else if (last_votes.size () == 1)
+			{
+				// Only the placeholder for the initial block is there, this is the first representative to vote
+				node.tracer.record (block_hash, cga::block_tracer::stage::first_vote);
+			}
+			last_tally[block_hash] += weight;
+			last_votes[rep] = { std::chrono::steady_clock::now (), sequence, block_hash, weight };
 			if (!confirmed)
 			{
 				confirm_if_quorum (transaction);
@@ -3270,7 +3831,8 @@ bool cga::election::publish (std::shared_ptr<cga::block> block_a)
 	auto result (false);
 	if (blocks.size () >= 10)
 	{
-		if (last_tally[block_a->hash ()] < node.online_reps.online_stake () / 10)
+		auto existing (last_tally.find (block_a->hash ()));
+		if (existing == last_tally.end () || existing->second < node.online_reps.online_stake () / 10)
 		{
 			result = true;
 		}
@@ -3292,38 +3854,66 @@ bool cga::election::publish (std::shared_ptr<cga::block> block_a)
 	return result;
 }
 
+std::shared_ptr<cga::wire_message const> cga::election::publish_message ()
+{
+	auto hash (status.winner->hash ());
+	if (winner_message == nullptr || winner_message_hash != hash)
+	{
+		winner_message = std::make_shared<cga::wire_message const> (cga::publish (status.winner));
+		winner_message_hash = hash;
+	}
+	return winner_message;
+}
+
 size_t cga::election::last_votes_size ()
 {
-	std::lock_guard<std::mutex> lock (node.active.mutex);
+	std::lock_guard<std::mutex> lock (node.active.partition_for (root).mutex);
 	return last_votes.size ();
 }
 
-void cga::active_transactions::request_confirm (std::unique_lock<std::mutex> & lock_a)
+void cga::active_transactions::request_confirm ()
 {
-	std::unordered_set<cga::uint512_union> inactive;
+	// Merge the difficulty ordered indexes of all partitions so the highest difficulty elections are announced first
+	std::vector<std::pair<uint64_t, std::shared_ptr<cga::election>>> elections_l;
+	for (auto & partition_l : partitions)
+	{
+		std::lock_guard<std::mutex> lock (partition_l->mutex);
+		for (auto & info : partition_l->roots.get<1> ())
+		{
+			elections_l.push_back (std::make_pair (info.difficulty, info.election));
+		}
+	}
+	std::stable_sort (elections_l.begin (), elections_l.end (), [](std::pair<uint64_t, std::shared_ptr<cga::election>> const & lhs, std::pair<uint64_t, std::shared_ptr<cga::election>> const & rhs) {
+		return lhs.first > rhs.first;
+	});
+	std::vector<std::shared_ptr<cga::election>> inactive;
+	std::deque<cga::election_status> confirmed_l;
+	std::deque<std::shared_ptr<cga::block>> escalated;
 	auto transaction (node.store.tx_begin_read ());
 	unsigned unconfirmed_count (0);
 	unsigned unconfirmed_announcements (0);
 	std::unordered_map<cga::endpoint, std::vector<std::pair<cga::block_hash, cga::block_hash>>> requests_bundle;
-	std::deque<std::shared_ptr<cga::block>> rebroadcast_bundle;
+	std::deque<std::pair<cga::block_hash, std::shared_ptr<cga::wire_message const>>> rebroadcast_bundle;
 	std::deque<std::pair<std::shared_ptr<cga::block>, std::shared_ptr<std::vector<cga::peer_information>>>> confirm_req_bundle;
 
-	auto roots_size (roots.size ());
-	for (auto i (roots.get<1> ().begin ()), n (roots.get<1> ().end ()); i != n; ++i)
+	auto roots_size (elections_l.size ());
+	for (auto & item : elections_l)
 	{
-		auto root (i->root);
-		auto election_l (i->election);
-		if ((election_l->confirmed || election_l->stopped) && election_l->announcements >= announcement_min - 1)
+		auto election_l (item.second);
+		auto & partition_l (partition_for (election_l->root));
+		std::lock_guard<std::mutex> lock (partition_l.mutex);
+		auto root_it (partition_l.roots.find (election_l->root));
+		if (root_it == partition_l.roots.end () || root_it->election != election_l)
+		{
+			// Erased since the partitions were copied, it's no longer tallied or announced
+		}
+		else if ((election_l->confirmed || election_l->stopped) && election_l->announcements >= announcement_min - 1)
 		{
 			if (election_l->confirmed)
 			{
-				confirmed.push_back (election_l->status);
-				if (confirmed.size () > election_history_size)
-				{
-					confirmed.pop_front ();
-				}
+				confirmed_l.push_back (election_l->status);
 			}
-			inactive.insert (root);
+			inactive.push_back (election_l);
 		}
 		else
 		{
@@ -3349,7 +3939,7 @@ void cga::active_transactions::request_confirm (std::unique_lock<std::mutex> & l
 						previous = node.store.block_get (transaction, previous_hash);
 						if (previous != nullptr)
 						{
-							add (std::move (previous));
+							escalated.push_back (previous);
 						}
 					}
 					/* If previous block not existing/not commited yet, block_source can cause segfault for state blocks
@@ -3362,7 +3952,7 @@ void cga::active_transactions::request_confirm (std::unique_lock<std::mutex> & l
 							auto source (node.store.block_get (transaction, source_hash));
 							if (source != nullptr)
 							{
-								add (std::move (source));
+								escalated.push_back (std::move (source));
 							}
 						}
 					}
@@ -3375,7 +3965,7 @@ void cga::active_transactions::request_confirm (std::unique_lock<std::mutex> & l
 					// Broadcast winner
 					if (rebroadcast_bundle.size () < max_broadcast_queue)
 					{
-						rebroadcast_bundle.push_back (election_l->status.winner);
+						rebroadcast_bundle.emplace_back (election_l->status.winner->hash (), election_l->publish_message ());
 					}
 				}
 				else
@@ -3483,7 +4073,10 @@ void cga::active_transactions::request_confirm (std::unique_lock<std::mutex> & l
 		}
 		++election_l->announcements;
 	}
-	lock_a.unlock ();
+	for (auto & block : escalated)
+	{
+		start (block);
+	}
 	// Rebroadcast unconfirmed blocks
 	if (!rebroadcast_bundle.empty ())
 	{
@@ -3499,18 +4092,36 @@ void cga::active_transactions::request_confirm (std::unique_lock<std::mutex> & l
 	{
 		node.network.broadcast_confirm_req_batch (confirm_req_bundle);
 	}
-	lock_a.lock ();
-	for (auto i (inactive.begin ()), n (inactive.end ()); i != n; ++i)
+	for (auto & election_l : inactive)
+	{
+		auto & partition_l (partition_for (election_l->root));
+		std::lock_guard<std::mutex> partition_lock (partition_l.mutex);
+		auto root_it (partition_l.roots.find (election_l->root));
+		if (root_it != partition_l.roots.end () && root_it->election == election_l)
+		{
+			{
+				std::lock_guard<std::mutex> lock (mutex);
+				for (auto & block : election_l->blocks)
+				{
+					auto erased (blocks.erase (block.first));
+					(void)erased;
+					assert (erased == 1);
+				}
+			}
+			partition_l.roots.erase (root_it);
+		}
+	}
+	if (!confirmed_l.empty ())
 	{
-		auto root_it (roots.find (*i));
-		assert (root_it != roots.end ());
-		for (auto & block : root_it->election->blocks)
+		std::lock_guard<std::mutex> lock (mutex);
+		for (auto & status : confirmed_l)
 		{
-			auto erased (blocks.erase (block.first));
-			(void)erased;
-			assert (erased == 1);
+			confirmed.push_back (status);
+			if (confirmed.size () > election_history_size)
+			{
+				confirmed.pop_front ();
+			}
 		}
-		roots.erase (*i);
 	}
 	if (unconfirmed_count > 0)
 	{
@@ -3525,13 +4136,17 @@ void cga::active_transactions::request_loop ()
 
 	lock.unlock ();
 	condition.notify_all ();
-	lock.lock ();
 
 	while (!stopped)
 	{
-		request_confirm (lock);
-		const auto extra_delay (std::min (roots.size (), max_broadcast_queue) * node.network.broadcast_interval_ms * 2);
-		condition.wait_for (lock, std::chrono::milliseconds (request_interval_ms + extra_delay));
+		request_confirm ();
+		const auto extra_delay (std::min (size (), max_broadcast_queue) * node.network.broadcast_interval_ms * 2);
+		lock.lock ();
+		if (!stopped)
+		{
+			condition.wait_for (lock, std::chrono::milliseconds (request_interval_ms + extra_delay));
+		}
+		lock.unlock ();
 	}
 }
 
@@ -3549,73 +4164,122 @@ void cga::active_transactions::stop ()
 	{
 		thread.join ();
 	}
+	for (auto & partition_l : partitions)
+	{
+		std::lock_guard<std::mutex> partition_lock (partition_l->mutex);
+		partition_l->roots.clear ();
+	}
 	lock.lock ();
-	roots.clear ();
+	blocks.clear ();
 }
 
-bool cga::active_transactions::start (std::shared_ptr<cga::block> block_a, std::function<void(std::shared_ptr<cga::block>)> const & confirmation_action_a)
+cga::active_transactions::partition & cga::active_transactions::partition_for (cga::uint512_union const & root_a)
+{
+	// Mix both halves, open blocks share a zero previous
+	return *partitions[(root_a.qwords[0] ^ root_a.qwords[4]) % partitions.size ()];
+}
+
+std::shared_ptr<cga::election> cga::active_transactions::election (cga::block_hash const & hash_a)
 {
+	std::shared_ptr<cga::election> result;
 	std::lock_guard<std::mutex> lock (mutex);
-	return add (block_a, confirmation_action_a);
+	auto existing (blocks.find (hash_a));
+	if (existing != blocks.end ())
+	{
+		result = existing->second;
+	}
+	return result;
+}
+
+bool cga::active_transactions::start (std::shared_ptr<cga::block> block_a, std::function<void(std::shared_ptr<cga::block>)> const & confirmation_action_a)
+{
+	auto error (true);
+	auto root (cga::uint512_union (block_a->previous (), block_a->root ()));
+	std::shared_ptr<cga::block> successor;
+	{
+		auto transaction (node.store.tx_begin_read ());
+		successor = node.ledger.successor (transaction, root);
+		// An election can't replace whatever occupies a cemented slot, so there's nothing to vote on
+		if (successor != nullptr && node.ledger.block_confirmed (transaction, successor->hash ()))
+		{
+			node.stats.inc (cga::stat::type::confirmation_height, cga::stat::detail::cemented);
+		}
+		else
+		{
+			successor = nullptr;
+		}
+	}
+	if (successor == nullptr)
+	{
+		auto & partition_l (partition_for (root));
+		std::lock_guard<std::mutex> lock (partition_l.mutex);
+		error = add (partition_l, block_a, confirmation_action_a);
+	}
+	return error;
 }
 
-bool cga::active_transactions::add (std::shared_ptr<cga::block> block_a, std::function<void(std::shared_ptr<cga::block>)> const & confirmation_action_a)
+bool cga::active_transactions::add (cga::active_transactions::partition & partition_a, std::shared_ptr<cga::block> block_a, std::function<void(std::shared_ptr<cga::block>)> const & confirmation_action_a)
 {
 	auto error (true);
 	if (!stopped)
 	{
 		auto root (cga::uint512_union (block_a->previous (), block_a->root ()));
-		auto existing (roots.find (root));
-		if (existing == roots.end ())
+		auto existing (partition_a.roots.find (root));
+		if (existing == partition_a.roots.end ())
 		{
 			auto election (std::make_shared<cga::election> (node, block_a, confirmation_action_a));
 			uint64_t difficulty (0);
 			auto error (cga::work_validate (*block_a, &difficulty));
 			release_assert (!error);
-			roots.insert (cga::conflict_info{ root, difficulty, election });
-			blocks.insert (std::make_pair (block_a->hash (), election));
+			partition_a.roots.insert (cga::conflict_info{ root, difficulty, election });
+			auto hash (block_a->hash ());
+			node.tracer.record (hash, cga::block_tracer::stage::active_start);
+			std::lock_guard<std::mutex> lock (mutex);
+			blocks.insert (std::make_pair (hash, election));
 		}
-		error = existing != roots.end ();
+		error = existing != partition_a.roots.end ();
 	}
 	return error;
 }
 
 // Validate a vote and apply it to the current election if one exists
-bool cga::active_transactions::vote (std::shared_ptr<cga::vote> vote_a, bool single_lock)
+bool cga::active_transactions::vote (std::shared_ptr<cga::vote> vote_a)
 {
-	std::shared_ptr<cga::election> election;
 	bool replay (false);
 	bool processed (false);
+	for (auto vote_block : vote_a->blocks)
 	{
-		std::unique_lock<std::mutex> lock;
-		if (!single_lock)
-		{
-			lock = std::unique_lock<std::mutex> (mutex);
-		}
-		for (auto vote_block : vote_a->blocks)
+		cga::election_vote_result result;
+		if (vote_block.which ())
 		{
-			cga::election_vote_result result;
-			if (vote_block.which ())
+			auto block_hash (boost::get<cga::block_hash> (vote_block));
+			auto existing (election (block_hash));
+			if (existing != nullptr)
 			{
-				auto block_hash (boost::get<cga::block_hash> (vote_block));
-				auto existing (blocks.find (block_hash));
-				if (existing != blocks.end ())
+				auto & partition_l (partition_for (existing->root));
+				std::lock_guard<std::mutex> lock (partition_l.mutex);
+				// The election may have finished since it was looked up
+				auto root_it (partition_l.roots.find (existing->root));
+				if (root_it != partition_l.roots.end () && root_it->election == existing)
 				{
-					result = existing->second->vote (vote_a->account, vote_a->sequence, block_hash);
+					result = existing->vote (vote_a->account, vote_a->sequence, block_hash);
 				}
 			}
-			else
+		}
+		else
+		{
+			auto block (boost::get<std::shared_ptr<cga::block>> (vote_block));
+			auto root (cga::uint512_union (block->previous (), block->root ()));
+			auto & partition_l (partition_for (root));
+			std::lock_guard<std::mutex> lock (partition_l.mutex);
+			auto existing (partition_l.roots.find (root));
+			if (existing != partition_l.roots.end ())
 			{
-				auto block (boost::get<std::shared_ptr<cga::block>> (vote_block));
-				auto existing (roots.find (cga::uint512_union (block->previous (), block->root ())));
-				if (existing != roots.end ())
-				{
-					result = existing->election->vote (vote_a->account, vote_a->sequence, block->hash ());
-				}
+				result = existing->election->vote (vote_a->account, vote_a->sequence, block->hash ());
 			}
-			replay = replay || result.replay;
-			processed = processed || result.processed;
 		}
+		replay = replay || result.replay;
+		processed = processed || result.processed;
 	}
 	if (processed)
 	{
@@ -3624,39 +4288,69 @@ bool cga::active_transactions::vote (std::shared_ptr<cga::vote> vote_a, bool sin
 	return replay;
 }
 
+void cga::active_transactions::confirm_back (std::shared_ptr<cga::block> block_a)
+{
+	auto transaction (node.store.tx_begin_read ());
+	std::deque<cga::block_hash> hashes = { block_a->previous (), block_a->source (), block_a->link () };
+	while (!hashes.empty ())
+	{
+		auto hash (hashes.front ());
+		hashes.pop_front ();
+		if (!hash.is_zero () && !node.ledger.is_epoch_link (hash))
+		{
+			auto existing (election (hash));
+			if (existing != nullptr)
+			{
+				std::lock_guard<std::mutex> lock (partition_for (existing->root).mutex);
+				if (!existing->confirmed && !existing->stopped && existing->blocks.size () == 1)
+				{
+					release_assert (existing->status.winner->hash () == hash);
+					existing->confirm_once (true); // Avoid recursive actions
+					hashes.push_back (existing->status.winner->previous ());
+					hashes.push_back (existing->status.winner->source ());
+					hashes.push_back (existing->status.winner->link ());
+				}
+			}
+		}
+	}
+}
+
 bool cga::active_transactions::active (cga::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.find (cga::uint512_union (block_a.previous (), block_a.root ())) != roots.end ();
+	auto root (cga::uint512_union (block_a.previous (), block_a.root ()));
+	auto & partition_l (partition_for (root));
+	std::lock_guard<std::mutex> lock (partition_l.mutex);
+	return partition_l.roots.find (root) != partition_l.roots.end ();
 }
 
 void cga::active_transactions::update_difficulty (cga::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	auto existing (roots.find (cga::uint512_union (block_a.previous (), block_a.root ())));
-	if (existing != roots.end ())
+	auto root (cga::uint512_union (block_a.previous (), block_a.root ()));
+	auto & partition_l (partition_for (root));
+	std::lock_guard<std::mutex> lock (partition_l.mutex);
+	auto existing (partition_l.roots.find (root));
+	if (existing != partition_l.roots.end ())
 	{
 		uint64_t difficulty;
 		auto error (cga::work_validate (block_a, &difficulty));
 		assert (!error);
-		roots.modify (existing, [difficulty](cga::conflict_info & info_a) {
+		partition_l.roots.modify (existing, [difficulty](cga::conflict_info & info_a) {
 			info_a.difficulty = difficulty;
 		});
 	}
 }
 
 // List of active blocks in elections
-std::deque<std::shared_ptr<cga::block>> cga::active_transactions::list_blocks (bool single_lock)
+std::deque<std::shared_ptr<cga::block>> cga::active_transactions::list_blocks ()
 {
 	std::deque<std::shared_ptr<cga::block>> result;
-	std::unique_lock<std::mutex> lock;
-	if (!single_lock)
+	for (auto & partition_l : partitions)
 	{
-		lock = std::unique_lock<std::mutex> (mutex);
-	}
-	for (auto i (roots.begin ()), n (roots.end ()); i != n; ++i)
-	{
-		result.push_back (i->election->status.winner);
+		std::lock_guard<std::mutex> lock (partition_l->mutex);
+		for (auto i (partition_l->roots.begin ()), n (partition_l->roots.end ()); i != n; ++i)
+		{
+			result.push_back (i->election->status.winner);
+		}
 	}
 	return result;
 }
@@ -3669,35 +4363,53 @@ std::deque<cga::election_status> cga::active_transactions::list_confirmed ()
 
 void cga::active_transactions::erase (cga::block const & block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	if (roots.find (cga::uint512_union (block_a.previous (), block_a.root ())) != roots.end ())
+	auto root (cga::uint512_union (block_a.previous (), block_a.root ()));
+	auto & partition_l (partition_for (root));
+	std::lock_guard<std::mutex> partition_lock (partition_l.mutex);
+	auto existing (partition_l.roots.find (root));
+	if (existing != partition_l.roots.end ())
 	{
-		roots.erase (cga::uint512_union (block_a.previous (), block_a.root ()));
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			for (auto & block : existing->election->blocks)
+			{
+				blocks.erase (block.first);
+			}
+		}
+		partition_l.roots.erase (existing);
 		BOOST_LOG (node.log) << boost::str (boost::format ("Election erased for block block %1% root %2%") % block_a.hash ().to_string () % block_a.root ().to_string ());
 	}
 }
 
 bool cga::active_transactions::empty ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.empty ();
+	return size () == 0;
 }
 
 size_t cga::active_transactions::size ()
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	return roots.size ();
+	size_t result (0);
+	for (auto & partition_l : partitions)
+	{
+		std::lock_guard<std::mutex> lock (partition_l->mutex);
+		result += partition_l->roots.size ();
+	}
+	return result;
 }
 
 cga::active_transactions::active_transactions (cga::node & node_a) :
 node (node_a),
 started (false),
-stopped (false),
-thread ([this]() {
-	cga::thread_role::set (cga::thread_role::name::request_loop);
-	request_loop ();
-})
+stopped (false)
 {
+	for (size_t i (0); i < partitions_count; ++i)
+	{
+		partitions.push_back (std::make_unique<cga::active_transactions::partition> ());
+	}
+	thread = boost::thread ([this]() {
+		cga::thread_role::set (cga::thread_role::name::request_loop);
+		request_loop ();
+	});
 	std::unique_lock<std::mutex> lock (mutex);
 	while (!started)
 	{
@@ -3712,14 +4424,17 @@ cga::active_transactions::~active_transactions ()
 
 bool cga::active_transactions::publish (std::shared_ptr<cga::block> block_a)
 {
-	std::lock_guard<std::mutex> lock (mutex);
-	auto existing (roots.find (cga::uint512_union (block_a->previous (), block_a->root ())));
+	auto root (cga::uint512_union (block_a->previous (), block_a->root ()));
+	auto & partition_l (partition_for (root));
+	std::lock_guard<std::mutex> partition_lock (partition_l.mutex);
+	auto existing (partition_l.roots.find (root));
 	auto result (true);
-	if (existing != roots.end ())
+	if (existing != partition_l.roots.end ())
 	{
 		result = existing->election->publish (block_a);
 		if (!result)
 		{
+			std::lock_guard<std::mutex> lock (mutex);
 			blocks.insert (std::make_pair (block_a->hash (), existing->election));
 		}
 	}
@@ -3730,19 +4445,18 @@ namespace cga
 {
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (active_transactions & active_transactions, const std::string & name)
 {
-	size_t roots_count = 0;
+	size_t roots_count = active_transactions.size ();
 	size_t blocks_count = 0;
 	size_t confirmed_count = 0;
 
 	{
 		std::lock_guard<std::mutex> guard (active_transactions.mutex);
-		roots_count = active_transactions.roots.size ();
 		blocks_count = active_transactions.blocks.size ();
 		confirmed_count = active_transactions.confirmed.size ();
 	}
 
 	auto composite = std::make_unique<seq_con_info_composite> (name);
-	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "roots", roots_count, sizeof (decltype (active_transactions.roots)::value_type) }));
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "roots", roots_count, sizeof (decltype (cga::active_transactions::partition::roots)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "blocks", blocks_count, sizeof (decltype (active_transactions.blocks)::value_type) }));
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "confirmed", confirmed_count, sizeof (decltype (active_transactions.confirmed)::value_type) }));
 	return composite;
@@ -3833,72 +4547,119 @@ stopped (false)
 	assert (size > 0);
 	auto slab_data (slab.data ());
 	auto entry_data (entries.data ());
-	for (auto i (0); i < count; ++i, ++entry_data)
+	for (size_t i (0); i < count; ++i, ++entry_data)
 	{
-		*entry_data = { slab_data + i * size, 0, cga::endpoint () };
-		free.push_back (entry_data);
+		*entry_data = { slab_data + i * size, 0, cga::endpoint (), std::chrono::steady_clock::time_point () };
+		auto pushed (free.push (entry_data));
+		release_assert (pushed);
 	}
 }
 cga::udp_data * cga::udp_buffer::allocate ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && free.empty () && full.empty ())
+	auto stolen (false);
+	auto result (take (stolen));
+	if (stolen)
 	{
-		stats.inc (cga::stat::type::udp, cga::stat::detail::blocking, cga::stat::dir::in);
-		condition.wait (lock);
+		stats.inc (cga::stat::type::udp, cga::stat::detail::overflow, cga::stat::dir::in);
 	}
+	return result;
+}
+cga::udp_data * cga::udp_buffer::take (bool & stolen_a)
+{
 	cga::udp_data * result (nullptr);
-	if (!free.empty ())
+	auto pop = [this, &result, &stolen_a]() {
+		auto found (free.pop (result));
+		if (!found && full.pop (result))
+		{
+			// Drop the oldest unserviced buffer
+			stolen_a = true;
+			found = true;
+		}
+		return found;
+	};
+	while (!pop () && !stopped.load ())
 	{
-		result = free.front ();
-		free.pop_front ();
+		auto epoch (free_event.prepare_wait ());
+		// A buffer released or enqueued before preparing to wait doesn't wake us, so both rings are checked again
+		if (pop () || stopped.load ())
+		{
+			break;
+		}
+		stats.inc (cga::stat::type::udp, cga::stat::detail::blocking, cga::stat::dir::in);
+		free_event.wait (epoch);
 	}
-	if (result == nullptr)
+	return result;
+}
+bool cga::udp_buffer::allocate (std::vector<cga::udp_data *> & result_a, size_t max_a)
+{
+	result_a.clear ();
+	auto result (false);
+	auto data (take (result));
+	while (data != nullptr)
 	{
-		result = full.front ();
-		full.pop_front ();
-		stats.inc (cga::stat::type::udp, cga::stat::detail::overflow, cga::stat::dir::in);
+		result_a.push_back (data);
+		data = nullptr;
+		if (result_a.size () < max_a)
+		{
+			free.pop (data);
+		}
 	}
 	return result;
 }
 void cga::udp_buffer::enqueue (cga::udp_data * data_a)
 {
 	assert (data_a != nullptr);
-	{
-		std::lock_guard<std::mutex> lock (mutex);
-		full.push_back (data_a);
-	}
-	condition.notify_all ();
+	auto pushed (full.push (data_a));
+	release_assert (pushed);
+	full_event.notify_all ();
+	free_event.notify_all ();
 }
 cga::udp_data * cga::udp_buffer::dequeue ()
 {
-	std::unique_lock<std::mutex> lock (mutex);
-	while (!stopped && full.empty ())
-	{
-		condition.wait (lock);
-	}
 	cga::udp_data * result (nullptr);
-	if (!full.empty ())
+	while (!full.pop (result) && !stopped.load ())
 	{
-		result = full.front ();
-		full.pop_front ();
+		auto epoch (full_event.prepare_wait ());
+		if (full.pop (result) || stopped.load ())
+		{
+			break;
+		}
+		full_event.wait (epoch);
 	}
 	return result;
 }
-void cga::udp_buffer::release (cga::udp_data * data_a)
+void cga::udp_buffer::dequeue (std::vector<cga::udp_data *> & result_a, size_t max_a)
 {
-	assert (data_a != nullptr);
+	result_a.clear ();
+	auto data (dequeue ());
+	while (data != nullptr)
 	{
-		std::lock_guard<std::mutex> lock (mutex);
-		free.push_back (data_a);
+		result_a.push_back (data);
+		data = nullptr;
+		if (result_a.size () < max_a)
+		{
+			full.pop (data);
+		}
 	}
-	condition.notify_all ();
+}
+void cga::udp_buffer::release (cga::udp_data * data_a)
+{
+	assert (data_a != nullptr);
+	auto pushed (free.push (data_a));
+	release_assert (pushed);
+	free_event.notify_all ();
 }
 void cga::udp_buffer::stop ()
 {
-	{
-		std::lock_guard<std::mutex> lock (mutex);
-		stopped = true;
-	}
-	condition.notify_all ();
+	stopped = true;
+	free_event.notify_all ();
+	full_event.notify_all ();
+}
+size_t cga::udp_buffer::size () const
+{
+	return full.size ();
+}
+size_t cga::udp_buffer::capacity () const
+{
+	return entries.size ();
 }
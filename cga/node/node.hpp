@@ -1,14 +1,18 @@
 #pragma once
 
+#include <cga/lib/lockfree.hpp>
+#include <cga/lib/timing_wheel.hpp>
 #include <cga/lib/work.hpp>
 #include <cga/node/blockprocessor.hpp>
 #include <cga/node/bootstrap.hpp>
+#include <cga/node/confirmation_height_processor.hpp>
 #include <cga/node/logging.hpp>
 #include <cga/node/nodeconfig.hpp>
 #include <cga/node/peers.hpp>
 #include <cga/node/portmapping.hpp>
 #include <cga/node/signatures.hpp>
 #include <cga/node/stats.hpp>
+#include <cga/node/tracer.hpp>
 #include <cga/node/wallet.hpp>
 #include <cga/secure/ledger.hpp>
 
@@ -52,6 +56,8 @@ public:
 	std::chrono::steady_clock::time_point time;
 	uint64_t sequence;
 	cga::block_hash hash;
+	// Weight of the representative when the vote was tallied
+	cga::uint128_t weight;
 };
 class election_vote_result
 {
@@ -64,8 +70,10 @@ public:
 class election : public std::enable_shared_from_this<cga::election>
 {
 	std::function<void(std::shared_ptr<cga::block>)> confirmation_action;
-	void confirm_once (cga::transaction const &, bool = false);
-	void confirm_back (cga::transaction const &);
+	void confirm_once (bool = false);
+	// Recompute cached voter weights and last_tally from the ledger
+	void refresh_tally (cga::transaction const &);
+	friend class active_transactions;
 
 public:
 	election (cga::node &, std::shared_ptr<cga::block>, std::function<void(std::shared_ptr<cga::block>)> const &);
@@ -79,17 +87,28 @@ public:
 	void confirm_if_quorum (cga::transaction const &);
 	void log_votes (cga::tally_t const &);
 	bool publish (std::shared_ptr<cga::block> block_a);
+	// Serialized publish of the current winner, rebuilt only when the winner changes. Requires the partition mutex
+	std::shared_ptr<cga::wire_message const> publish_message ();
 	size_t last_votes_size ();
 	void stop ();
 	cga::node & node;
+	// Root shared by all competing blocks, selects the active_transactions partition guarding this election
+	cga::uint512_union const root;
 	std::unordered_map<cga::account, cga::vote_info> last_votes;
 	std::unordered_map<cga::block_hash, std::shared_ptr<cga::block>> blocks;
 	std::chrono::steady_clock::time_point election_start;
 	cga::election_status status;
 	std::atomic<bool> confirmed;
 	bool stopped;
+	// Running weight sum per block, adjusted incrementally as votes arrive
 	std::unordered_map<cga::block_hash, cga::uint128_t> last_tally;
+	// Value of ledger.weights_epoch when last_tally was last refreshed
+	uint64_t weights_epoch;
 	unsigned announcements;
+
+private:
+	std::shared_ptr<cga::wire_message const> winner_message;
+	cga::block_hash winner_message_hash;
 };
 class conflict_info
 {
@@ -100,9 +119,24 @@ public:
 };
 // Core class for determining consensus
 // Holds all active blocks i.e. recently added blocks that need confirmation
+// Elections are hash-partitioned by root, each partition's mutex guards its roots and the state of their elections
 class active_transactions
 {
 public:
+	class partition
+	{
+	public:
+		std::mutex mutex;
+		boost::multi_index_container<
+		cga::conflict_info,
+		boost::multi_index::indexed_by<
+		boost::multi_index::hashed_unique<
+		boost::multi_index::member<cga::conflict_info, cga::uint512_union, &cga::conflict_info::root>>,
+		boost::multi_index::ordered_non_unique<
+		boost::multi_index::member<cga::conflict_info, uint64_t, &cga::conflict_info::difficulty>,
+		std::greater<uint64_t>>>>
+		roots;
+	};
 	active_transactions (cga::node &);
 	~active_transactions ();
 	// Start an election for a block
@@ -112,30 +146,25 @@ public:
 	// clang-format on
 	// If this returns true, the vote is a replay
 	// If this returns false, the vote may or may not be a replay
-	bool vote (std::shared_ptr<cga::vote>, bool = false);
+	bool vote (std::shared_ptr<cga::vote>);
 	// Is the root of this block in the roots container
 	bool active (cga::block const &);
 	void update_difficulty (cga::block const &);
-	std::deque<std::shared_ptr<cga::block>> list_blocks (bool = false);
+	std::deque<std::shared_ptr<cga::block>> list_blocks ();
 	void erase (cga::block const &);
 	bool empty ();
 	size_t size ();
 	void stop ();
 	bool publish (std::shared_ptr<cga::block> block_a);
-	boost::multi_index_container<
-	cga::conflict_info,
-	boost::multi_index::indexed_by<
-	boost::multi_index::hashed_unique<
-	boost::multi_index::member<cga::conflict_info, cga::uint512_union, &cga::conflict_info::root>>,
-	boost::multi_index::ordered_non_unique<
-	boost::multi_index::member<cga::conflict_info, uint64_t, &cga::conflict_info::difficulty>,
-	std::greater<uint64_t>>>>
-	roots;
-	std::unordered_map<cga::block_hash, std::shared_ptr<cga::election>> blocks;
+	// Confirm elections for the dependencies of a confirmed block
+	void confirm_back (std::shared_ptr<cga::block>);
+	// Partition guarding elections for this root
+	cga::active_transactions::partition & partition_for (cga::uint512_union const &);
+	// Election containing this block, nullptr if there is none. Lock its partition before accessing its state.
+	std::shared_ptr<cga::election> election (cga::block_hash const &);
+	std::vector<std::unique_ptr<cga::active_transactions::partition>> partitions;
 	std::deque<cga::election_status> list_confirmed ();
-	std::deque<cga::election_status> confirmed;
 	cga::node & node;
-	std::mutex mutex;
 	// Maximum number of conflicts to vote on per interval, lowest root hash first
 	static unsigned constexpr announcements_per_interval = 32;
 	// Minimum number of block announcements
@@ -145,41 +174,54 @@ public:
 	static unsigned constexpr request_interval_ms = cga::is_test_network ? 10 : 16000;
 	static size_t constexpr election_history_size = 2048;
 	static size_t constexpr max_broadcast_queue = 1000;
+	static size_t constexpr partitions_count = 16;
 
 private:
+	// Partition lock required
 	// Call action with confirmed block, may be different than what we started with
-	// clang-format off
-	bool add (std::shared_ptr<cga::block>, std::function<void(std::shared_ptr<cga::block>)> const & = [](std::shared_ptr<cga::block>) {});
-	// clang-format on
+	bool add (cga::active_transactions::partition &, std::shared_ptr<cga::block>, std::function<void(std::shared_ptr<cga::block>)> const &);
 	void request_loop ();
-	void request_confirm (std::unique_lock<std::mutex> &);
+	void request_confirm ();
+	// Guards blocks, confirmed and the request loop state. May be acquired while holding a partition mutex, never the reverse.
+	std::mutex mutex;
+	std::unordered_map<cga::block_hash, std::shared_ptr<cga::election>> blocks;
+	std::deque<cga::election_status> confirmed;
 	std::condition_variable condition;
 	bool started;
-	bool stopped;
+	std::atomic<bool> stopped;
 	boost::thread thread;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (active_transactions & active_transactions, const std::string & name);
 };
 
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (active_transactions & active_transactions, const std::string & name);
 
-class operation
-{
-public:
-	bool operator> (cga::operation const &) const;
-	std::chrono::steady_clock::time_point wakeup;
-	std::function<void()> function;
-};
+/**
+ * Runs operations on the io_context once their time comes. Operations are kept in a timing wheel so adding and
+ * cancelling them is constant time however many are pending, and everything due is posted in one batch.
+ */
 class alarm
 {
 public:
 	alarm (boost::asio::io_context &);
 	~alarm ();
-	void add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	cga::timing_wheel::handle add (std::chrono::steady_clock::time_point const &, std::function<void()> const &);
+	// Returns true if the operation couldn't be cancelled because it has already been posted
+	bool cancel (cga::timing_wheel::handle const &);
+	size_t size ();
 	void run ();
 	boost::asio::io_context & io_ctx;
+
+private:
 	std::mutex mutex;
 	std::condition_variable condition;
-	std::priority_queue<operation, std::vector<operation>, std::greater<operation>> operations;
+	cga::timing_wheel operations;
+	// When the alarm thread is waiting until, adds only need to wake it for anything earlier
+	std::chrono::steady_clock::time_point sleeping_until;
+	bool stopped;
 	boost::thread thread;
+
+	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (alarm & alarm, const std::string & name);
 };
 
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (alarm & alarm, const std::string & name);
@@ -261,7 +303,7 @@ public:
 	static uint64_t constexpr weight_samples = cga::is_live_network ? 4032 : 864;
 
 private:
-	cga::uint128_t trend (cga::transaction &);
+	cga::uint128_t trend (cga::transaction const &);
 	std::mutex mutex;
 	cga::ledger & ledger;
 	std::unordered_set<cga::account> reps;
@@ -279,6 +321,8 @@ public:
 	uint8_t * buffer;
 	size_t size;
 	cga::endpoint endpoint;
+	// When the datagram was received, to trace how long it waited to be serviced. Only set while tracing is enabled
+	std::chrono::steady_clock::time_point arrival;
 };
 /**
   * A circular buffer for servicing UDP datagrams. This container follows a producer/consumer model where the operating system is producing data in to buffers which are serviced by internal threads.
@@ -299,26 +343,43 @@ public:
 	// Function will block if there are no free or unserviced buffers
 	// Return nullptr if the container has stopped
 	cga::udp_data * allocate ();
+	// Fill with up to max buffers where UDP data can be put
+	// The first buffer is obtained as by allocate (), further ones are only taken if they are free
+	// Leaves the vector empty if the container has stopped
+	// Returns true if the first buffer was taken unserviced, its data is intact until written to so it can be enqueued again if unused.
+	// The overflow isn't counted, the caller does so once the buffer is overwritten
+	bool allocate (std::vector<cga::udp_data *> &, size_t);
 	// Queue a buffer that has been filled with UDP data and notify servicing threads
 	void enqueue (cga::udp_data *);
 	// Return a buffer that has been filled with UDP data
 	// Function will block until a buffer has been added
 	// Return nullptr if the container has stopped
 	cga::udp_data * dequeue ();
+	// Fill with up to max buffers that have been filled with UDP data
+	// Function will block until at least one buffer has been added
+	// Leaves the vector empty if the container has stopped
+	void dequeue (std::vector<cga::udp_data *> &, size_t);
 	// Return a buffer to the freelist after is has been serviced
 	void release (cga::udp_data *);
 	// Stop container and notify waiting threads
 	void stop ();
+	// Number of buffers filled with UDP data and waiting to be serviced
+	size_t size () const;
+	size_t capacity () const;
 
 private:
+	// Blocking part of allocate, sets the flag if an unserviced buffer was taken
+	cga::udp_data * take (bool &);
 	cga::stat & stats;
-	std::mutex mutex;
-	std::condition_variable condition;
-	boost::circular_buffer<cga::udp_data *> free;
-	boost::circular_buffer<cga::udp_data *> full;
+	cga::mpmc_ring<cga::udp_data *> free;
+	cga::mpmc_ring<cga::udp_data *> full;
+	// Signalled when a buffer is released or enqueued, wakes threads blocked in allocate
+	cga::event_count free_event;
+	// Signalled when a buffer is enqueued, wakes threads blocked in dequeue
+	cga::event_count full_event;
 	std::vector<uint8_t> slab;
 	std::vector<cga::udp_data> entries;
-	bool stopped;
+	std::atomic<bool> stopped;
 };
 class network
 {
@@ -330,22 +391,27 @@ public:
 	void start ();
 	void stop ();
 	void receive_action (cga::udp_data *, cga::endpoint const &);
+	void receive_burst (std::vector<cga::udp_data *> const &, cga::endpoint const &);
 	void rpc_action (boost::system::error_code const &, size_t);
 	void republish_vote (std::shared_ptr<cga::vote>);
 	void republish_block (std::shared_ptr<cga::block>);
 	void republish_block (std::shared_ptr<cga::block>, cga::endpoint const &);
+	// Republish an already serialized publish message to peers
+	void republish_block (cga::block_hash const &, std::shared_ptr<cga::wire_message const> const &);
 	static unsigned const broadcast_interval_ms = 10;
 	void republish_block_batch (std::deque<std::shared_ptr<cga::block>>, unsigned = broadcast_interval_ms);
-	void republish (cga::block_hash const &, std::shared_ptr<std::vector<uint8_t>>, cga::endpoint);
-	void confirm_send (cga::confirm_ack const &, std::shared_ptr<std::vector<uint8_t>>, cga::endpoint const &);
+	void republish_block_batch (std::deque<std::pair<cga::block_hash, std::shared_ptr<cga::wire_message const>>>, unsigned = broadcast_interval_ms);
+	void republish (cga::block_hash const &, std::shared_ptr<cga::wire_message const> const &, cga::endpoint);
+	void confirm_send (std::shared_ptr<cga::vote> const &, std::shared_ptr<cga::wire_message const> const &, cga::endpoint const &);
 	void merge_peers (std::array<cga::endpoint, 8> const &);
 	void send_keepalive (cga::endpoint const &);
 	void send_node_id_handshake (cga::endpoint const &, boost::optional<cga::uint256_union> const & query, boost::optional<cga::uint256_union> const & respond_to);
 	void broadcast_confirm_req (std::shared_ptr<cga::block>);
-	void broadcast_confirm_req_base (std::shared_ptr<cga::block>, std::shared_ptr<std::vector<cga::peer_information>>, unsigned, bool = false);
+	void broadcast_confirm_req_base (std::shared_ptr<cga::block>, std::shared_ptr<std::vector<cga::peer_information>>, unsigned, bool = false, std::shared_ptr<cga::wire_message const> = nullptr);
 	void broadcast_confirm_req_batch (std::unordered_map<cga::endpoint, std::vector<std::pair<cga::block_hash, cga::block_hash>>>, unsigned = broadcast_interval_ms, bool = false);
 	void broadcast_confirm_req_batch (std::deque<std::pair<std::shared_ptr<cga::block>, std::shared_ptr<std::vector<cga::peer_information>>>>, unsigned = broadcast_interval_ms);
 	void send_confirm_req (cga::endpoint const &, std::shared_ptr<cga::block>);
+	void send_confirm_req (cga::endpoint const &, std::shared_ptr<cga::wire_message const> const &);
 	void send_confirm_req_hashes (cga::endpoint const &, std::vector<std::pair<cga::block_hash, cga::block_hash>> const &);
 	void confirm_hashes (cga::transaction const &, cga::endpoint const &, std::vector<cga::block_hash>);
 	bool send_votes_cache (cga::block_hash const &, cga::endpoint const &);
@@ -354,6 +420,17 @@ public:
 	cga::udp_buffer buffer_container;
 	boost::asio::ip::udp::socket socket;
 	std::mutex socket_mutex;
+	class send_request
+	{
+	public:
+		uint8_t const * data;
+		size_t size;
+		cga::endpoint endpoint;
+		std::function<void(boost::system::error_code const &, size_t)> callback;
+	};
+	// Sends issued during one io_context turn, flushed together so a fanout costs one syscall per burst
+	std::vector<send_request> send_queue;
+	bool send_flush_scheduled;
 	boost::asio::ip::udp::resolver resolver;
 	std::vector<boost::thread> packet_processing_threads;
 	cga::node & node;
@@ -361,6 +438,13 @@ public:
 	static uint16_t const node_port = cga::is_live_network ? 7032 : 54000;
 	static size_t const buffer_size = 512;
 	static size_t const confirm_req_hashes_max = 6;
+	static size_t constexpr max_burst = 64;
+
+private:
+	boost::system::error_code receive_batch ();
+	void flush_sends ();
+	void send_async (cga::network::send_request const &);
+	void send_complete (boost::system::error_code const &, size_t, std::function<void(boost::system::error_code const &, size_t)> const &);
 };
 
 class node_init
@@ -390,27 +474,45 @@ class vote_processor
 public:
 	vote_processor (cga::node &);
 	void vote (std::shared_ptr<cga::vote>, cga::endpoint);
-	// node.active.mutex lock required
 	cga::vote_code vote_blocking (cga::transaction const &, std::shared_ptr<cga::vote>, cga::endpoint, bool = false);
 	void verify_votes (std::deque<std::pair<std::shared_ptr<cga::vote>, cga::endpoint>> &);
 	void flush ();
 	void calculate_weights ();
+	// Number of votes queued across all shards
+	size_t size ();
 	cga::node & node;
 	void stop ();
 
 private:
-	void process_loop ();
-	std::deque<std::pair<std::shared_ptr<cga::vote>, cga::endpoint>> votes;
+	/**
+	 * Votes are partitioned by representative account so each representative's votes are processed in order by a single thread
+	 */
+	class shard
+	{
+	public:
+		std::deque<std::pair<std::shared_ptr<cga::vote>, cga::endpoint>> votes;
+		std::condition_variable condition;
+		std::mutex mutex;
+		bool active{ false };
+		// Number of votes dropped by random early detection
+		uint64_t overflow{ 0 };
+		boost::thread thread;
+	};
+	void process_loop (cga::vote_processor::shard &);
+	cga::vote_processor::shard & shard_for (cga::account const &);
+	std::vector<std::unique_ptr<cga::vote_processor::shard>> shards;
 	// Representatives levels for random early detection
 	std::unordered_set<cga::account> representatives_1;
 	std::unordered_set<cga::account> representatives_2;
 	std::unordered_set<cga::account> representatives_3;
-	std::condition_variable condition;
+	// Protects representatives levels
 	std::mutex mutex;
-	bool started;
-	bool stopped;
-	bool active;
-	boost::thread thread;
+	std::atomic<bool> stopped;
+	// Random early detection thresholds for the combined queue size
+	static size_t constexpr max_votes_level_0 = 96 * 1024;
+	static size_t constexpr max_votes_level_1 = 112 * 1024;
+	static size_t constexpr max_votes_level_2 = 128 * 1024;
+	static size_t constexpr max_votes_level_3 = 144 * 1024;
 
 	friend std::unique_ptr<seq_con_info_component> collect_seq_con_info (vote_processor & vote_processor, const std::string & name);
 };
@@ -468,6 +570,9 @@ public:
 	void ongoing_store_flush ();
 	void ongoing_peer_store ();
 	void ongoing_unchecked_cleanup ();
+	void ongoing_ledger_pruning ();
+	// Queues one batch of pruning, the callback is called with whether the pass over all accounts completed once it's written
+	void ledger_pruning (std::function<void(bool)> const &);
 	void backup_wallet ();
 	void search_pending ();
 	void bootstrap_wallet ();
@@ -494,6 +599,7 @@ public:
 	cga::block_store & store;
 	std::unique_ptr<cga::wallets_store> wallets_store_impl;
 	cga::wallets_store & wallets_store;
+	cga::block_tracer tracer;
 	cga::gap_cache gap_cache;
 	cga::ledger ledger;
 	cga::active_transactions active;
@@ -518,6 +624,11 @@ public:
 	cga::keypair node_id;
 	cga::block_uniquer block_uniquer;
 	cga::vote_uniquer vote_uniquer;
+	cga::confirmation_height_processor confirmation_height_processor;
+	cga::metrics_server metrics;
+	// Next account to look at and the height each account was last pruned to, only used from ongoing_ledger_pruning
+	cga::account pruning_cursor{ 0 };
+	std::unordered_map<cga::account, uint64_t> pruned_heights;
 	const std::chrono::steady_clock::time_point startup_time;
 	static double constexpr price_max = 16.0;
 	static double constexpr free_cutoff = 1024.0;
@@ -528,6 +639,8 @@ public:
 	static std::chrono::seconds constexpr search_pending_interval = cga::is_test_network ? std::chrono::seconds (1) : std::chrono::seconds (5 * 60);
 	static std::chrono::seconds constexpr peer_interval = search_pending_interval;
 	static std::chrono::hours constexpr unchecked_cleanup_interval = std::chrono::hours (1);
+	static std::chrono::seconds constexpr pruning_interval = cga::is_test_network ? std::chrono::seconds (1) : std::chrono::seconds (5 * 60);
+	static size_t constexpr pruning_batch_size = 16 * 1024;
 	static std::chrono::milliseconds constexpr process_confirmed_interval = cga::is_test_network ? std::chrono::milliseconds (50) : std::chrono::milliseconds (500);
 };
 
@@ -30,6 +30,7 @@ io_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 network_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 work_threads (std::max<unsigned> (4, boost::thread::hardware_concurrency ())),
 signature_checker_threads ((boost::thread::hardware_concurrency () != 0) ? boost::thread::hardware_concurrency () - 1 : 0), /* The calling thread does checks as well so remove it from the number of threads used */
+vote_processor_threads (std::max<unsigned> (1, boost::thread::hardware_concurrency () / 4)),
 enable_voting (false),
 bootstrap_connections (4),
 bootstrap_connections_max (64),
@@ -37,7 +38,12 @@ callback_port (0),
 lmdb_max_dbs (128),
 allow_local_peers (false),
 block_processor_batch_max_time (std::chrono::milliseconds (5000)),
-unchecked_cutoff_time (std::chrono::seconds (4 * 60 * 60)) // 4 hours
+unchecked_cutoff_time (std::chrono::seconds (4 * 60 * 60)), // 4 hours
+write_queue_max_latency (std::chrono::milliseconds (10)),
+write_queue_max_ops (1024),
+enable_pruning (false),
+pruning_depth (4096),
+block_trace_interval (0)
 {
 	const char * epoch_message ("epoch v1 block");
 	strncpy ((char *)epoch_block_link.bytes.data (), epoch_message, epoch_block_link.bytes.size ());
@@ -109,6 +115,7 @@ cga::error cga::node_config::serialize_json (cga::jsonconfig & json) const
 	json.put ("network_threads", network_threads);
 	json.put ("work_threads", work_threads);
 	json.put (signature_checker_threads_key, signature_checker_threads);
+	json.put ("vote_processor_threads", vote_processor_threads);
 	json.put ("enable_voting", enable_voting);
 	json.put ("bootstrap_connections", bootstrap_connections);
 	json.put ("bootstrap_connections_max", bootstrap_connections_max);
@@ -120,11 +127,20 @@ cga::error cga::node_config::serialize_json (cga::jsonconfig & json) const
 	json.put ("allow_local_peers", allow_local_peers);
 	json.put ("vote_minimum", vote_minimum.to_string_dec ());
 	json.put ("unchecked_cutoff_time", unchecked_cutoff_time.count ());
+	json.put ("write_queue_max_latency", write_queue_max_latency.count ());
+	json.put ("write_queue_max_ops", write_queue_max_ops);
+	json.put ("enable_pruning", enable_pruning);
+	json.put ("pruning_depth", pruning_depth);
+	json.put ("block_trace_interval", block_trace_interval);
 
 	cga::jsonconfig ipc_l;
 	ipc_config.serialize_json (ipc_l);
 	json.put_child ("ipc", ipc_l);
 
+	cga::jsonconfig metrics_l;
+	metrics_config.serialize_json (metrics_l);
+	json.put_child ("metrics", metrics_l);
+
 	return json.get_error ();
 }
 
@@ -244,6 +260,19 @@ bool cga::node_config::upgrade_json (unsigned version_a, cga::jsonconfig & json)
 			upgraded = true;
 		}
 		case 16:
+			json.put ("vote_processor_threads", vote_processor_threads);
+			json.put ("write_queue_max_latency", write_queue_max_latency.count ());
+			json.put ("write_queue_max_ops", write_queue_max_ops);
+			json.put ("enable_pruning", enable_pruning);
+			json.put ("pruning_depth", pruning_depth);
+			json.put ("block_trace_interval", block_trace_interval);
+			{
+				cga::jsonconfig metrics_l;
+				metrics_config.serialize_json (metrics_l);
+				json.put_child ("metrics", metrics_l);
+			}
+			upgraded = true;
+		case 17:
 			break;
 		default:
 			throw std::runtime_error ("Unknown node_config version");
@@ -342,6 +371,9 @@ cga::error cga::node_config::deserialize_json (bool & upgraded_a, cga::jsonconfi
 		unsigned long unchecked_cutoff_time_l (unchecked_cutoff_time.count ());
 		json.get ("unchecked_cutoff_time", unchecked_cutoff_time_l);
 		unchecked_cutoff_time = std::chrono::seconds (unchecked_cutoff_time_l);
+		unsigned long write_queue_max_latency_l (write_queue_max_latency.count ());
+		json.get ("write_queue_max_latency", write_queue_max_latency_l);
+		write_queue_max_latency = std::chrono::milliseconds (write_queue_max_latency_l);
 
 		auto ipc_config_l (json.get_optional_child ("ipc"));
 		if (ipc_config_l)
@@ -349,6 +381,12 @@ cga::error cga::node_config::deserialize_json (bool & upgraded_a, cga::jsonconfi
 			ipc_config.deserialize_json (ipc_config_l.get ());
 		}
 
+		auto metrics_config_l (json.get_optional_child ("metrics"));
+		if (metrics_config_l)
+		{
+			metrics_config.deserialize_json (metrics_config_l.get ());
+		}
+
 		json.get<uint16_t> ("peering_port", peering_port);
 		json.get<unsigned> ("bootstrap_fraction_numerator", bootstrap_fraction_numerator);
 		json.get<unsigned> ("online_weight_quorum", online_weight_quorum);
@@ -365,6 +403,11 @@ cga::error cga::node_config::deserialize_json (bool & upgraded_a, cga::jsonconfi
 		json.get<bool> ("enable_voting", enable_voting);
 		json.get<bool> ("allow_local_peers", allow_local_peers);
 		json.get<unsigned> (signature_checker_threads_key, signature_checker_threads);
+		json.get<unsigned> ("vote_processor_threads", vote_processor_threads);
+		json.get<size_t> ("write_queue_max_ops", write_queue_max_ops);
+		json.get<bool> ("enable_pruning", enable_pruning);
+		json.get<uint64_t> ("pruning_depth", pruning_depth);
+		json.get<uint64_t> ("block_trace_interval", block_trace_interval);
 
 		// Validate ranges
 
@@ -380,6 +423,18 @@ cga::error cga::node_config::deserialize_json (bool & upgraded_a, cga::jsonconfi
 		{
 			json.get_error ().set ("io_threads must be non-zero");
 		}
+		if (vote_processor_threads == 0)
+		{
+			json.get_error ().set ("vote_processor_threads must be non-zero");
+		}
+		if (write_queue_max_ops == 0)
+		{
+			json.get_error ().set ("write_queue_max_ops must be non-zero");
+		}
+		if (pruning_depth == 0)
+		{
+			json.get_error ().set ("pruning_depth must be non-zero");
+		}
 	}
 	catch (std::runtime_error const & ex)
 	{
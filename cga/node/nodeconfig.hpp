@@ -6,6 +6,7 @@
 #include <cga/lib/numbers.hpp>
 #include <cga/node/ipc.hpp>
 #include <cga/node/logging.hpp>
+#include <cga/node/metrics.hpp>
 #include <cga/node/stats.hpp>
 #include <vector>
 
@@ -38,6 +39,7 @@ public:
 	unsigned network_threads;
 	unsigned work_threads;
 	unsigned signature_checker_threads;
+	unsigned vote_processor_threads;
 	bool enable_voting;
 	unsigned bootstrap_connections;
 	unsigned bootstrap_connections_max;
@@ -48,16 +50,24 @@ public:
 	bool allow_local_peers;
 	cga::stat_config stat_config;
 	cga::ipc::ipc_config ipc_config;
+	cga::metrics_config metrics_config;
 	cga::uint256_union epoch_block_link;
 	cga::account epoch_block_signer;
 	std::chrono::milliseconds block_processor_batch_max_time;
 	std::chrono::seconds unchecked_cutoff_time;
+	std::chrono::milliseconds write_queue_max_latency;
+	size_t write_queue_max_ops;
+	/** Drop bodies of cemented blocks more than pruning_depth blocks behind their account frontier */
+	bool enable_pruning;
+	uint64_t pruning_depth;
+	/** Trace the lifecycle of one in this many blocks, 0 disables tracing */
+	uint64_t block_trace_interval;
 	static std::chrono::seconds constexpr keepalive_period = std::chrono::seconds (60);
 	static std::chrono::seconds constexpr keepalive_cutoff = keepalive_period * 5;
 	static std::chrono::minutes constexpr wallet_backup_interval = std::chrono::minutes (5);
 	static int json_version ()
 	{
-		return 16;
+		return 17;
 	}
 };
 
@@ -9,6 +9,8 @@
 
 #include <cga/lib/errors.hpp>
 
+#include <fstream>
+
 namespace
 {
 void construct_json (cga::seq_con_info_component * component, boost::property_tree::ptree & parent);
@@ -538,6 +540,7 @@ void cga::rpc_handler::account_info ()
 			response_l.put ("balance", balance);
 			response_l.put ("modified_timestamp", std::to_string (info.modified));
 			response_l.put ("block_count", std::to_string (info.block_count));
+			response_l.put ("confirmation_height", std::to_string (info.confirmation_height));
 			response_l.put ("account_version", info.epoch == cga::epoch::epoch_1 ? "1" : "0");
 			if (representative)
 			{
@@ -1054,6 +1057,7 @@ void cga::rpc_handler::block_count ()
 	auto transaction (node.store.tx_begin_read ());
 	response_l.put ("count", std::to_string (node.store.block_count (transaction).sum ()));
 	response_l.put ("unchecked", std::to_string (node.store.unchecked_count (transaction)));
+	response_l.put ("pruned", std::to_string (node.store.pruned_count (transaction)));
 	response_errors ();
 }
 
@@ -1350,6 +1354,36 @@ void cga::rpc_handler::block_hash ()
 	response_errors ();
 }
 
+void cga::rpc_handler::block_trace ()
+{
+	rpc_control_impl ();
+	if (!ec)
+	{
+		if (node.tracer.enabled ())
+		{
+			// Written to a file rather than the response so it loads straight into chrome://tracing
+			auto path (node.application_path / "block_trace.json");
+			std::ofstream stream (path.string (), std::ofstream::out | std::ofstream::trunc);
+			auto blocks (node.tracer.dump (stream));
+			stream.close ();
+			if (!stream.fail ())
+			{
+				response_l.put ("path", path.string ());
+				response_l.put ("blocks", std::to_string (blocks));
+			}
+			else
+			{
+				ec = cga::error_common::generic;
+			}
+		}
+		else
+		{
+			ec = cga::error_rpc::block_trace_disabled;
+		}
+	}
+	response_errors ();
+}
+
 void cga::rpc_handler::bootstrap ()
 {
 	std::string address_text = request.get<std::string> ("address");
@@ -1456,8 +1490,8 @@ void cga::rpc_handler::chain (bool successors)
 		auto transaction (node.store.tx_begin_read ());
 		while (!hash.is_zero () && blocks.size () < count)
 		{
-			auto block_l (node.store.block_get (transaction, hash));
-			if (block_l != nullptr)
+			cga::block_view block_l;
+			if (!node.store.block_view_get (transaction, hash, block_l))
 			{
 				if (offset > 0)
 				{
@@ -1469,7 +1503,7 @@ void cga::rpc_handler::chain (bool successors)
 					entry.put ("", hash.to_string ());
 					blocks.push_back (std::make_pair ("", entry));
 				}
-				hash = successors ? node.store.block_successor (transaction, hash) : block_l->previous ();
+				hash = successors ? block_l.sideband ().successor : block_l.previous ();
 			}
 			else
 			{
@@ -1490,9 +1524,10 @@ void cga::rpc_handler::confirmation_active ()
 		announcements = strtoul (announcements_text.get ().c_str (), NULL, 10);
 	}
 	boost::property_tree::ptree elections;
+	for (auto & partition : node.active.partitions)
 	{
-		std::lock_guard<std::mutex> lock (node.active.mutex);
-		for (auto i (node.active.roots.begin ()), n (node.active.roots.end ()); i != n; ++i)
+		std::lock_guard<std::mutex> lock (partition->mutex);
+		for (auto i (partition->roots.begin ()), n (partition->roots.end ()); i != n; ++i)
 		{
 			if (i->election->announcements >= announcements && !i->election->confirmed && !i->election->stopped)
 			{
@@ -1552,9 +1587,10 @@ void cga::rpc_handler::confirmation_info ()
 	cga::uint512_union root;
 	if (!root.decode_hex (root_text))
 	{
-		std::lock_guard<std::mutex> lock (node.active.mutex);
-		auto conflict_info (node.active.roots.find (root));
-		if (conflict_info != node.active.roots.end ())
+		auto & partition (node.active.partition_for (root));
+		std::lock_guard<std::mutex> lock (partition.mutex);
+		auto conflict_info (partition.roots.find (root));
+		if (conflict_info != partition.roots.end ())
 		{
 			response_l.put ("announcements", std::to_string (conflict_info->election->announcements));
 			auto election (conflict_info->election);
@@ -1583,7 +1619,7 @@ void cga::rpc_handler::confirmation_info ()
 						if (i->second->hash () == ii->second.hash)
 						{
 							cga::account representative (ii->first);
-							auto amount (node.store.representation_get (transaction, representative));
+							auto amount (node.ledger.weight (representative));
 							representatives.insert (std::make_pair (amount, representative));
 						}
 					}
@@ -1637,23 +1673,34 @@ void cga::rpc_handler::confirmation_quorum ()
 void cga::rpc_handler::delegators ()
 {
 	auto account (account_impl ());
+	auto count (count_optional_impl ());
 	if (!ec)
 	{
-		boost::property_tree::ptree delegators;
-		auto transaction (node.store.tx_begin_read ());
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		cga::account start (0);
+		boost::optional<std::string> start_text (request.get_optional<std::string> ("start"));
+		if (start_text.is_initialized ())
 		{
-			cga::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
+			if (start.decode_account (start_text.get ()))
 			{
+				ec = cga::error_common::bad_account_number;
+			}
+		}
+		if (!ec)
+		{
+			boost::property_tree::ptree delegators;
+			auto transaction (node.store.tx_begin_read ());
+			for (auto i (node.store.delegators_begin (transaction, cga::delegator_key (account, start))), n (node.store.delegators_end ()); i != n && cga::delegator_key (i->first).representative == account && delegators.size () < count; ++i)
+			{
+				cga::account delegator (cga::delegator_key (i->first).account);
+				cga::account_info info;
+				auto error (node.store.account_get (transaction, delegator, info));
+				assert (!error);
 				std::string balance;
 				cga::uint128_union (info.balance).encode_dec (balance);
-				delegators.put (cga::account (i->first).to_account (), balance);
+				delegators.put (delegator.to_account (), balance);
 			}
+			response_l.add_child ("delegators", delegators);
 		}
-		response_l.add_child ("delegators", delegators);
 	}
 	response_errors ();
 }
@@ -1665,15 +1712,9 @@ void cga::rpc_handler::delegators_count ()
 	{
 		uint64_t count (0);
 		auto transaction (node.store.tx_begin_read ());
-		for (auto i (node.store.latest_begin (transaction)), n (node.store.latest_end ()); i != n; ++i)
+		for (auto i (node.store.delegators_begin (transaction, cga::delegator_key (account, 0))), n (node.store.delegators_end ()); i != n && cga::delegator_key (i->first).representative == account; ++i)
 		{
-			cga::account_info info (i->second);
-			auto block (node.store.block_get (transaction, info.rep_block));
-			assert (block != nullptr);
-			if (block->representative () == account)
-			{
-				++count;
-			}
+			++count;
 		}
 		response_l.put ("count", std::to_string (count));
 	}
@@ -1913,9 +1954,10 @@ void cga::rpc_handler::account_history ()
 	{
 		boost::property_tree::ptree history;
 		response_l.put ("account", account.to_account ());
-		cga::block_sideband sideband;
-		auto block (node.store.block_get (transaction, hash, &sideband));
-		while (block != nullptr && count > 0)
+		// Skipped blocks are only walked through, the full block is read for those which are output
+		cga::block_view view;
+		auto not_found (node.store.block_view_get (transaction, hash, view));
+		while (!not_found && count > 0)
 		{
 			if (offset > 0)
 			{
@@ -1923,12 +1965,13 @@ void cga::rpc_handler::account_history ()
 			}
 			else
 			{
+				auto block (view.block ());
 				boost::property_tree::ptree entry;
 				history_visitor visitor (*this, output_raw, transaction, entry, hash);
 				block->visit (visitor);
 				if (!entry.empty ())
 				{
-					entry.put ("local_timestamp", std::to_string (sideband.timestamp));
+					entry.put ("local_timestamp", std::to_string (view.sideband ().timestamp));
 					entry.put ("hash", hash.to_string ());
 					if (output_raw)
 					{
@@ -1939,8 +1982,8 @@ void cga::rpc_handler::account_history ()
 					--count;
 				}
 			}
-			hash = block->previous ();
-			block = node.store.block_get (transaction, hash, &sideband);
+			hash = view.previous ();
+			not_found = node.store.block_view_get (transaction, hash, view);
 		}
 		response_l.add_child ("history", history);
 		if (!hash.is_zero ())
@@ -2558,12 +2601,14 @@ void cga::rpc_handler::process ()
 			auto hash (block->hash ());
 			node.block_arrival.add (hash);
 			cga::process_return result;
+			std::deque<cga::post_commit_info> post_commit;
 			{
 				auto transaction (node.store.tx_begin_write ());
 				// Set current time to trigger automatic rebroadcast and election
 				cga::unchecked_info info (block, block->account (), cga::seconds_since_epoch (), cga::signature_verification::unknown);
-				result = node.block_processor.process_one (transaction, info);
+				result = node.block_processor.process_one (transaction, info, post_commit);
 			}
+			node.block_processor.enqueue_post_commit (post_commit);
 			switch (result.code)
 			{
 				case cga::process_result::progress:
@@ -2745,24 +2790,33 @@ void cga::rpc_handler::representatives ()
 	{
 		const bool sorting = request.get<bool> ("sorting", false);
 		boost::property_tree::ptree representatives;
-		auto transaction (node.store.tx_begin_read ());
+		auto rep_amounts (node.ledger.rep_weights.snapshot ());
 		if (!sorting) // Simple
 		{
-			for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n && representatives.size () < count; ++i)
+			// Keep the account ordering of the representation table
+			std::vector<std::pair<cga::account, cga::uint128_t>> representation;
+			for (auto & shard : *rep_amounts)
 			{
-				cga::account account (i->first);
-				auto amount (node.store.representation_get (transaction, account));
-				representatives.put (account.to_account (), amount.convert_to<std::string> ());
+				representation.insert (representation.end (), shard->begin (), shard->end ());
+			}
+			auto limit (std::min<size_t> (count, representation.size ()));
+			std::partial_sort (representation.begin (), representation.begin () + limit, representation.end (), [](std::pair<cga::account, cga::uint128_t> const & lhs, std::pair<cga::account, cga::uint128_t> const & rhs) {
+				return lhs.first < rhs.first;
+			});
+			for (auto i (representation.begin ()), n (representation.begin () + limit); i != n; ++i)
+			{
+				representatives.put (i->first.to_account (), i->second.convert_to<std::string> ());
 			}
 		}
 		else // Sorting
 		{
 			std::vector<std::pair<cga::uint128_union, std::string>> representation;
-			for (auto i (node.store.representation_begin (transaction)), n (node.store.representation_end ()); i != n; ++i)
+			for (auto & shard : *rep_amounts)
 			{
-				cga::account account (i->first);
-				auto amount (node.store.representation_get (transaction, account));
-				representation.push_back (std::make_pair (amount, account.to_account ()));
+				for (auto & i : *shard)
+				{
+					representation.push_back (std::make_pair (cga::uint128_union (i.second), i.first.to_account ()));
+				}
 			}
 			std::sort (representation.begin (), representation.end ());
 			std::reverse (representation.begin (), representation.end ());
@@ -3185,6 +3239,11 @@ void cga::rpc_handler::stats ()
 		node.stats.log_samples (*sink);
 		use_sink = true;
 	}
+	else if (type == "histograms")
+	{
+		node.stats.log_histograms (*sink);
+		use_sink = true;
+	}
 	else
 	{
 		ec = cga::error_rpc::invalid_missing_type;
@@ -4156,7 +4215,11 @@ void cga::rpc_connection::read ()
 					ostream.flush ();
 					auto body (ostream.str ());
 					this_l->write_result (body, version);
-					boost::beast::http::async_write (this_l->socket, this_l->res, [this_l](boost::system::error_code const & ec, size_t bytes_transferred) {
+					boost::beast::http::async_write (this_l->socket, this_l->res, [this_l, start](boost::system::error_code const & ec, size_t bytes_transferred) {
+						if (!ec)
+						{
+							this_l->node->stats.record (cga::stat::histogram::rpc_request, std::chrono::steady_clock::now () - start);
+						}
 					});
 
 					if (this_l->node->config.logging.log_rpc ())
@@ -4382,6 +4445,10 @@ void cga::rpc_handler::process_request ()
 			{
 				block_hash ();
 			}
+			else if (action == "block_trace")
+			{
+				block_trace ();
+			}
 			else if (action == "successors")
 			{
 				chain (true);
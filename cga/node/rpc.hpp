@@ -156,6 +156,7 @@ public:
 	void block_count_type ();
 	void block_create ();
 	void block_hash ();
+	void block_trace ();
 	void bootstrap ();
 	void bootstrap_any ();
 	void bootstrap_lazy ();
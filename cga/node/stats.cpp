@@ -2,7 +2,10 @@
 
 #include <boost/asio.hpp>
 #include <boost/format.hpp>
+#include <boost/multiprecision/integer.hpp>
 #include <boost/property_tree/json_parser.hpp>
+#include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <fstream>
 #include <iostream>
@@ -25,20 +28,130 @@ cga::error cga::stat_config::deserialize_json (cga::jsonconfig & json)
 		log_l->get<bool> ("headers", log_headers);
 		log_l->get<size_t> ("interval_counters", log_interval_counters);
 		log_l->get<size_t> ("interval_samples", log_interval_samples);
+		log_l->get<size_t> ("interval_histograms", log_interval_histograms);
 		log_l->get<size_t> ("rotation_count", log_rotation_count);
 		log_l->get<std::string> ("filename_counters", log_counters_filename);
 		log_l->get<std::string> ("filename_samples", log_samples_filename);
+		log_l->get<std::string> ("filename_histograms", log_histograms_filename);
 
 		// Don't allow specifying the same file name for counter and samples logs
 		if (log_counters_filename == log_samples_filename)
 		{
 			json.get_error ().set ("The statistics counter and samples config values must be different");
 		}
+		else if (log_histograms_filename == log_counters_filename || log_histograms_filename == log_samples_filename)
+		{
+			json.get_error ().set ("The statistics histograms config value must be different from the counter and samples ones");
+		}
 	}
 
 	return json.get_error ();
 }
 
+size_t constexpr cga::stat_histogram::sub_bucket_bits;
+size_t constexpr cga::stat_histogram::sub_bucket_count;
+size_t constexpr cga::stat_histogram::max_bits;
+size_t constexpr cga::stat_histogram::bucket_count;
+
+cga::stat_histogram::stat_histogram ()
+{
+	clear ();
+}
+
+void cga::stat_histogram::record (uint64_t value_a)
+{
+	value_a = std::min<uint64_t> (value_a, (uint64_t (1) << max_bits) - 1);
+	buckets[bucket_index (value_a)].fetch_add (1, std::memory_order_relaxed);
+	total_count.fetch_add (1, std::memory_order_relaxed);
+	total_sum.fetch_add (value_a, std::memory_order_relaxed);
+	auto maximum_l (maximum.load (std::memory_order_relaxed));
+	while (value_a > maximum_l && !maximum.compare_exchange_weak (maximum_l, value_a, std::memory_order_relaxed))
+	{
+	}
+}
+
+void cga::stat_histogram::clear ()
+{
+	for (auto & bucket : buckets)
+	{
+		bucket.store (0, std::memory_order_relaxed);
+	}
+	total_count.store (0, std::memory_order_relaxed);
+	total_sum.store (0, std::memory_order_relaxed);
+	maximum.store (0, std::memory_order_relaxed);
+}
+
+uint64_t cga::stat_histogram::count () const
+{
+	return total_count.load (std::memory_order_relaxed);
+}
+
+uint64_t cga::stat_histogram::sum () const
+{
+	return total_sum.load (std::memory_order_relaxed);
+}
+
+uint64_t cga::stat_histogram::max () const
+{
+	return maximum.load (std::memory_order_relaxed);
+}
+
+uint64_t cga::stat_histogram::quantile (double quantile_a) const
+{
+	std::array<uint64_t, bucket_count> snapshot;
+	uint64_t total (0);
+	for (size_t i (0); i < bucket_count; ++i)
+	{
+		snapshot[i] = buckets[i].load (std::memory_order_relaxed);
+		total += snapshot[i];
+	}
+	uint64_t result (0);
+	if (total > 0)
+	{
+		auto rank (std::max<uint64_t> (1, static_cast<uint64_t> (std::ceil (quantile_a * total))));
+		uint64_t seen (0);
+		size_t i (0);
+		for (; i < bucket_count - 1 && seen + snapshot[i] < rank; ++i)
+		{
+			seen += snapshot[i];
+		}
+		// The bucket's upper edge overstates the largest values, which are tracked exactly
+		result = std::min (bucket_max (i), max ());
+	}
+	return result;
+}
+
+size_t cga::stat_histogram::bucket_index (uint64_t value_a)
+{
+	size_t result;
+	if (value_a < sub_bucket_count)
+	{
+		result = static_cast<size_t> (value_a);
+	}
+	else
+	{
+		size_t msb (boost::multiprecision::msb (value_a));
+		auto shift (msb - sub_bucket_bits);
+		result = (shift + 1) * sub_bucket_count + static_cast<size_t> ((value_a >> shift) - sub_bucket_count);
+	}
+	return result;
+}
+
+uint64_t cga::stat_histogram::bucket_max (size_t index_a)
+{
+	uint64_t result;
+	if (index_a < sub_bucket_count)
+	{
+		result = index_a;
+	}
+	else
+	{
+		auto shift (index_a / sub_bucket_count - 1);
+		result = ((uint64_t (sub_bucket_count + index_a % sub_bucket_count) + 1) << shift) - 1;
+	}
+	return result;
+}
+
 std::string cga::stat_log_sink::tm_to_string (tm & tm)
 {
 	return (boost::format ("%04d.%02d.%02d %02d:%02d:%02d") % (1900 + tm.tm_year) % (tm.tm_mon + 1) % tm.tm_mday % tm.tm_hour % tm.tm_min % tm.tm_sec).str ();
@@ -80,6 +193,22 @@ public:
 		entries.push_back (std::make_pair ("", entry));
 	}
 
+	void write_histogram (tm & tm, std::string name, cga::stat_histogram const & histogram) override
+	{
+		boost::property_tree::ptree entry;
+		entry.put ("time", boost::format ("%02d:%02d:%02d") % tm.tm_hour % tm.tm_min % tm.tm_sec);
+		entry.put ("name", name);
+		auto count (histogram.count ());
+		entry.put ("count", count);
+		entry.put ("mean", count > 0 ? histogram.sum () / count : 0);
+		entry.put ("p50", histogram.quantile (0.5));
+		entry.put ("p90", histogram.quantile (0.9));
+		entry.put ("p99", histogram.quantile (0.99));
+		entry.put ("p999", histogram.quantile (0.999));
+		entry.put ("max", histogram.max ());
+		entries.push_back (std::make_pair ("", entry));
+	}
+
 	void finalize () override
 	{
 		tree.add_child ("entries", entries);
@@ -133,6 +262,12 @@ public:
 		log << boost::format ("%02d:%02d:%02d") % tm.tm_hour % tm.tm_min % tm.tm_sec << "," << type << "," << detail << "," << dir << "," << value << std::endl;
 	}
 
+	void write_histogram (tm & tm, std::string name, cga::stat_histogram const & histogram) override
+	{
+		auto count (histogram.count ());
+		log << boost::format ("%02d:%02d:%02d") % tm.tm_hour % tm.tm_min % tm.tm_sec << "," << name << "," << count << "," << (count > 0 ? histogram.sum () / count : 0) << "," << histogram.quantile (0.5) << "," << histogram.quantile (0.9) << "," << histogram.quantile (0.99) << "," << histogram.quantile (0.999) << "," << histogram.max () << std::endl;
+	}
+
 	void rotate () override
 	{
 		log.close ();
@@ -141,9 +276,80 @@ public:
 	}
 };
 
+size_t constexpr cga::stat::counter_count;
+
+namespace
+{
+std::atomic<size_t> stat_thread_count{ 0 };
+thread_local size_t const stat_thread_index (stat_thread_count++);
+
+size_t stat_shard_count ()
+{
+	return std::max<size_t> (1, std::min<size_t> (std::thread::hardware_concurrency (), 32));
+}
+
+size_t constexpr stat_cache_line_counters = 64 / sizeof (std::atomic<uint64_t>);
+
+// Rounded up to whole cache lines, plus one line of padding
+size_t constexpr stat_shard_stride = (cga::stat::counter_count + stat_cache_line_counters - 1) / stat_cache_line_counters * stat_cache_line_counters + stat_cache_line_counters;
+}
+
+cga::stat::stat () :
+counters (stat_shard_count () * stat_shard_stride),
+shard_count (stat_shard_count ()),
+shard_stride (stat_shard_stride)
+{
+}
+
 cga::stat::stat (cga::stat_config config) :
-config (config)
+config (config),
+counters (stat_shard_count () * stat_shard_stride),
+shard_count (stat_shard_count ()),
+shard_stride (stat_shard_stride),
+aggregator ([this]() { run (); })
+{
+}
+
+cga::stat::~stat ()
+{
+	{
+		std::lock_guard<std::mutex> lock (stat_mutex);
+		stopped = true;
+	}
+	condition.notify_all ();
+	if (aggregator.joinable ())
+	{
+		aggregator.join ();
+	}
+}
+
+size_t cga::stat::shard_index () const
+{
+	return stat_thread_index % shard_count;
+}
+
+uint64_t cga::stat::counter_value (size_t index) const
+{
+	uint64_t result (0);
+	for (size_t i (0); i < shard_count; ++i)
+	{
+		result += counters[i * shard_stride + index].load (std::memory_order_relaxed);
+	}
+	return result;
+}
+
+std::vector<uint64_t> cga::stat::counter_values () const
 {
+	std::vector<uint64_t> result (counter_count, 0);
+	for (size_t i (0); i < shard_count; ++i)
+	{
+		auto shard (counters.data () + i * shard_stride);
+		for (size_t j (0); j < counter_count; ++j)
+		{
+			result[j] += shard[j].load (std::memory_order_relaxed);
+		}
+	}
+	return result;
 }
 
 std::shared_ptr<cga::stat_entry> cga::stat::get_entry (uint32_t key)
@@ -163,7 +369,7 @@ std::shared_ptr<cga::stat_entry> cga::stat::get_entry_impl (uint32_t key, size_t
 	auto entry = entries.find (key);
 	if (entry == entries.end ())
 	{
-		res = entries.insert (std::make_pair (key, std::make_shared<cga::stat_entry> (capacity, interval))).first->second;
+		res = entries.insert (std::make_pair (key, std::make_shared<cga::stat_entry> (capacity, interval, counter_value (index_of (key))))).first->second;
 	}
 	else
 	{
@@ -186,10 +392,10 @@ std::unique_ptr<cga::stat_log_sink> log_sink_file (std::string filename)
 void cga::stat::log_counters (stat_log_sink & sink)
 {
 	std::unique_lock<std::mutex> lock (stat_mutex);
-	log_counters_impl (sink);
+	log_counters_impl (sink, counter_values ());
 }
 
-void cga::stat::log_counters_impl (stat_log_sink & sink)
+void cga::stat::log_counters_impl (stat_log_sink & sink, std::vector<uint64_t> const & values)
 {
 	sink.begin ();
 	if (sink.entries () >= config.log_rotation_count)
@@ -203,16 +409,19 @@ void cga::stat::log_counters_impl (stat_log_sink & sink)
 		sink.write_header ("counters", walltime);
 	}
 
-	for (auto & it : entries)
+	// Update times aren't tracked by the counters, entries carry the time they were read
+	std::time_t time = std::chrono::system_clock::to_time_t (std::chrono::system_clock::now ());
+	tm local_tm = *localtime (&time);
+	for (size_t i (0); i < values.size (); ++i)
 	{
-		std::time_t time = std::chrono::system_clock::to_time_t (it.second->counter.get_timestamp ());
-		tm local_tm = *localtime (&time);
-
-		auto key = it.first;
-		std::string type = type_to_string (key);
-		std::string detail = detail_to_string (key);
-		std::string dir = dir_to_string (key);
-		sink.write_entry (local_tm, type, detail, dir, it.second->counter.get_value ());
+		if (values[i] != 0)
+		{
+			auto key = key_of (i);
+			std::string type = type_to_string (key);
+			std::string detail = detail_to_string (key);
+			std::string dir = dir_to_string (key);
+			sink.write_entry (local_tm, type, detail, dir, values[i]);
+		}
 	}
 	sink.entries ()++;
 	sink.finalize ();
@@ -256,58 +465,143 @@ void cga::stat::log_samples_impl (stat_log_sink & sink)
 	sink.finalize ();
 }
 
-void cga::stat::update (uint32_t key_a, uint64_t value)
+void cga::stat::log_histograms (stat_log_sink & sink)
 {
-	static file_writer log_count (config.log_counters_filename);
-	static file_writer log_sample (config.log_samples_filename);
-
-	auto now (std::chrono::steady_clock::now ());
-
 	std::unique_lock<std::mutex> lock (stat_mutex);
-	auto entry (get_entry_impl (key_a, config.interval, config.capacity));
+	log_histograms_impl (sink);
+}
 
-	// Counters
-	auto old (entry->counter.get_value ());
-	entry->counter.add (value);
-	entry->count_observers.notify (old, entry->counter.get_value ());
+void cga::stat::log_histograms_impl (stat_log_sink & sink)
+{
+	sink.begin ();
+	if (sink.entries () >= config.log_rotation_count)
+	{
+		sink.rotate ();
+	}
 
-	std::chrono::duration<double, std::milli> duration = now - log_last_count_writeout;
-	if (config.log_interval_counters > 0 && duration.count () > config.log_interval_counters)
+	if (config.log_headers)
 	{
-		log_counters_impl (log_count);
-		log_last_count_writeout = now;
+		auto walltime (std::chrono::system_clock::now ());
+		sink.write_header ("histograms", walltime);
 	}
 
-	// Samples
-	if (config.sampling_enabled && entry->sample_interval > 0)
+	std::time_t time = std::chrono::system_clock::to_time_t (std::chrono::system_clock::now ());
+	tm local_tm = *localtime (&time);
+	for (size_t i (0); i < histograms.size (); ++i)
 	{
-		entry->sample_current.add (value, false);
+		sink.write_histogram (local_tm, histogram_to_string (static_cast<stat::histogram> (i)), histograms[i]);
+	}
+	sink.entries ()++;
+	sink.finalize ();
+}
 
-		std::chrono::duration<double, std::milli> duration = now - entry->sample_start_time;
-		if (duration.count () > entry->sample_interval)
+void cga::stat::run ()
+{
+	cga::thread_role::set (cga::thread_role::name::stat_aggregation);
+	std::unique_ptr<stat_log_sink> log_count;
+	std::unique_ptr<stat_log_sink> log_sample;
+	if (config.log_interval_counters > 0)
+	{
+		log_count = std::make_unique<file_writer> (config.log_counters_filename);
+	}
+	if (config.sampling_enabled && config.log_interval_samples > 0)
+	{
+		log_sample = std::make_unique<file_writer> (config.log_samples_filename);
+	}
+	std::unique_ptr<stat_log_sink> log_histogram;
+	if (config.log_interval_histograms > 0)
+	{
+		log_histogram = std::make_unique<file_writer> (config.log_histograms_filename);
+	}
+	// Entries sampled at their own interval are only as precise as this
+	size_t tick (1000);
+	for (auto interval : { config.sampling_enabled ? config.interval : 0, config.log_interval_counters, config.log_interval_samples, config.log_interval_histograms })
+	{
+		if (interval > 0)
 		{
-			entry->sample_start_time = now;
+			tick = std::min (tick, interval);
+		}
+	}
+	std::unique_lock<std::mutex> lock (stat_mutex);
+	while (!stopped)
+	{
+		aggregate (log_count, log_sample, log_histogram);
+		condition.wait_for (lock, std::chrono::milliseconds (tick));
+	}
+}
 
-			// Make a snapshot of samples for thread safety and to get a stable container
-			entry->sample_current.set_timestamp (std::chrono::system_clock::now ());
-			entry->samples.push_back (entry->sample_current);
-			entry->sample_current.set_value (0);
+void cga::stat::aggregate (std::unique_ptr<stat_log_sink> & log_count, std::unique_ptr<stat_log_sink> & log_sample, std::unique_ptr<stat_log_sink> & log_histogram)
+{
+	auto now (std::chrono::steady_clock::now ());
+	auto values (counter_values ());
 
-			if (entry->sample_observers.observers.size () > 0)
+	// Every counter in use is sampled unless its entry was configured otherwise
+	if (config.sampling_enabled)
+	{
+		for (size_t i (0); i < values.size (); ++i)
+		{
+			if (values[i] != 0)
 			{
-				auto snapshot (entry->samples);
-				entry->sample_observers.notify (snapshot);
+				get_entry_impl (key_of (i), config.interval, config.capacity);
 			}
+		}
+	}
+
+	for (auto & it : entries)
+	{
+		auto & entry (*it.second);
+		auto value (values[index_of (it.first)]);
+
+		// Counters
+		if (value != entry.observed_value)
+		{
+			entry.count_observers.notify (entry.observed_value, value);
+			entry.observed_value = value;
+		}
 
-			// Log sink
-			duration = now - log_last_sample_writeout;
-			if (config.log_interval_samples > 0 && duration.count () > config.log_interval_samples)
+		// Samples
+		if (config.sampling_enabled && entry.sample_interval > 0)
+		{
+			std::chrono::duration<double, std::milli> duration = now - entry.sample_start_time;
+			if (duration.count () >= entry.sample_interval)
 			{
-				log_samples_impl (log_sample);
-				log_last_sample_writeout = now;
+				entry.sample_start_time = now;
+
+				// Make a snapshot of samples for thread safety and to get a stable container
+				stat_datapoint sample;
+				sample.set_value (value - entry.sample_start_value);
+				sample.set_timestamp (std::chrono::system_clock::now ());
+				entry.samples.push_back (sample);
+				entry.sample_start_value = value;
+
+				if (entry.sample_observers.observers.size () > 0)
+				{
+					auto snapshot (entry.samples);
+					entry.sample_observers.notify (snapshot);
+				}
 			}
 		}
 	}
+
+	// Log sinks
+	std::chrono::duration<double, std::milli> duration = now - log_last_count_writeout;
+	if (log_count != nullptr && duration.count () >= config.log_interval_counters)
+	{
+		log_counters_impl (*log_count, values);
+		log_last_count_writeout = now;
+	}
+	duration = now - log_last_sample_writeout;
+	if (log_sample != nullptr && duration.count () >= config.log_interval_samples)
+	{
+		log_samples_impl (*log_sample);
+		log_last_sample_writeout = now;
+	}
+	duration = now - log_last_histogram_writeout;
+	if (log_histogram != nullptr && duration.count () >= config.log_interval_histograms)
+	{
+		log_histograms_impl (*log_histogram);
+		log_last_histogram_writeout = now;
+	}
 }
 
 std::chrono::seconds cga::stat::last_reset ()
@@ -320,6 +614,14 @@ std::chrono::seconds cga::stat::last_reset ()
 void cga::stat::clear ()
 {
 	std::unique_lock<std::mutex> lock (stat_mutex);
+	for (auto & counter : counters)
+	{
+		counter.store (0, std::memory_order_relaxed);
+	}
+	for (auto & histogram : histograms)
+	{
+		histogram.clear ();
+	}
 	entries.clear ();
 	timestamp = std::chrono::steady_clock::now ();
 }
@@ -351,6 +653,18 @@ std::string cga::stat::type_to_string (uint32_t key)
 		case cga::stat::type::udp:
 			res = "udp";
 			break;
+		case cga::stat::type::block_processor:
+			res = "block_processor";
+			break;
+		case cga::stat::type::confirmation_height:
+			res = "confirmation_height";
+			break;
+		case cga::stat::type::block_filter:
+			res = "block_filter";
+			break;
+		case cga::stat::type::read_transaction:
+			res = "read_transaction";
+			break;
 		case cga::stat::type::peering:
 			res = "peering";
 			break;
@@ -369,6 +683,8 @@ std::string cga::stat::type_to_string (uint32_t key)
 		case cga::stat::type::message:
 			res = "message";
 			break;
+		case cga::stat::type::_last:
+			break;
 	}
 	return res;
 }
@@ -409,6 +725,9 @@ std::string cga::stat::detail_to_string (uint32_t key)
 		case cga::stat::detail::fork:
 			res = "fork";
 			break;
+		case cga::stat::detail::pruned:
+			res = "pruned";
+			break;
 		case cga::stat::detail::frontier_req:
 			res = "frontier_req";
 			break;
@@ -508,6 +827,47 @@ std::string cga::stat::detail_to_string (uint32_t key)
 		case cga::stat::detail::outdated_version:
 			res = "outdated_version";
 			break;
+		case cga::stat::detail::duplicate:
+			res = "duplicate";
+			break;
+		case cga::stat::detail::verified:
+			res = "verified";
+			break;
+		case cga::stat::detail::bad_signature:
+			res = "bad_signature";
+			break;
+		case cga::stat::detail::processed:
+			res = "processed";
+			break;
+		case cga::stat::detail::post_commit:
+			res = "post_commit";
+			break;
+		case cga::stat::detail::blocks_confirmed:
+			res = "blocks_confirmed";
+			break;
+		case cga::stat::detail::invalid_block:
+			res = "invalid_block";
+			break;
+		case cga::stat::detail::cemented:
+			res = "cemented";
+			break;
+		case cga::stat::detail::filter_negative:
+			res = "filter_negative";
+			break;
+		case cga::stat::detail::filter_positive:
+			res = "filter_positive";
+			break;
+		case cga::stat::detail::filter_false_positive:
+			res = "filter_false_positive";
+			break;
+		case cga::stat::detail::renewed:
+			res = "renewed";
+			break;
+		case cga::stat::detail::begun:
+			res = "begun";
+			break;
+		case cga::stat::detail::_last:
+			break;
 	}
 	return res;
 }
@@ -524,6 +884,34 @@ std::string cga::stat::dir_to_string (uint32_t key)
 		case cga::stat::dir::out:
 			res = "out";
 			break;
+		case cga::stat::dir::_last:
+			break;
+	}
+	return res;
+}
+
+std::string cga::stat::histogram_to_string (stat::histogram histogram)
+{
+	std::string res;
+	switch (histogram)
+	{
+		case cga::stat::histogram::block_processor_queue:
+			res = "block_processor_queue";
+			break;
+		case cga::stat::histogram::ledger_process:
+			res = "ledger_process";
+			break;
+		case cga::stat::histogram::election:
+			res = "election";
+			break;
+		case cga::stat::histogram::vote_verify:
+			res = "vote_verify";
+			break;
+		case cga::stat::histogram::rpc_request:
+			res = "rpc_request";
+			break;
+		case cga::stat::histogram::_last:
+			break;
 	}
 	return res;
 }
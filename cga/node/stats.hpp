@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <boost/circular_buffer.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <chrono>
+#include <condition_variable>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -11,7 +13,9 @@
 #include <cga/lib/jsonconfig.hpp>
 #include <cga/lib/utility.hpp>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace cga
 {
@@ -43,6 +47,9 @@ public:
 	/** How often to log counters, in milliseconds. Default is 0 (no logging) */
 	size_t log_interval_counters{ 0 };
 
+	/** How often to log histograms, in milliseconds. Default is 0 (no logging) */
+	size_t log_interval_histograms{ 0 };
+
 	/** Maximum number of log outputs before rotating the file */
 	size_t log_rotation_count{ 100 };
 
@@ -54,6 +61,9 @@ public:
 
 	/** Filename for the sampling log */
 	std::string log_samples_filename{ "samples.stat" };
+
+	/** Filename for the histogram log */
+	std::string log_histograms_filename{ "histograms.stat" };
 };
 
 /** Value and wall time of measurement */
@@ -114,12 +124,44 @@ private:
 	std::chrono::system_clock::time_point timestamp{ std::chrono::system_clock::now () };
 };
 
-/** Bookkeeping of statistics for a specific type/detail/direction combination */
+/**
+ * Log-linear histogram of durations in microseconds, in the style of HdrHistogram. Values below sub_bucket_count
+ * have a bucket each, above that every power of two is split into sub_bucket_count linear buckets, so quantiles
+ * are within about 3% of the recorded value. Recording is a few relaxed atomic operations, reads see a snapshot
+ * which may miss concurrent records.
+ */
+class stat_histogram
+{
+public:
+	stat_histogram ();
+	void record (uint64_t);
+	void clear ();
+	uint64_t count () const;
+	uint64_t sum () const;
+	uint64_t max () const;
+	/** Returns the largest value in the bucket holding the given quantile (0 to 1) of the recorded values, 0 if there are none */
+	uint64_t quantile (double) const;
+	static size_t constexpr sub_bucket_bits = 5;
+	static size_t constexpr sub_bucket_count = 1 << sub_bucket_bits;
+	/** Values of 2^max_bits and above, about 12 days, are recorded as 2^max_bits - 1 */
+	static size_t constexpr max_bits = 40;
+	static size_t constexpr bucket_count = (max_bits - sub_bucket_bits + 1) * sub_bucket_count;
+	static size_t bucket_index (uint64_t);
+	static uint64_t bucket_max (size_t);
+
+private:
+	std::array<std::atomic<uint64_t>, bucket_count> buckets;
+	std::atomic<uint64_t> total_count;
+	std::atomic<uint64_t> total_sum;
+	std::atomic<uint64_t> maximum;
+};
+
+/** Bookkeeping of samples and observers for a specific type/detail/direction combination, the counter itself lives in cga::stat */
 class stat_entry
 {
 public:
-	stat_entry (size_t capacity, size_t interval) :
-	samples (capacity), sample_interval (interval)
+	stat_entry (size_t capacity, size_t interval, uint64_t value) :
+	samples (capacity), sample_interval (interval), sample_start_value (value), observed_value (value)
 	{
 	}
 
@@ -132,16 +174,16 @@ public:
 	/** Sample interval in milliseconds. If 0, sampling is disabled. */
 	size_t sample_interval;
 
-	/** Value within the current sample interval */
-	stat_datapoint sample_current;
+	/** Counter value when the current sample interval started, the sample is the increase since then */
+	uint64_t sample_start_value;
 
-	/** Counting value for this entry, including the time of last update. This is never reset and only increases. */
-	stat_datapoint counter;
+	/** Counter value last passed to the count observers */
+	uint64_t observed_value;
 
 	/** Zero or more observers for samples. Called at the end of the sample interval. */
 	cga::observer_set<boost::circular_buffer<stat_datapoint> &> sample_observers;
 
-	/** Observers for count. Called on each update. */
+	/** Observers for count. Called by the aggregator when the count has changed since the previous call. */
 	cga::observer_set<uint64_t, uint64_t> count_observers;
 };
 
@@ -174,6 +216,11 @@ public:
 	{
 	}
 
+	/** Write a histogram summary to the log */
+	virtual void write_histogram (tm & tm, std::string name, stat_histogram const & histogram)
+	{
+	}
+
 	/** Rotates the log (e.g. empty file). This is a no-op for sinks where rotation is not supported. */
 	virtual void rotate ()
 	{
@@ -228,7 +275,12 @@ public:
 		http_callback,
 		peering,
 		ipc,
-		udp
+		udp,
+		block_processor,
+		confirmation_height,
+		block_filter,
+		read_transaction,
+		_last // Must be the last enum
 	};
 
 	/** Optional detail type */
@@ -250,6 +302,7 @@ public:
 		state_block,
 		epoch_block,
 		fork,
+		pruned,
 
 		// message specific
 		keepalive,
@@ -295,26 +348,64 @@ public:
 
 		// peering
 		handshake,
+
+		// block processor pipeline stages
+		duplicate,
+		verified,
+		bad_signature,
+		processed,
+		post_commit,
+
+		// confirmation height
+		blocks_confirmed,
+		invalid_block,
+		cemented,
+
+		// block filter
+		filter_negative,
+		filter_positive,
+		filter_false_positive,
+
+		// read transaction
+		renewed,
+		begun,
+		_last // Must be the last enum
 	};
 
 	/** Direction of the stat. If the direction is irrelevant, use in */
 	enum class dir : uint8_t
 	{
 		in,
-		out
+		out,
+		_last // Must be the last enum
 	};
 
-	/** Constructor using the default config values */
-	stat ()
-	{
-	}
+	/** Latency histograms, all in microseconds */
+	enum class histogram : uint8_t
+	{
+		// From block_processor::add until the ledger stage takes the block
+		block_processor_queue,
+		ledger_process,
+		// Election start to confirmation
+		election,
+		// Signature check of a batch of votes
+		vote_verify,
+		// RPC request read to response written
+		rpc_request,
+		_last // Must be the last enum
+	};
+
+	/** Constructor using the default config values, without an aggregator so sampling, count observers and log writeout are inactive */
+	stat ();
 
 	/**
-	 * Initialize stats with a config.
+	 * Initialize stats with a config and start the aggregator thread, which takes samples, notifies count observers and writes logs.
 	 * @param config Configuration object; deserialized from config.json
 	 */
 	stat (cga::stat_config config);
 
+	~stat ();
+
 	/**
 	 * Call this to override the default sample interval and capacity, for a specific stat entry.
 	 * This must be called before any stat entries are added, as part of the node initialiation.
@@ -358,8 +449,8 @@ public:
 	}
 
 	/**
-	 * Add \p value to stat. If sampling is configured, this will update the current sample and
-	 * call any sample observers if the interval is over.
+	 * Add \p value to stat. This is a relaxed atomic add to the calling thread's shard, samples, observers
+	 * and logs are handled by the aggregator.
 	 *
 	 * @param type Main statistics type
 	 * @param detail Detail type, or detail::none to register on type-level only
@@ -369,18 +460,23 @@ public:
 	 */
 	void add (stat::type type, stat::detail detail, stat::dir dir, uint64_t value, bool detail_only = false)
 	{
-		constexpr uint32_t no_detail_mask = 0xffff00ff;
-		uint32_t key = key_of (type, detail, dir);
-
-		update (key, value);
+		auto shard (counters.data () + shard_index () * shard_stride);
+		shard[index_of (type, detail, dir)].fetch_add (value, std::memory_order_relaxed);
 
 		// Optionally update at type-level as well
-		if (!detail_only && (key & no_detail_mask) != key)
+		if (!detail_only && detail != stat::detail::all)
 		{
-			update (key & no_detail_mask, value);
+			shard[index_of (type, stat::detail::all, dir)].fetch_add (value, std::memory_order_relaxed);
 		}
 	}
 
+	/** Records a duration in the given histogram, lock free */
+	void record (stat::histogram histogram, std::chrono::steady_clock::duration duration)
+	{
+		auto microseconds (std::chrono::duration_cast<std::chrono::microseconds> (duration).count ());
+		histograms[static_cast<size_t> (histogram)].record (microseconds > 0 ? static_cast<uint64_t> (microseconds) : 0);
+	}
+
 	/**
 	 * Add a sampling observer for a given counter.
 	 * The observer receives a snapshot of the current sampling. Accessing the sample buffer is thus thread safe.
@@ -419,10 +515,10 @@ public:
 		return count (type, stat::detail::all, dir);
 	}
 
-	/** Returns current value for the given counter at the detail level */
+	/** Returns current value for the given counter at the detail level, summed over all shards */
 	uint64_t count (stat::type type, stat::detail detail, stat::dir dir = stat::dir::in)
 	{
-		return get_entry (key_of (type, detail, dir))->counter.get_value ();
+		return counter_value (index_of (type, detail, dir));
 	}
 
 	/** Returns the number of seconds since clear() was last called, or node startup if it's never called. */
@@ -437,23 +533,59 @@ public:
 	/** Log samples to the given log sink */
 	void log_samples (stat_log_sink & sink);
 
+	/** Log histogram summaries to the given log sink */
+	void log_histograms (stat_log_sink & sink);
+
 	/** Returns a new JSON log sink */
 	std::unique_ptr<stat_log_sink> log_sink_json ();
 
 	/** Returns a new file log sink */
 	std::unique_ptr<stat_log_sink> log_sink_file (std::string filename);
 
+	/** Number of distinct type, detail and direction combinations */
+	static size_t constexpr counter_count = static_cast<size_t> (stat::type::_last) * static_cast<size_t> (stat::detail::_last) * static_cast<size_t> (stat::dir::_last);
+
 private:
 	static std::string type_to_string (uint32_t key);
 	static std::string detail_to_string (uint32_t key);
 	static std::string dir_to_string (uint32_t key);
+	static std::string histogram_to_string (stat::histogram histogram);
 
-	/** Constructs a key given type, detail and direction. This is used as input to update(...) and get_entry(...) */
-	uint32_t key_of (stat::type type, stat::detail detail, stat::dir dir) const
+	/** Constructs a key given type, detail and direction. This is used as input to get_entry(...) and the string conversions */
+	static uint32_t key_of (stat::type type, stat::detail detail, stat::dir dir)
 	{
 		return static_cast<uint8_t> (type) << 16 | static_cast<uint8_t> (detail) << 8 | static_cast<uint8_t> (dir);
 	}
 
+	/** Position of the counter within a shard, ordered the same as keys */
+	static size_t index_of (stat::type type, stat::detail detail, stat::dir dir)
+	{
+		return (static_cast<size_t> (type) * static_cast<size_t> (stat::detail::_last) + static_cast<size_t> (detail)) * static_cast<size_t> (stat::dir::_last) + static_cast<size_t> (dir);
+	}
+
+	static size_t index_of (uint32_t key)
+	{
+		return index_of (static_cast<stat::type> (key >> 16 & 0xff), static_cast<stat::detail> (key >> 8 & 0xff), static_cast<stat::dir> (key & 0xff));
+	}
+
+	static uint32_t key_of (size_t index)
+	{
+		auto dir (index % static_cast<size_t> (stat::dir::_last));
+		index /= static_cast<size_t> (stat::dir::_last);
+		auto detail (index % static_cast<size_t> (stat::detail::_last));
+		auto type (index / static_cast<size_t> (stat::detail::_last));
+		return key_of (static_cast<stat::type> (type), static_cast<stat::detail> (detail), static_cast<stat::dir> (dir));
+	}
+
+	/** Shard written by the calling thread, threads are assigned round robin the first time they add to any stat */
+	size_t shard_index () const;
+
+	/** Sum of a counter over all shards */
+	uint64_t counter_value (size_t index) const;
+
+	/** Sums every counter over all shards */
+	std::vector<uint64_t> counter_values () const;
+
 	/** Get entry for key, creating a new entry if necessary, using interval and sample count from config */
 	std::shared_ptr<cga::stat_entry> get_entry (uint32_t key);
 
@@ -463,31 +595,47 @@ private:
 	/** Unlocked implementation of get_entry() */
 	std::shared_ptr<cga::stat_entry> get_entry_impl (uint32_t key, size_t sample_interval, size_t max_samples);
 
-	/**
-	 * Update count and sample and call any observers on the key
-	 * @param key a key constructor from stat::type, stat::detail and stat::direction
-	 * @value Amount to add to the counter
-	 */
-	void update (uint32_t key, uint64_t value);
+	/** Aggregator thread loop, wakes at the shortest configured sampling or logging interval */
+	void run ();
+
+	/** Takes due samples, notifies count observers and writes due logs. Called with stat_mutex held. */
+	void aggregate (std::unique_ptr<stat_log_sink> & log_count, std::unique_ptr<stat_log_sink> & log_sample, std::unique_ptr<stat_log_sink> & log_histogram);
 
 	/** Unlocked implementation of log_counters() to avoid using recursive locking */
-	void log_counters_impl (stat_log_sink & sink);
+	void log_counters_impl (stat_log_sink & sink, std::vector<uint64_t> const & values);
 
 	/** Unlocked implementation of log_samples() to avoid using recursive locking */
 	void log_samples_impl (stat_log_sink & sink);
 
+	/** Unlocked implementation of log_histograms() to avoid using recursive locking */
+	void log_histograms_impl (stat_log_sink & sink);
+
 	/** Time of last clear() call */
 	std::chrono::steady_clock::time_point timestamp{ std::chrono::steady_clock::now () };
 
 	/** Configuration deserialized from config.json */
 	cga::stat_config config;
 
-	/** Stat entries are sorted by key to simplify processing of log output */
+	/**
+	 * Every counter once per shard, shards are shard_stride apart which leaves at least a cache line
+	 * between them so threads writing different shards don't contend.
+	 */
+	std::vector<std::atomic<uint64_t>> counters;
+	size_t shard_count;
+	size_t shard_stride;
+
+	/** Entries for counters which are sampled or observed, sorted by key to simplify processing of log output */
 	std::map<uint32_t, std::shared_ptr<cga::stat_entry>> entries;
 	std::chrono::steady_clock::time_point log_last_count_writeout{ std::chrono::steady_clock::now () };
 	std::chrono::steady_clock::time_point log_last_sample_writeout{ std::chrono::steady_clock::now () };
+	std::chrono::steady_clock::time_point log_last_histogram_writeout{ std::chrono::steady_clock::now () };
+
+	std::array<stat_histogram, static_cast<size_t> (stat::histogram::_last)> histograms;
 
-	/** All access to stat is thread safe, including calls from observers on the same thread */
+	/** Guards entries and logging, counters are only accessed atomically */
 	std::mutex stat_mutex;
+	std::condition_variable condition;
+	bool stopped{ false };
+	std::thread aggregator;
 };
 }
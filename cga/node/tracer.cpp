@@ -0,0 +1,142 @@
+#include <cga/node/tracer.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+size_t constexpr cga::block_tracer::capacity;
+
+cga::block_tracer::block_tracer (uint64_t interval_a) :
+interval (interval_a),
+epoch (std::chrono::steady_clock::now ()),
+points (interval_a != 0 ? new point[capacity] : nullptr)
+{
+}
+
+void cga::block_tracer::record_sampled (cga::block_hash const & hash_a, cga::block_tracer::stage stage_a, std::chrono::steady_clock::time_point time_a)
+{
+	auto position_l (position.fetch_add (1, std::memory_order_relaxed));
+	auto & point_l (points[position_l % capacity]);
+	point_l.sequence.store (2 * position_l + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_release);
+	for (size_t i (0); i < point_l.hash.size (); ++i)
+	{
+		point_l.hash[i].store (hash_a.qwords[i], std::memory_order_relaxed);
+	}
+	auto time_l (time_a > epoch ? std::chrono::duration_cast<std::chrono::nanoseconds> (time_a - epoch).count () : 0);
+	point_l.time.store (static_cast<uint64_t> (time_l), std::memory_order_relaxed);
+	point_l.stage.store (static_cast<uint32_t> (stage_a), std::memory_order_relaxed);
+	point_l.role.store (static_cast<uint32_t> (cga::thread_role::get ()), std::memory_order_relaxed);
+	point_l.sequence.store (2 * position_l + 2, std::memory_order_release);
+}
+
+size_t cga::block_tracer::dump (std::ostream & stream_a)
+{
+	class entry
+	{
+	public:
+		cga::block_hash hash;
+		uint64_t time;
+		cga::block_tracer::stage stage;
+		cga::thread_role::name role;
+	};
+	std::vector<entry> entries;
+	if (points != nullptr)
+	{
+		entries.reserve (capacity);
+		for (size_t i (0); i < capacity; ++i)
+		{
+			auto & point_l (points[i]);
+			auto sequence (point_l.sequence.load (std::memory_order_acquire));
+			if (sequence != 0 && sequence % 2 == 0)
+			{
+				entry entry_l;
+				for (size_t j (0); j < point_l.hash.size (); ++j)
+				{
+					entry_l.hash.qwords[j] = point_l.hash[j].load (std::memory_order_relaxed);
+				}
+				entry_l.time = point_l.time.load (std::memory_order_relaxed);
+				entry_l.stage = static_cast<cga::block_tracer::stage> (point_l.stage.load (std::memory_order_relaxed));
+				entry_l.role = static_cast<cga::thread_role::name> (point_l.role.load (std::memory_order_relaxed));
+				std::atomic_thread_fence (std::memory_order_acquire);
+				// Overwritten while it was being copied
+				if (point_l.sequence.load (std::memory_order_relaxed) == sequence)
+				{
+					entries.push_back (entry_l);
+				}
+			}
+		}
+	}
+	std::sort (entries.begin (), entries.end (), [](entry const & lhs, entry const & rhs) {
+		return lhs.hash < rhs.hash || (lhs.hash == rhs.hash && lhs.time < rhs.time);
+	});
+	// Timestamps are in microseconds, kept to nanosecond precision
+	stream_a << std::fixed << std::setprecision (3);
+	stream_a << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	size_t blocks (0);
+	for (auto i (entries.begin ()), n (entries.end ()); i != n;)
+	{
+		auto end (std::find_if (i, n, [&i](entry const & entry_a) { return entry_a.hash != i->hash; }));
+		++blocks;
+		stream_a << (blocks > 1 ? ",\n" : "\n");
+		stream_a << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << blocks << ",\"args\":{\"name\":\"" << i->hash.to_string () << "\"}}";
+		for (auto j (i); j != end; ++j)
+		{
+			auto next (j + 1);
+			auto duration (next != end ? next->time - j->time : 0);
+			stream_a << ",\n{\"name\":\"" << stage_to_string (j->stage) << "\",\"cat\":\"block\",\"ph\":\"X\",\"pid\":1,\"tid\":" << blocks;
+			stream_a << ",\"ts\":" << j->time / 1000.0 << ",\"dur\":" << duration / 1000.0;
+			stream_a << ",\"args\":{\"thread\":\"" << cga::thread_role::get_string (j->role) << "\"}}";
+		}
+		i = end;
+	}
+	stream_a << "\n]}\n";
+	return blocks;
+}
+
+std::string cga::block_tracer::stage_to_string (cga::block_tracer::stage stage_a)
+{
+	std::string result;
+	switch (stage_a)
+	{
+		case cga::block_tracer::stage::udp_buffer:
+			result = "udp_buffer";
+			break;
+		case cga::block_tracer::stage::receive_action:
+			result = "receive_action";
+			break;
+		case cga::block_tracer::stage::block_processor_add:
+			result = "block_processor::add";
+			break;
+		case cga::block_tracer::stage::signature_batch:
+			result = "signature_batch";
+			break;
+		case cga::block_tracer::stage::verified:
+			result = "verified";
+			break;
+		case cga::block_tracer::stage::process_one:
+			result = "process_one";
+			break;
+		case cga::block_tracer::stage::post_commit:
+			result = "post_commit";
+			break;
+		case cga::block_tracer::stage::active_start:
+			result = "active.start";
+			break;
+		case cga::block_tracer::stage::vote_generator:
+			result = "vote_generator";
+			break;
+		case cga::block_tracer::stage::first_vote:
+			result = "first_vote";
+			break;
+		case cga::block_tracer::stage::confirm_once:
+			result = "confirm_once";
+			break;
+		case cga::block_tracer::stage::process_confirmed:
+			result = "process_confirmed";
+			break;
+		case cga::block_tracer::stage::_last:
+			break;
+	}
+	return result;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cga/lib/numbers.hpp>
+#include <cga/lib/utility.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace cga
+{
+/**
+ * Follows a sample of blocks through the node, recording when each one reaches a stage of its lifecycle.
+ * A block is sampled if its hash is a multiple of the interval, so every stage agrees on which blocks
+ * are sampled without sharing any state. Points are kept in a fixed size ring which overwrites the oldest,
+ * recording is lock free and costs a single division for blocks which aren't sampled.
+ */
+class block_tracer
+{
+public:
+	/** Points in the lifecycle, each starts a span lasting until the block reaches its next point */
+	enum class stage : uint8_t
+	{
+		udp_buffer,
+		receive_action,
+		block_processor_add,
+		signature_batch,
+		verified,
+		process_one,
+		post_commit,
+		active_start,
+		vote_generator,
+		first_vote,
+		confirm_once,
+		process_confirmed,
+		_last
+	};
+	/** Samples one in \p interval blocks, 0 disables tracing */
+	block_tracer (uint64_t interval);
+	bool enabled () const
+	{
+		return interval != 0;
+	}
+	/** The clock is only read for sampled blocks */
+	void record (cga::block_hash const & hash_a, cga::block_tracer::stage stage_a)
+	{
+		if (interval != 0 && hash_a.qwords[0] % interval == 0)
+		{
+			record_sampled (hash_a, stage_a, std::chrono::steady_clock::now ());
+		}
+	}
+	void record (cga::block_hash const & hash_a, cga::block_tracer::stage stage_a, std::chrono::steady_clock::time_point time_a)
+	{
+		if (interval != 0 && hash_a.qwords[0] % interval == 0)
+		{
+			record_sampled (hash_a, stage_a, time_a);
+		}
+	}
+	/**
+	 * Writes the recorded points as Chrome trace_event JSON, for chrome://tracing or Perfetto.
+	 * Each block gets its own track with a span per stage. Returns the number of blocks written.
+	 */
+	size_t dump (std::ostream &);
+	static std::string stage_to_string (cga::block_tracer::stage);
+	static size_t constexpr capacity = 64 * 1024;
+
+private:
+	/**
+	 * Written as a seqlock, the sequence is odd while a writer is filling the point in.
+	 * Readers discard points whose sequence changed while they copied them.
+	 */
+	class point
+	{
+	public:
+		std::atomic<uint64_t> sequence{ 0 };
+		std::array<std::atomic<uint64_t>, 4> hash;
+		std::atomic<uint64_t> time{ 0 };
+		std::atomic<uint32_t> stage{ 0 };
+		std::atomic<uint32_t> role{ 0 };
+	};
+	void record_sampled (cga::block_hash const &, cga::block_tracer::stage, std::chrono::steady_clock::time_point);
+	uint64_t const interval;
+	std::chrono::steady_clock::time_point const epoch;
+	std::unique_ptr<point[]> points;
+	std::atomic<uint64_t> position{ 0 };
+};
+}
@@ -49,6 +49,10 @@ void cga::vote_generator::send (std::unique_lock<std::mutex> & lock_a)
 		hashes.pop_front ();
 	}
 	lock_a.unlock ();
+	for (auto & hash : hashes_l)
+	{
+		node.tracer.record (hash, cga::block_tracer::stage::vote_generator);
+	}
 	{
 		auto transaction (node.store.tx_begin_read ());
 		node.wallets.foreach_representative (transaction, [this, &hashes_l, &transaction](cga::public_key const & pub_a, cga::raw_key const & prv_a) {
@@ -101,8 +105,13 @@ void cga::vote_generator::run ()
 	}
 }
 
-void cga::votes_cache::add (std::shared_ptr<cga::vote> const & vote_a)
+void cga::votes_cache::add (std::shared_ptr<cga::vote> const & vote_a, std::shared_ptr<cga::wire_message const> message_a)
 {
+	if (message_a == nullptr)
+	{
+		message_a = std::make_shared<cga::wire_message const> (cga::confirm_ack (vote_a));
+	}
+	auto entry (std::make_pair (vote_a, message_a));
 	std::lock_guard<std::mutex> lock (cache_mutex);
 	for (auto & block : vote_a->blocks)
 	{
@@ -116,22 +125,22 @@ void cga::votes_cache::add (std::shared_ptr<cga::vote> const & vote_a)
 				cache.erase (cache.begin ());
 			}
 			// Insert new votes (new hash)
-			auto inserted (cache.insert (cga::cached_votes{ std::chrono::steady_clock::now (), hash, std::vector<std::shared_ptr<cga::vote>> (1, vote_a) }));
+			auto inserted (cache.insert (cga::cached_votes{ std::chrono::steady_clock::now (), hash, { entry } }));
 			assert (inserted.second);
 		}
 		else
 		{
 			// Insert new votes (old hash)
-			cache.get<1> ().modify (existing, [vote_a](cga::cached_votes & cache_a) {
-				cache_a.votes.push_back (vote_a);
+			cache.get<1> ().modify (existing, [&entry](cga::cached_votes & cache_a) {
+				cache_a.votes.push_back (entry);
 			});
 		}
 	}
 }
 
-std::vector<std::shared_ptr<cga::vote>> cga::votes_cache::find (cga::block_hash const & hash_a)
+std::vector<std::pair<std::shared_ptr<cga::vote>, std::shared_ptr<cga::wire_message const>>> cga::votes_cache::find (cga::block_hash const & hash_a)
 {
-	std::vector<std::shared_ptr<cga::vote>> result;
+	std::vector<std::pair<std::shared_ptr<cga::vote>, std::shared_ptr<cga::wire_message const>>> result;
 	std::lock_guard<std::mutex> lock (cache_mutex);
 	auto existing (cache.get<1> ().find (hash_a));
 	if (existing != cache.get<1> ().end ())
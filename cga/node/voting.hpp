@@ -18,6 +18,7 @@
 namespace cga
 {
 class node;
+class wire_message;
 class vote_generator
 {
 public:
@@ -46,13 +47,15 @@ class cached_votes
 public:
 	std::chrono::steady_clock::time_point time;
 	cga::block_hash hash;
-	std::vector<std::shared_ptr<cga::vote>> votes;
+	// Each vote alongside its serialized confirm_ack, shared by every peer the cached vote is sent to
+	std::vector<std::pair<std::shared_ptr<cga::vote>, std::shared_ptr<cga::wire_message const>>> votes;
 };
 class votes_cache
 {
 public:
-	void add (std::shared_ptr<cga::vote> const &);
-	std::vector<std::shared_ptr<cga::vote>> find (cga::block_hash const &);
+	// Serializes the vote unless its confirm_ack is supplied
+	void add (std::shared_ptr<cga::vote> const &, std::shared_ptr<cga::wire_message const> = nullptr);
+	std::vector<std::pair<std::shared_ptr<cga::vote>, std::shared_ptr<cga::wire_message const>>> find (cga::block_hash const &);
 	void remove (cga::block_hash const &);
 
 private:
@@ -1221,7 +1221,15 @@ bool cga::wallet::search_pending ()
 					if (wallets.node.config.receive_minimum.number () <= amount)
 					{
 						BOOST_LOG (wallets.node.log) << boost::str (boost::format ("Found a pending block %1% for account %2%") % hash.to_string () % pending.source.to_account ());
-						wallets.node.block_confirm (wallets.node.store.block_get (block_transaction, hash));
+						auto block (wallets.node.store.block_get (block_transaction, hash));
+						if (block != nullptr)
+						{
+							wallets.node.block_confirm (block);
+						}
+						else
+						{
+							BOOST_LOG (wallets.node.log) << boost::str (boost::format ("Pending block %1% has been pruned and can't be received by this node") % hash.to_string ());
+						}
 					}
 				}
 			}
@@ -88,6 +88,161 @@ bool cga::block_sideband::deserialize (cga::stream & stream_a)
 	return result;
 }
 
+cga::block_view::block_view (cga::block_type type_a, uint8_t const * data_a, cga::block_sideband const & sideband_a) :
+type_m (type_a),
+data (data_a),
+sideband_m (sideband_a)
+{
+	// Fields the sideband leaves out because the block carries them
+	if (type_m == cga::block_type::open || type_m == cga::block_type::state)
+	{
+		sideband_m.account = account ();
+	}
+	if (type_m == cga::block_type::send || type_m == cga::block_type::state)
+	{
+		sideband_m.balance = balance ();
+	}
+}
+
+cga::block_type cga::block_view::type () const
+{
+	return type_m;
+}
+
+cga::block_hash cga::block_view::previous () const
+{
+	cga::block_hash result (0);
+	switch (type_m)
+	{
+		case cga::block_type::send:
+		case cga::block_type::receive:
+		case cga::block_type::change:
+			result = field (0);
+			break;
+		case cga::block_type::state:
+			result = field (32);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+cga::block_hash cga::block_view::source () const
+{
+	cga::block_hash result (0);
+	switch (type_m)
+	{
+		case cga::block_type::receive:
+			result = field (32);
+			break;
+		case cga::block_type::open:
+			result = field (0);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+cga::account cga::block_view::representative () const
+{
+	cga::account result (0);
+	switch (type_m)
+	{
+		case cga::block_type::open:
+		case cga::block_type::change:
+			result = field (32);
+			break;
+		case cga::block_type::state:
+			result = field (64);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+cga::uint256_union cga::block_view::link () const
+{
+	cga::uint256_union result (0);
+	if (type_m == cga::block_type::state)
+	{
+		result = field (112);
+	}
+	return result;
+}
+
+cga::amount cga::block_view::balance () const
+{
+	cga::amount result (sideband_m.balance);
+	size_t offset (0);
+	switch (type_m)
+	{
+		case cga::block_type::send:
+			offset = 64;
+			break;
+		case cga::block_type::state:
+			offset = 96;
+			break;
+		default:
+			break;
+	}
+	if (offset != 0)
+	{
+		std::copy (data + offset, data + offset + sizeof (result.bytes), result.bytes.begin ());
+	}
+	return result;
+}
+
+cga::account cga::block_view::account () const
+{
+	cga::account result (sideband_m.account);
+	switch (type_m)
+	{
+		case cga::block_type::open:
+			result = field (64);
+			break;
+		case cga::block_type::state:
+			result = field (0);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+cga::block_sideband const & cga::block_view::sideband () const
+{
+	return sideband_m;
+}
+
+std::shared_ptr<cga::block> cga::block_view::block () const
+{
+	assert (data != nullptr);
+	cga::bufferstream stream (data, cga::block::size (type_m));
+	auto result (cga::deserialize_block (stream, type_m));
+	assert (result != nullptr);
+	return result;
+}
+
+void cga::block_view::serialize (cga::stream & stream_a) const
+{
+	assert (data != nullptr);
+	cga::write (stream_a, type_m);
+	auto size (cga::block::size (type_m));
+	auto amount_written (stream_a.sputn (data, size));
+	assert (amount_written == size);
+}
+
+cga::uint256_union cga::block_view::field (size_t offset_a) const
+{
+	assert (data != nullptr && offset_a + sizeof (cga::uint256_union) <= cga::block::size (type_m));
+	cga::uint256_union result;
+	std::copy (data + offset_a, data + offset_a + sizeof (result.bytes), result.bytes.begin ());
+	return result;
+}
+
 cga::summation_visitor::summation_visitor (cga::transaction const & transaction_a, cga::block_store & store_a) :
 transaction (transaction_a),
 store (store_a)
@@ -367,3 +522,30 @@ void cga::representative_visitor::state_block (cga::state_block const & block_a)
 {
 	result = block_a.hash ();
 }
+
+namespace
+{
+void commit_hook (cga::transaction_impl & impl_a, std::function<void()> const & action_a)
+{
+	impl_a.committed.push_back ([action_a](cga::transaction_impl * parent_a) {
+		if (parent_a != nullptr)
+		{
+			commit_hook (*parent_a, action_a);
+		}
+		else
+		{
+			action_a ();
+		}
+	});
+}
+}
+
+void cga::transaction::on_commit (std::function<void()> const & action_a) const
+{
+	commit_hook (*impl, action_a);
+}
+
+void cga::transaction::on_abort (std::function<void()> const & action_a) const
+{
+	impl->aborted.push_back (action_a);
+}
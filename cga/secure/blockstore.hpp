@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cga/secure/common.hpp>
+
+#include <functional>
+#include <future>
 #include <stack>
 
 namespace cga
@@ -20,6 +23,36 @@ public:
 	uint64_t height;
 	uint64_t timestamp;
 };
+/**
+ * Read only access to a stored block's fields in place, without deserializing it into a cga::block.
+ * Points into the database's mapped memory so it's only valid for the lifetime of the read transaction it came from.
+ * Field accessors return zero for fields the block type doesn't have, the same as cga::block.
+ */
+class block_view
+{
+public:
+	block_view () = default;
+	block_view (cga::block_type, uint8_t const *, cga::block_sideband const &);
+	cga::block_type type () const;
+	cga::block_hash previous () const;
+	cga::block_hash source () const;
+	cga::account representative () const;
+	cga::uint256_union link () const;
+	// Account balance after this block, from the block if it carries one otherwise from the sideband
+	cga::amount balance () const;
+	cga::account account () const;
+	cga::block_sideband const & sideband () const;
+	// Copies the block out, for callers which need it past the transaction or the full block
+	std::shared_ptr<cga::block> block () const;
+	// Writes the same bytes as cga::serialize_block
+	void serialize (cga::stream &) const;
+
+private:
+	cga::uint256_union field (size_t) const;
+	cga::block_type type_m{ cga::block_type::invalid };
+	uint8_t const * data{ nullptr };
+	cga::block_sideband sideband_m;
+};
 class transaction;
 class block_store;
 
@@ -189,6 +222,14 @@ class transaction_impl
 {
 public:
 	virtual ~transaction_impl () = default;
+	/**
+	 * In-memory side effects of a write transaction. Called with the parent when a nested transaction commits into it,
+	 * or with null once the changes are durable. Dropped if the transaction is aborted, which calls `aborted' instead
+	 */
+	std::vector<std::function<void(cga::transaction_impl *)>> committed;
+	std::vector<std::function<void()>> aborted;
+	// Set for nested transactions
+	cga::transaction_impl * parent{ nullptr };
 };
 /**
  * RAII wrapper of MDB_txn where the constructor starts the transaction
@@ -197,6 +238,10 @@ public:
 class transaction
 {
 public:
+	// Calls the action once the transaction's changes are durable
+	void on_commit (std::function<void()> const &) const;
+	// Calls the action if the transaction, or a parent it was committed into, is aborted
+	void on_abort (std::function<void()> const &) const;
 	std::unique_ptr<cga::transaction_impl> impl;
 };
 
@@ -212,6 +257,8 @@ public:
 	virtual cga::block_hash block_successor (cga::transaction const &, cga::block_hash const &) = 0;
 	virtual void block_successor_clear (cga::transaction const &, cga::block_hash const &) = 0;
 	virtual std::shared_ptr<cga::block> block_get (cga::transaction const &, cga::block_hash const &, cga::block_sideband * = nullptr) = 0;
+	// Returns true if the block doesn't exist
+	virtual bool block_view_get (cga::transaction const &, cga::block_hash const &, cga::block_view &) = 0;
 	virtual std::shared_ptr<cga::block> block_random (cga::transaction const &) = 0;
 	virtual void block_del (cga::transaction const &, cga::block_hash const &) = 0;
 	virtual bool block_exists (cga::transaction const &, cga::block_hash const &) = 0;
@@ -220,6 +267,11 @@ public:
 	virtual bool root_exists (cga::transaction const &, cga::uint256_union const &) = 0;
 	virtual bool source_exists (cga::transaction const &, cga::block_hash const &) = 0;
 	virtual cga::account block_account (cga::transaction const &, cga::block_hash const &) = 0;
+	// Replaces the block body with its account, balance and version, which is all the ledger needs from cemented history
+	virtual void block_prune (cga::transaction const &, cga::block_hash const &) = 0;
+	virtual bool pruned_exists (cga::transaction const &, cga::block_hash const &) = 0;
+	virtual bool pruned_get (cga::transaction const &, cga::block_hash const &, cga::block_info &) = 0;
+	virtual size_t pruned_count (cga::transaction const &) = 0;
 
 	virtual void frontier_put (cga::transaction const &, cga::block_hash const &, cga::account const &) = 0;
 	virtual cga::account frontier_get (cga::transaction const &, cga::block_hash const &) = 0;
@@ -230,12 +282,6 @@ public:
 	virtual void account_del (cga::transaction const &, cga::account const &) = 0;
 	virtual bool account_exists (cga::transaction const &, cga::account const &) = 0;
 	virtual size_t account_count (cga::transaction const &) = 0;
-	virtual cga::store_iterator<cga::account, cga::account_info> latest_v0_begin (cga::transaction const &, cga::account const &) = 0;
-	virtual cga::store_iterator<cga::account, cga::account_info> latest_v0_begin (cga::transaction const &) = 0;
-	virtual cga::store_iterator<cga::account, cga::account_info> latest_v0_end () = 0;
-	virtual cga::store_iterator<cga::account, cga::account_info> latest_v1_begin (cga::transaction const &, cga::account const &) = 0;
-	virtual cga::store_iterator<cga::account, cga::account_info> latest_v1_begin (cga::transaction const &) = 0;
-	virtual cga::store_iterator<cga::account, cga::account_info> latest_v1_end () = 0;
 	virtual cga::store_iterator<cga::account, cga::account_info> latest_begin (cga::transaction const &, cga::account const &) = 0;
 	virtual cga::store_iterator<cga::account, cga::account_info> latest_begin (cga::transaction const &) = 0;
 	virtual cga::store_iterator<cga::account, cga::account_info> latest_end () = 0;
@@ -244,16 +290,15 @@ public:
 	virtual void pending_del (cga::transaction const &, cga::pending_key const &) = 0;
 	virtual bool pending_get (cga::transaction const &, cga::pending_key const &, cga::pending_info &) = 0;
 	virtual bool pending_exists (cga::transaction const &, cga::pending_key const &) = 0;
-	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_v0_begin (cga::transaction const &, cga::pending_key const &) = 0;
-	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_v0_begin (cga::transaction const &) = 0;
-	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_v0_end () = 0;
-	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_v1_begin (cga::transaction const &, cga::pending_key const &) = 0;
-	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_v1_begin (cga::transaction const &) = 0;
-	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_v1_end () = 0;
 	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_begin (cga::transaction const &, cga::pending_key const &) = 0;
 	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_begin (cga::transaction const &) = 0;
 	virtual cga::store_iterator<cga::pending_key, cga::pending_info> pending_end () = 0;
 
+	virtual void delegator_put (cga::transaction const &, cga::delegator_key const &) = 0;
+	virtual void delegator_del (cga::transaction const &, cga::delegator_key const &) = 0;
+	virtual cga::store_iterator<cga::delegator_key, cga::no_value> delegators_begin (cga::transaction const &, cga::delegator_key const &) = 0;
+	virtual cga::store_iterator<cga::delegator_key, cga::no_value> delegators_end () = 0;
+
 	virtual bool block_info_get (cga::transaction const &, cga::block_hash const &, cga::block_info &) = 0;
 	virtual cga::uint128_t block_balance (cga::transaction const &, cga::block_hash const &) = 0;
 	virtual cga::epoch block_version (cga::transaction const &, cga::block_hash const &) = 0;
@@ -323,5 +368,14 @@ public:
 	 * @param write If true, start a read-write transaction
 	 */
 	virtual cga::transaction tx_begin (bool write = false) = 0;
+
+	/**
+	 * Queue a write to be grouped with other queued writes into a single read-write transaction
+	 * The returned future is ready once that transaction has committed, it must not be waited on while holding a read-write transaction
+	 */
+	virtual std::future<void> tx_queue_write (std::function<void(cga::transaction const &)> const &) = 0;
+
+	/** Commit all queued writes, later writes are committed in their own transaction */
+	virtual void tx_queue_stop () = 0;
 };
 }
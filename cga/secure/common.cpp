@@ -157,17 +157,19 @@ open_block (0),
 balance (0),
 modified (0),
 block_count (0),
+confirmation_height (0),
 epoch (cga::epoch::epoch_0)
 {
 }
 
-cga::account_info::account_info (cga::block_hash const & head_a, cga::block_hash const & rep_block_a, cga::block_hash const & open_block_a, cga::amount const & balance_a, uint64_t modified_a, uint64_t block_count_a, cga::epoch epoch_a) :
+cga::account_info::account_info (cga::block_hash const & head_a, cga::block_hash const & rep_block_a, cga::block_hash const & open_block_a, cga::amount const & balance_a, uint64_t modified_a, uint64_t block_count_a, uint64_t confirmation_height_a, cga::epoch epoch_a) :
 head (head_a),
 rep_block (rep_block_a),
 open_block (open_block_a),
 balance (balance_a),
 modified (modified_a),
 block_count (block_count_a),
+confirmation_height (confirmation_height_a),
 epoch (epoch_a)
 {
 }
@@ -180,6 +182,7 @@ void cga::account_info::serialize (cga::stream & stream_a) const
 	write (stream_a, balance.bytes);
 	write (stream_a, modified);
 	write (stream_a, block_count);
+	write (stream_a, confirmation_height);
 }
 
 bool cga::account_info::deserialize (cga::stream & stream_a)
@@ -193,6 +196,7 @@ bool cga::account_info::deserialize (cga::stream & stream_a)
 		cga::read (stream_a, balance.bytes);
 		cga::read (stream_a, modified);
 		cga::read (stream_a, block_count);
+		cga::read (stream_a, confirmation_height);
 	}
 	catch (std::runtime_error const &)
 	{
@@ -204,7 +208,7 @@ bool cga::account_info::deserialize (cga::stream & stream_a)
 
 bool cga::account_info::operator== (cga::account_info const & other_a) const
 {
-	return head == other_a.head && rep_block == other_a.rep_block && open_block == other_a.open_block && balance == other_a.balance && modified == other_a.modified && block_count == other_a.block_count && epoch == other_a.epoch;
+	return head == other_a.head && rep_block == other_a.rep_block && open_block == other_a.open_block && balance == other_a.balance && modified == other_a.modified && block_count == other_a.block_count && confirmation_height == other_a.confirmation_height && epoch == other_a.epoch;
 }
 
 bool cga::account_info::operator!= (cga::account_info const & other_a) const
@@ -220,7 +224,9 @@ size_t cga::account_info::db_size () const
 	assert (reinterpret_cast<const uint8_t *> (&open_block) + sizeof (open_block) == reinterpret_cast<const uint8_t *> (&balance));
 	assert (reinterpret_cast<const uint8_t *> (&balance) + sizeof (balance) == reinterpret_cast<const uint8_t *> (&modified));
 	assert (reinterpret_cast<const uint8_t *> (&modified) + sizeof (modified) == reinterpret_cast<const uint8_t *> (&block_count));
-	return sizeof (head) + sizeof (rep_block) + sizeof (open_block) + sizeof (balance) + sizeof (modified) + sizeof (block_count);
+	assert (reinterpret_cast<const uint8_t *> (&block_count) + sizeof (block_count) == reinterpret_cast<const uint8_t *> (&confirmation_height));
+	assert (reinterpret_cast<const uint8_t *> (&confirmation_height) + sizeof (confirmation_height) == reinterpret_cast<const uint8_t *> (&epoch));
+	return sizeof (head) + sizeof (rep_block) + sizeof (open_block) + sizeof (balance) + sizeof (modified) + sizeof (block_count) + sizeof (confirmation_height) + sizeof (epoch);
 }
 
 cga::block_counts::block_counts () :
@@ -279,6 +285,14 @@ bool cga::pending_info::operator== (cga::pending_info const & other_a) const
 	return source == other_a.source && amount == other_a.amount && epoch == other_a.epoch;
 }
 
+size_t cga::pending_info::db_size () const
+{
+	assert (reinterpret_cast<const uint8_t *> (this) == reinterpret_cast<const uint8_t *> (&source));
+	assert (reinterpret_cast<const uint8_t *> (&source) + sizeof (source) == reinterpret_cast<const uint8_t *> (&amount));
+	assert (reinterpret_cast<const uint8_t *> (&amount) + sizeof (amount) == reinterpret_cast<const uint8_t *> (&epoch));
+	return sizeof (source) + sizeof (amount) + sizeof (epoch);
+}
+
 cga::pending_key::pending_key () :
 account (0),
 hash (0)
@@ -323,6 +337,23 @@ cga::block_hash cga::pending_key::key () const
 	return account;
 }
 
+cga::delegator_key::delegator_key () :
+representative (0),
+account (0)
+{
+}
+
+cga::delegator_key::delegator_key (cga::account const & representative_a, cga::account const & account_a) :
+representative (representative_a),
+account (account_a)
+{
+}
+
+bool cga::delegator_key::operator== (cga::delegator_key const & other_a) const
+{
+	return representative == other_a.representative && account == other_a.account;
+}
+
 cga::unchecked_info::unchecked_info () :
 block (nullptr),
 account (0),
@@ -80,11 +80,12 @@ class account_info
 public:
 	account_info ();
 	account_info (cga::account_info const &) = default;
-	account_info (cga::block_hash const &, cga::block_hash const &, cga::block_hash const &, cga::amount const &, uint64_t, uint64_t, epoch);
+	account_info (cga::block_hash const &, cga::block_hash const &, cga::block_hash const &, cga::amount const &, uint64_t, uint64_t, uint64_t, epoch);
 	void serialize (cga::stream &) const;
 	bool deserialize (cga::stream &);
 	bool operator== (cga::account_info const &) const;
 	bool operator!= (cga::account_info const &) const;
+	/** Size of the database value, the fields are stored as laid out in memory up to and including the epoch */
 	size_t db_size () const;
 	cga::block_hash head;
 	cga::block_hash rep_block;
@@ -93,6 +94,8 @@ public:
 	/** Seconds since posix epoch */
 	uint64_t modified;
 	uint64_t block_count;
+	/** Height of the highest cemented block, every block at or below it is final and can't be rolled back */
+	uint64_t confirmation_height;
 	cga::epoch epoch;
 };
 
@@ -107,6 +110,8 @@ public:
 	void serialize (cga::stream &) const;
 	bool deserialize (cga::stream &);
 	bool operator== (cga::pending_info const &) const;
+	/** Size of the database value, the fields are stored as laid out in memory up to and including the epoch */
+	size_t db_size () const;
 	cga::account source;
 	cga::amount amount;
 	cga::epoch epoch;
@@ -124,6 +129,19 @@ public:
 	cga::block_hash key () const;
 };
 
+/**
+ * Key of the delegators index, ordered by representative first so one representative's delegators are a contiguous range
+ */
+class delegator_key
+{
+public:
+	delegator_key ();
+	delegator_key (cga::account const &, cga::account const &);
+	bool operator== (cga::delegator_key const &) const;
+	cga::account representative;
+	cga::account account;
+};
+
 class endpoint_key
 {
 public:
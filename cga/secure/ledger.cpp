@@ -14,7 +14,8 @@ public:
 	rollback_visitor (cga::transaction const & transaction_a, cga::ledger & ledger_a, std::vector<cga::block_hash> & list_a) :
 	transaction (transaction_a),
 	ledger (ledger_a),
-	list (list_a)
+	list (list_a),
+	error (false)
 	{
 	}
 	virtual ~rollback_visitor () = default;
@@ -23,33 +24,37 @@ public:
 		auto hash (block_a.hash ());
 		cga::pending_info pending;
 		cga::pending_key key (block_a.hashables.destination, hash);
-		while (ledger.store.pending_get (transaction, key, pending))
+		while (!error && ledger.store.pending_get (transaction, key, pending))
 		{
-			ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.destination), list);
+			error = ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.destination), list);
+		}
+		if (!error)
+		{
+			cga::account_info info;
+			auto latest_error (ledger.store.account_get (transaction, pending.source, info));
+			assert (!latest_error);
+			ledger.store.pending_del (transaction, key);
+			ledger.representation_add (transaction, ledger.representative (transaction, hash), pending.amount.number ());
+			ledger.change_latest (transaction, pending.source, block_a.hashables.previous, info.rep_block, ledger.balance (transaction, block_a.hashables.previous), info.block_count - 1);
+			ledger.store.block_del (transaction, hash);
+			ledger.store.frontier_del (transaction, hash);
+			ledger.store.frontier_put (transaction, block_a.hashables.previous, pending.source);
+			ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+			ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::send);
 		}
-		cga::account_info info;
-		auto error (ledger.store.account_get (transaction, pending.source, info));
-		assert (!error);
-		ledger.store.pending_del (transaction, key);
-		ledger.store.representation_add (transaction, ledger.representative (transaction, hash), pending.amount.number ());
-		ledger.change_latest (transaction, pending.source, block_a.hashables.previous, info.rep_block, ledger.balance (transaction, block_a.hashables.previous), info.block_count - 1);
-		ledger.store.block_del (transaction, hash);
-		ledger.store.frontier_del (transaction, hash);
-		ledger.store.frontier_put (transaction, block_a.hashables.previous, pending.source);
-		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-		ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::send);
 	}
 	void receive_block (cga::receive_block const & block_a) override
 	{
 		auto hash (block_a.hash ());
 		auto representative (ledger.representative (transaction, block_a.hashables.previous));
-		auto amount (ledger.amount (transaction, block_a.hashables.source));
+		// Taken from this chain's balances, the source block may have been pruned
+		auto amount (ledger.balance (transaction, hash) - ledger.balance (transaction, block_a.hashables.previous));
 		auto destination_account (ledger.account (transaction, hash));
 		auto source_account (ledger.account (transaction, block_a.hashables.source));
 		cga::account_info info;
 		auto error (ledger.store.account_get (transaction, destination_account, info));
 		assert (!error);
-		ledger.store.representation_add (transaction, ledger.representative (transaction, hash), 0 - amount);
+		ledger.representation_add (transaction, ledger.representative (transaction, hash), 0 - amount);
 		ledger.change_latest (transaction, destination_account, block_a.hashables.previous, representative, ledger.balance (transaction, block_a.hashables.previous), info.block_count - 1);
 		ledger.store.block_del (transaction, hash);
 		ledger.store.pending_put (transaction, cga::pending_key (destination_account, block_a.hashables.source), { source_account, amount, cga::epoch::epoch_0 });
@@ -61,10 +66,10 @@ public:
 	void open_block (cga::open_block const & block_a) override
 	{
 		auto hash (block_a.hash ());
-		auto amount (ledger.amount (transaction, block_a.hashables.source));
+		auto amount (ledger.balance (transaction, hash));
 		auto destination_account (ledger.account (transaction, hash));
 		auto source_account (ledger.account (transaction, block_a.hashables.source));
-		ledger.store.representation_add (transaction, ledger.representative (transaction, hash), 0 - amount);
+		ledger.representation_add (transaction, ledger.representative (transaction, hash), 0 - amount);
 		ledger.change_latest (transaction, destination_account, 0, 0, 0, 0);
 		ledger.store.block_del (transaction, hash);
 		ledger.store.pending_put (transaction, cga::pending_key (destination_account, block_a.hashables.source), { source_account, amount, cga::epoch::epoch_0 });
@@ -80,10 +85,10 @@ public:
 		auto error (ledger.store.account_get (transaction, account, info));
 		assert (!error);
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
-		ledger.store.representation_add (transaction, representative, balance);
-		ledger.store.representation_add (transaction, hash, 0 - balance);
-		ledger.store.block_del (transaction, hash);
+		ledger.representation_add (transaction, representative, balance);
+		ledger.representation_add (transaction, hash, 0 - balance);
 		ledger.change_latest (transaction, account, block_a.hashables.previous, representative, info.balance, info.block_count - 1);
+		ledger.store.block_del (transaction, hash);
 		ledger.store.frontier_del (transaction, hash);
 		ledger.store.frontier_put (transaction, block_a.hashables.previous, account);
 		ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
@@ -92,64 +97,74 @@ public:
 	void state_block (cga::state_block const & block_a) override
 	{
 		auto hash (block_a.hash ());
-		cga::block_hash representative (0);
-		if (!block_a.hashables.previous.is_zero ())
-		{
-			representative = ledger.representative (transaction, block_a.hashables.previous);
-		}
 		auto balance (ledger.balance (transaction, block_a.hashables.previous));
 		auto is_send (block_a.hashables.balance < balance);
-		// Add in amount delta
-		ledger.store.representation_add (transaction, hash, 0 - block_a.hashables.balance.number ());
-		if (!representative.is_zero ())
-		{
-			// Move existing representation
-			ledger.store.representation_add (transaction, representative, balance);
-		}
-
-		cga::account_info info;
-		auto error (ledger.store.account_get (transaction, block_a.hashables.account, info));
-
 		if (is_send)
 		{
+			// The receiving chain has to go first, nothing of this block is touched if that fails
 			cga::pending_key key (block_a.hashables.link, hash);
-			while (!ledger.store.pending_exists (transaction, key))
+			while (!error && !ledger.store.pending_exists (transaction, key))
 			{
-				ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.link), list);
+				error = ledger.rollback (transaction, ledger.latest (transaction, block_a.hashables.link), list);
 			}
-			ledger.store.pending_del (transaction, key);
-			ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::send);
 		}
-		else if (!block_a.hashables.link.is_zero () && !ledger.is_epoch_link (block_a.hashables.link))
+		if (!error)
 		{
-			auto source_version (ledger.store.block_version (transaction, block_a.hashables.link));
-			cga::pending_info pending_info (ledger.account (transaction, block_a.hashables.link), block_a.hashables.balance.number () - balance, source_version);
-			ledger.store.pending_put (transaction, cga::pending_key (block_a.hashables.account, block_a.hashables.link), pending_info);
-			ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::receive);
-		}
+			cga::block_hash representative (0);
+			if (!block_a.hashables.previous.is_zero ())
+			{
+				representative = ledger.representative (transaction, block_a.hashables.previous);
+			}
+			// Add in amount delta
+			ledger.representation_add (transaction, hash, 0 - block_a.hashables.balance.number ());
+			if (!representative.is_zero ())
+			{
+				// Move existing representation
+				ledger.representation_add (transaction, representative, balance);
+			}
 
-		assert (!error);
-		auto previous_version (ledger.store.block_version (transaction, block_a.hashables.previous));
-		ledger.change_latest (transaction, block_a.hashables.account, block_a.hashables.previous, representative, balance, info.block_count - 1, false, previous_version);
+			cga::account_info info;
+			auto latest_error (ledger.store.account_get (transaction, block_a.hashables.account, info));
 
-		auto previous (ledger.store.block_get (transaction, block_a.hashables.previous));
-		if (previous != nullptr)
-		{
-			ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
-			if (previous->type () < cga::block_type::state)
+			if (is_send)
 			{
-				ledger.store.frontier_put (transaction, block_a.hashables.previous, block_a.hashables.account);
+				cga::pending_key key (block_a.hashables.link, hash);
+				ledger.store.pending_del (transaction, key);
+				ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::send);
 			}
+			else if (!block_a.hashables.link.is_zero () && !ledger.is_epoch_link (block_a.hashables.link))
+			{
+				auto source_version (ledger.store.block_version (transaction, block_a.hashables.link));
+				cga::pending_info pending_info (ledger.account (transaction, block_a.hashables.link), block_a.hashables.balance.number () - balance, source_version);
+				ledger.store.pending_put (transaction, cga::pending_key (block_a.hashables.account, block_a.hashables.link), pending_info);
+				ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::receive);
+			}
+
+			assert (!latest_error);
+			auto previous_version (ledger.store.block_version (transaction, block_a.hashables.previous));
+			ledger.change_latest (transaction, block_a.hashables.account, block_a.hashables.previous, representative, balance, info.block_count - 1, false, previous_version);
+
+			auto previous (ledger.store.block_get (transaction, block_a.hashables.previous));
+			if (previous != nullptr)
+			{
+				ledger.store.block_successor_clear (transaction, block_a.hashables.previous);
+				if (previous->type () < cga::block_type::state)
+				{
+					ledger.store.frontier_put (transaction, block_a.hashables.previous, block_a.hashables.account);
+				}
+			}
+			else
+			{
+				ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::open);
+			}
+			ledger.store.block_del (transaction, hash);
 		}
-		else
-		{
-			ledger.stats.inc (cga::stat::type::rollback, cga::stat::detail::open);
-		}
-		ledger.store.block_del (transaction, hash);
 	}
 	cga::transaction const & transaction;
 	cga::ledger & ledger;
 	std::vector<cga::block_hash> & list;
+	// Set when a dependent chain couldn't be rolled back because it's cemented
+	bool error;
 };
 
 class ledger_processor : public cga::block_visitor
@@ -228,7 +243,7 @@ void ledger_processor::state_block (cga::state_block const & block_a)
 void ledger_processor::state_block_impl (cga::state_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash));
+	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash) || ledger.store.pruned_exists (transaction, hash));
 	result.code = existing ? cga::process_result::old : cga::process_result::progress; // Have we seen this block before? (Unambiguous)
 	if (result.code == cga::process_result::progress)
 	{
@@ -310,10 +325,10 @@ void ledger_processor::state_block_impl (cga::state_block const & block_a)
 					if (!info.rep_block.is_zero ())
 					{
 						// Move existing representation
-						ledger.store.representation_add (transaction, info.rep_block, 0 - info.balance.number ());
+						ledger.representation_add (transaction, info.rep_block, 0 - info.balance.number ());
 					}
 					// Add in amount delta
-					ledger.store.representation_add (transaction, hash, block_a.hashables.balance.number ());
+					ledger.representation_add (transaction, hash, block_a.hashables.balance.number ());
 
 					if (is_send)
 					{
@@ -342,7 +357,7 @@ void ledger_processor::state_block_impl (cga::state_block const & block_a)
 void ledger_processor::epoch_block_impl (cga::state_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash));
+	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash) || ledger.store.pruned_exists (transaction, hash));
 	result.code = existing ? cga::process_result::old : cga::process_result::progress; // Have we seen this block before? (Unambiguous)
 	if (result.code == cga::process_result::progress)
 	{
@@ -408,7 +423,7 @@ void ledger_processor::epoch_block_impl (cga::state_block const & block_a)
 void ledger_processor::change_block (cga::change_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash));
+	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash) || ledger.store.pruned_exists (transaction, hash));
 	result.code = existing ? cga::process_result::old : cga::process_result::progress; // Have we seen this block before? (Harmless)
 	if (result.code == cga::process_result::progress)
 	{
@@ -439,8 +454,8 @@ void ledger_processor::change_block (cga::change_block const & block_a)
 						cga::block_sideband sideband (cga::block_type::change, account, 0, info.balance, info.block_count + 1, cga::seconds_since_epoch ());
 						ledger.store.block_put (transaction, hash, block_a, sideband);
 						auto balance (ledger.balance (transaction, block_a.hashables.previous));
-						ledger.store.representation_add (transaction, hash, balance);
-						ledger.store.representation_add (transaction, info.rep_block, 0 - balance);
+						ledger.representation_add (transaction, hash, balance);
+						ledger.representation_add (transaction, info.rep_block, 0 - balance);
 						ledger.change_latest (transaction, account, hash, hash, info.balance, info.block_count + 1);
 						ledger.store.frontier_del (transaction, block_a.hashables.previous);
 						ledger.store.frontier_put (transaction, hash, account);
@@ -457,7 +472,7 @@ void ledger_processor::change_block (cga::change_block const & block_a)
 void ledger_processor::send_block (cga::send_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash));
+	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash) || ledger.store.pruned_exists (transaction, hash));
 	result.code = existing ? cga::process_result::old : cga::process_result::progress; // Have we seen this block before? (Harmless)
 	if (result.code == cga::process_result::progress)
 	{
@@ -489,7 +504,7 @@ void ledger_processor::send_block (cga::send_block const & block_a)
 						if (result.code == cga::process_result::progress)
 						{
 							auto amount (info.balance.number () - block_a.hashables.balance.number ());
-							ledger.store.representation_add (transaction, info.rep_block, 0 - amount);
+							ledger.representation_add (transaction, info.rep_block, 0 - amount);
 							cga::block_sideband sideband (cga::block_type::send, account, 0, block_a.hashables.balance /* unused */, info.block_count + 1, cga::seconds_since_epoch ());
 							ledger.store.block_put (transaction, hash, block_a, sideband);
 							ledger.change_latest (transaction, account, hash, info.rep_block, block_a.hashables.balance, info.block_count + 1);
@@ -511,7 +526,7 @@ void ledger_processor::send_block (cga::send_block const & block_a)
 void ledger_processor::receive_block (cga::receive_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash));
+	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash) || ledger.store.pruned_exists (transaction, hash));
 	result.code = existing ? cga::process_result::old : cga::process_result::progress; // Have we seen this block already?  (Harmless)
 	if (result.code == cga::process_result::progress)
 	{
@@ -559,7 +574,7 @@ void ledger_processor::receive_block (cga::receive_block const & block_a)
 										cga::block_sideband sideband (cga::block_type::receive, account, 0, new_balance, info.block_count + 1, cga::seconds_since_epoch ());
 										ledger.store.block_put (transaction, hash, block_a, sideband);
 										ledger.change_latest (transaction, account, hash, info.rep_block, new_balance, info.block_count + 1);
-										ledger.store.representation_add (transaction, info.rep_block, pending.amount.number ());
+										ledger.representation_add (transaction, info.rep_block, pending.amount.number ());
 										ledger.store.frontier_del (transaction, block_a.hashables.previous);
 										ledger.store.frontier_put (transaction, hash, account);
 										result.account = account;
@@ -583,7 +598,7 @@ void ledger_processor::receive_block (cga::receive_block const & block_a)
 void ledger_processor::open_block (cga::open_block const & block_a)
 {
 	auto hash (block_a.hash ());
-	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash));
+	auto existing (ledger.store.block_exists (transaction, block_a.type (), hash) || ledger.store.pruned_exists (transaction, hash));
 	result.code = existing ? cga::process_result::old : cga::process_result::progress; // Have we seen this block already? (Harmless)
 	if (result.code == cga::process_result::progress)
 	{
@@ -621,7 +636,7 @@ void ledger_processor::open_block (cga::open_block const & block_a)
 								cga::block_sideband sideband (cga::block_type::open, block_a.hashables.account, 0, pending.amount, 1, cga::seconds_since_epoch ());
 								ledger.store.block_put (transaction, hash, block_a, sideband);
 								ledger.change_latest (transaction, block_a.hashables.account, hash, hash, pending.amount.number (), 1);
-								ledger.store.representation_add (transaction, hash, pending.amount.number ());
+								ledger.representation_add (transaction, hash, pending.amount.number ());
 								ledger.store.frontier_put (transaction, hash, block_a.hashables.account);
 								result.account = block_a.hashables.account;
 								result.amount = pending.amount;
@@ -659,7 +674,9 @@ bool cga::shared_ptr_block_hash::operator() (std::shared_ptr<cga::block> const &
 cga::ledger::ledger (cga::block_store & store_a, cga::stat & stat_a, cga::uint256_union const & epoch_link_a, cga::account const & epoch_signer_a) :
 store (store_a),
 stats (stat_a),
+block_count_cache (0),
 check_bootstrap_weights (true),
+weights_epoch (0),
 epoch_link (epoch_link_a),
 epoch_signer (epoch_signer_a)
 {
@@ -688,12 +705,7 @@ cga::uint128_t cga::ledger::account_pending (cga::transaction const & transactio
 {
 	cga::uint128_t result (0);
 	cga::account end (account_a.number () + 1);
-	for (auto i (store.pending_v0_begin (transaction_a, cga::pending_key (account_a, 0))), n (store.pending_v0_begin (transaction_a, cga::pending_key (end, 0))); i != n; ++i)
-	{
-		cga::pending_info info (i->second);
-		result += info.amount.number ();
-	}
-	for (auto i (store.pending_v1_begin (transaction_a, cga::pending_key (account_a, 0))), n (store.pending_v1_begin (transaction_a, cga::pending_key (end, 0))); i != n; ++i)
+	for (auto i (store.pending_begin (transaction_a, cga::pending_key (account_a, 0))), n (store.pending_begin (transaction_a, cga::pending_key (end, 0))); i != n; ++i)
 	{
 		cga::pending_info info (i->second);
 		result += info.amount.number ();
@@ -703,8 +715,14 @@ cga::uint128_t cga::ledger::account_pending (cga::transaction const & transactio
 
 cga::process_return cga::ledger::process (cga::transaction const & transaction_a, cga::block const & block_a, cga::signature_verification verification)
 {
+	auto start (std::chrono::steady_clock::now ());
 	ledger_processor processor (*this, transaction_a, verification);
 	block_a.visit (processor);
+	if (processor.result.code == cga::process_result::progress)
+	{
+		++block_count_cache;
+	}
+	stats.record (cga::stat::histogram::ledger_process, std::chrono::steady_clock::now () - start);
 	return processor.result;
 }
 
@@ -803,49 +821,125 @@ cga::block_hash cga::ledger::block_source (cga::transaction const & transaction_
 	return result;
 }
 
-// Vote weight of an account
-cga::uint128_t cga::ledger::weight (cga::transaction const & transaction_a, cga::account const & account_a)
+namespace
+{
+// Returns true if the account's weight comes from the bootstrap weights
+bool bootstrap_weight (cga::ledger & ledger_a, cga::account const & account_a, cga::uint128_t & weight_a)
 {
-	if (check_bootstrap_weights.load ())
+	auto result (false);
+	if (ledger_a.check_bootstrap_weights.load ())
 	{
-		auto blocks = store.block_count (transaction_a);
-		if (blocks.sum () < bootstrap_weight_max_blocks)
+		if (ledger_a.block_count_cache.load () < ledger_a.bootstrap_weight_max_blocks)
 		{
-			auto weight = bootstrap_weights.find (account_a);
-			if (weight != bootstrap_weights.end ())
+			auto weight (ledger_a.bootstrap_weights.find (account_a));
+			if (weight != ledger_a.bootstrap_weights.end ())
 			{
-				return weight->second;
+				weight_a = weight->second;
+				result = true;
 			}
 		}
-		else
+		else if (ledger_a.check_bootstrap_weights.exchange (false))
 		{
-			check_bootstrap_weights = false;
+			++ledger_a.weights_epoch;
 		}
 	}
-	return store.representation_get (transaction_a, account_a);
+	return result;
+}
+}
+
+// Vote weight of an account, including changes the transaction hasn't committed yet
+cga::uint128_t cga::ledger::weight (cga::transaction const & transaction_a, cga::account const & account_a)
+{
+	cga::uint128_t result;
+	if (!bootstrap_weight (*this, account_a, result))
+	{
+		result = rep_weights.representation_get (transaction_a, account_a);
+	}
+	return result;
+}
+
+// Vote weight of an account, read from the in-memory weight table without a store transaction
+cga::uint128_t cga::ledger::weight (cga::account const & account_a)
+{
+	cga::uint128_t result;
+	if (!bootstrap_weight (*this, account_a, result))
+	{
+		result = rep_weights.representation_get (account_a);
+	}
+	return result;
+}
+
+// Add amount_a to the representative of block source_a, in both the store and the in-memory weight table
+void cga::ledger::representation_add (cga::transaction const & transaction_a, cga::block_hash const & source_a, cga::uint128_t const & amount_a)
+{
+	auto source_block (store.block_get (transaction_a, source_a));
+	assert (source_block != nullptr);
+	auto source_rep (source_block->representative ());
+	auto weight (store.representation_get (transaction_a, source_rep) + amount_a);
+	store.representation_put (transaction_a, source_rep, weight);
+	rep_weights.representation_put (transaction_a, source_rep, weight);
+}
+
+void cga::ledger::load_cache (cga::transaction const & transaction_a)
+{
+	cga::rep_weights::weights_t weights;
+	for (auto i (store.representation_begin (transaction_a)), n (store.representation_end ()); i != n; ++i)
+	{
+		weights[i->first] = i->second.number ();
+	}
+	rep_weights.publish (weights);
+	block_count_cache = store.block_count (transaction_a).sum () + store.pruned_count (transaction_a);
 }
 
-// Rollback blocks until `block_a' doesn't exist
-void cga::ledger::rollback (cga::transaction const & transaction_a, cga::block_hash const & block_a, std::vector<cga::block_hash> & list_a)
+// Rollback blocks until `block_a' doesn't exist, returns true if that would mean rolling back a cemented block
+bool cga::ledger::rollback (cga::transaction const & transaction_a, cga::block_hash const & block_a, std::vector<cga::block_hash> & list_a)
 {
 	assert (store.block_exists (transaction_a, block_a));
 	auto account_l (account (transaction_a, block_a));
 	rollback_visitor rollback (transaction_a, *this, list_a);
 	cga::account_info info;
-	while (store.block_exists (transaction_a, block_a))
+	auto error (block_confirmed (transaction_a, block_a));
+	while (!error && store.block_exists (transaction_a, block_a))
 	{
 		auto latest_error (store.account_get (transaction_a, account_l, info));
 		assert (!latest_error);
 		auto block (store.block_get (transaction_a, info.head));
-		list_a.push_back (info.head);
 		block->visit (rollback);
+		error = rollback.error;
+		if (!error)
+		{
+			list_a.push_back (info.head);
+			--block_count_cache;
+		}
+	}
+	if (error)
+	{
+		stats.inc (cga::stat::type::rollback, cga::stat::detail::cemented);
 	}
+	return error;
 }
 
-void cga::ledger::rollback (cga::transaction const & transaction_a, cga::block_hash const & block_a)
+bool cga::ledger::rollback (cga::transaction const & transaction_a, cga::block_hash const & block_a)
 {
 	std::vector<cga::block_hash> rollback_list;
-	rollback (transaction_a, block_a, rollback_list);
+	return rollback (transaction_a, block_a, rollback_list);
+}
+
+bool cga::ledger::block_confirmed (cga::transaction const & transaction_a, cga::block_hash const & hash_a)
+{
+	auto result (false);
+	cga::block_sideband sideband;
+	auto block (store.block_get (transaction_a, hash_a, &sideband));
+	// Heights are only known once the sideband upgrade has finished
+	if (block != nullptr && sideband.height != 0)
+	{
+		cga::account_info info;
+		if (!store.account_get (transaction_a, sideband.account, info))
+		{
+			result = sideband.height <= info.confirmation_height;
+		}
+	}
+	return result;
 }
 
 // Return account containing hash
@@ -926,11 +1020,11 @@ public:
 	void receive_block (cga::receive_block const & block_a) override
 	{
 		result = ledger.store.block_exists (transaction, block_a.previous ());
-		result &= ledger.store.block_exists (transaction, block_a.source ());
+		result &= ledger.store.source_exists (transaction, block_a.source ());
 	}
 	void open_block (cga::open_block const & block_a) override
 	{
-		result = ledger.store.block_exists (transaction, block_a.source ());
+		result = ledger.store.source_exists (transaction, block_a.source ());
 	}
 	void change_block (cga::change_block const & block_a) override
 	{
@@ -941,7 +1035,7 @@ public:
 		result = block_a.previous ().is_zero () || ledger.store.block_exists (transaction, block_a.previous ());
 		if (result && !ledger.is_send (transaction, block_a))
 		{
-			result &= ledger.store.block_exists (transaction, block_a.hashables.link) || block_a.hashables.link.is_zero () || ledger.is_epoch_link (block_a.hashables.link);
+			result &= ledger.store.source_exists (transaction, block_a.hashables.link) || block_a.hashables.link.is_zero () || ledger.is_epoch_link (block_a.hashables.link);
 		}
 	}
 	cga::ledger & ledger;
@@ -970,6 +1064,33 @@ void cga::ledger::change_latest (cga::transaction const & transaction_a, cga::ac
 		assert (store.block_get (transaction_a, hash_a)->previous ().is_zero ());
 		info.open_block = hash_a;
 	}
+	// Delegation can only change along with the rep block, which most blocks keep
+	if (!exists || hash_a.is_zero () || info.rep_block != rep_block_a)
+	{
+		// Both rep blocks are still stored, rollbacks delete their block after calling this
+		cga::account representative_old (0);
+		cga::account representative_new (0);
+		cga::block_view rep_block;
+		if (exists && !store.block_view_get (transaction_a, info.rep_block, rep_block))
+		{
+			representative_old = rep_block.representative ();
+		}
+		if (!hash_a.is_zero () && !store.block_view_get (transaction_a, rep_block_a, rep_block))
+		{
+			representative_new = rep_block.representative ();
+		}
+		if (exists == hash_a.is_zero () || representative_old != representative_new)
+		{
+			if (exists)
+			{
+				store.delegator_del (transaction_a, cga::delegator_key (representative_old, account_a));
+			}
+			if (!hash_a.is_zero ())
+			{
+				store.delegator_put (transaction_a, cga::delegator_key (representative_new, account_a));
+			}
+		}
+	}
 	if (!hash_a.is_zero ())
 	{
 		info.head = hash_a;
@@ -1031,14 +1152,174 @@ std::shared_ptr<cga::block> cga::ledger::forked_block (cga::transaction const &
 	return result;
 }
 
+size_t constexpr cga::rep_weights::shard_count;
+
+cga::rep_weights::rep_weights ()
+{
+	auto empty (std::make_shared<weights_t const> ());
+	auto snapshot_l (std::make_shared<snapshot_t> ());
+	snapshot_l->fill (empty);
+	current = snapshot_l;
+}
+
+void cga::rep_weights::representation_put (cga::transaction const & transaction_a, cga::account const & account_a, cga::uint128_t const & representation_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	(*staged_get (*transaction_a.impl))[account_a] = representation_a;
+}
+
+cga::uint128_t cga::rep_weights::representation_get (cga::transaction const & transaction_a, cga::account const & account_a)
+{
+	boost::optional<cga::uint128_t> result;
+	for (auto impl (transaction_a.impl.get ()); impl != nullptr && !result.is_initialized (); impl = impl->parent)
+	{
+		// Only write transactions have commit hooks, reads don't need the lock
+		if (!impl->committed.empty ())
+		{
+			std::lock_guard<std::mutex> lock (mutex);
+			auto existing (staged.find (impl));
+			if (existing != staged.end ())
+			{
+				auto weight (existing->second->find (account_a));
+				if (weight != existing->second->end ())
+				{
+					result = weight->second;
+				}
+			}
+		}
+	}
+	return result.is_initialized () ? result.get () : representation_get (account_a);
+}
+
+cga::uint128_t cga::rep_weights::representation_get (cga::account const & account_a)
+{
+	cga::uint128_t result (0);
+	auto snapshot_l (std::atomic_load (&current));
+	auto & shard_l (*(*snapshot_l)[shard (account_a)]);
+	auto existing (shard_l.find (account_a));
+	if (existing != shard_l.end ())
+	{
+		result = existing->second;
+	}
+	return result;
+}
+
+std::shared_ptr<cga::rep_weights::weights_t> cga::rep_weights::staged_get (cga::transaction_impl & impl_a)
+{
+	assert (!mutex.try_lock ());
+	auto & result (staged[&impl_a]);
+	if (result == nullptr)
+	{
+		result = std::make_shared<weights_t> ();
+		auto impl_l (&impl_a);
+		impl_a.committed.push_back ([this, impl_l](cga::transaction_impl * parent_a) {
+			std::lock_guard<std::mutex> lock (mutex);
+			auto existing (staged.find (impl_l));
+			assert (existing != staged.end ());
+			auto changes (std::move (existing->second));
+			staged.erase (existing);
+			if (parent_a != nullptr)
+			{
+				// Committed into the parent, its changes now belong to the parent's transaction
+				auto target (staged_get (*parent_a));
+				for (auto & i : *changes)
+				{
+					(*target)[i.first] = i.second;
+				}
+			}
+			else
+			{
+				publish_locked (*changes);
+			}
+		});
+		std::weak_ptr<weights_t> changes_w (result);
+		impl_a.aborted.push_back ([this, impl_l, changes_w]() {
+			std::lock_guard<std::mutex> lock (mutex);
+			// Compared so a later transaction reusing the address keeps its own changes
+			auto existing (staged.find (impl_l));
+			if (existing != staged.end () && existing->second == changes_w.lock ())
+			{
+				staged.erase (existing);
+			}
+		});
+	}
+	return result;
+}
+
+void cga::rep_weights::publish (weights_t const & weights_a)
+{
+	std::lock_guard<std::mutex> lock (mutex);
+	publish_locked (weights_a);
+}
+
+void cga::rep_weights::publish_locked (weights_t const & weights_a)
+{
+	assert (!mutex.try_lock ());
+	if (!weights_a.empty ())
+	{
+		// Only shards with changed weights are copied, the rest are shared with the previous snapshot
+		std::array<std::shared_ptr<weights_t>, shard_count> copies;
+		for (auto & i : weights_a)
+		{
+			auto index (shard (i.first));
+			if (copies[index] == nullptr)
+			{
+				copies[index] = std::make_shared<weights_t> (*(*current)[index]);
+			}
+			(*copies[index])[i.first] = i.second;
+		}
+		auto snapshot_l (std::make_shared<snapshot_t> (*current));
+		for (size_t i (0); i < shard_count; ++i)
+		{
+			if (copies[i] != nullptr)
+			{
+				(*snapshot_l)[i] = std::move (copies[i]);
+			}
+		}
+		std::atomic_store (&current, std::shared_ptr<snapshot_t const> (std::move (snapshot_l)));
+	}
+}
+
+std::shared_ptr<cga::rep_weights::snapshot_t const> cga::rep_weights::snapshot ()
+{
+	return std::atomic_load (&current);
+}
+
+size_t cga::rep_weights::size ()
+{
+	size_t result (0);
+	auto snapshot_l (std::atomic_load (&current));
+	for (auto & shard_l : *snapshot_l)
+	{
+		result += shard_l->size ();
+	}
+	return result;
+}
+
+size_t cga::rep_weights::shard (cga::account const & account_a)
+{
+	// Accounts are public keys, so their first byte is evenly spread
+	return account_a.bytes[0];
+}
+
 namespace cga
 {
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (rep_weights & rep_weights, const std::string & name)
+{
+	auto count = rep_weights.size ();
+	auto sizeof_element = sizeof (cga::rep_weights::weights_t::value_type);
+	auto composite = std::make_unique<seq_con_info_composite> (name);
+	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "rep_amounts", count, sizeof_element }));
+	return composite;
+}
+
 std::unique_ptr<seq_con_info_component> collect_seq_con_info (ledger & ledger, const std::string & name)
 {
 	auto composite = std::make_unique<seq_con_info_composite> (name);
 	auto count = ledger.bootstrap_weights.size ();
 	auto sizeof_element = sizeof (decltype (ledger.bootstrap_weights)::value_type);
 	composite->add_component (std::make_unique<seq_con_info_leaf> (seq_con_info{ "bootstrap_weights", count, sizeof_element }));
+	composite->add_component (collect_seq_con_info (ledger.rep_weights, "rep_weights"));
 	return composite;
 }
 }
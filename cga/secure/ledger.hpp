@@ -2,10 +2,14 @@
 
 #include <cga/secure/common.hpp>
 
+#include <array>
+#include <mutex>
+
 namespace cga
 {
 class block_store;
 class stat;
+class transaction_impl;
 
 class shared_ptr_block_hash
 {
@@ -14,6 +18,40 @@ public:
 	bool operator() (std::shared_ptr<cga::block> const &, std::shared_ptr<cga::block> const &) const;
 };
 using tally_t = std::map<cga::uint128_t, std::shared_ptr<cga::block>, std::greater<cga::uint128_t>>;
+/**
+ * In-memory mirror of the representation table, kept in sync by the ledger.
+ * Writes are staged per transaction, visible to that transaction and published to other readers once it commits.
+ * Weights are split into shards by account and publishing copies only the shards which were written,
+ * so readers work from an immutable snapshot without taking a lock.
+ */
+class rep_weights
+{
+public:
+	using weights_t = std::unordered_map<cga::account, cga::uint128_t>;
+	static size_t constexpr shard_count = 256;
+	using snapshot_t = std::array<std::shared_ptr<weights_t const>, shard_count>;
+	rep_weights ();
+	void representation_put (cga::transaction const &, cga::account const &, cga::uint128_t const &);
+	// Includes writes the transaction, or a parent it is nested in, hasn't committed yet
+	cga::uint128_t representation_get (cga::transaction const &, cga::account const &);
+	cga::uint128_t representation_get (cga::account const &);
+	// Makes weights visible to readers, for loading from the store
+	void publish (weights_t const &);
+	std::shared_ptr<snapshot_t const> snapshot ();
+	size_t size ();
+
+private:
+	static size_t shard (cga::account const &);
+	std::shared_ptr<weights_t> staged_get (cga::transaction_impl &);
+	void publish_locked (weights_t const &);
+	std::mutex mutex;
+	// Written by transactions which haven't committed yet
+	std::unordered_map<cga::transaction_impl const *, std::shared_ptr<weights_t>> staged;
+	std::shared_ptr<snapshot_t const> current;
+};
+
+std::unique_ptr<seq_con_info_component> collect_seq_con_info (rep_weights & rep_weights, const std::string & name);
+
 class ledger
 {
 public:
@@ -24,6 +62,7 @@ public:
 	cga::uint128_t account_balance (cga::transaction const &, cga::account const &);
 	cga::uint128_t account_pending (cga::transaction const &, cga::account const &);
 	cga::uint128_t weight (cga::transaction const &, cga::account const &);
+	cga::uint128_t weight (cga::account const &);
 	std::shared_ptr<cga::block> successor (cga::transaction const &, cga::uint512_union const &);
 	std::shared_ptr<cga::block> forked_block (cga::transaction const &, cga::block const &);
 	cga::block_hash latest (cga::transaction const &, cga::account const &);
@@ -38,18 +77,27 @@ public:
 	cga::block_hash block_destination (cga::transaction const &, cga::block const &);
 	cga::block_hash block_source (cga::transaction const &, cga::block const &);
 	cga::process_return process (cga::transaction const &, cga::block const &, cga::signature_verification = cga::signature_verification::unknown);
-	void rollback (cga::transaction const &, cga::block_hash const &, std::vector<cga::block_hash> &);
-	void rollback (cga::transaction const &, cga::block_hash const &);
+	bool rollback (cga::transaction const &, cga::block_hash const &, std::vector<cga::block_hash> &);
+	bool rollback (cga::transaction const &, cga::block_hash const &);
+	bool block_confirmed (cga::transaction const &, cga::block_hash const &);
+	void representation_add (cga::transaction const &, cga::block_hash const &, cga::uint128_t const &);
 	void change_latest (cga::transaction const &, cga::account const &, cga::block_hash const &, cga::account const &, cga::uint128_union const &, uint64_t, bool = false, cga::epoch = cga::epoch::epoch_0);
 	void dump_account_chain (cga::account const &);
 	bool could_fit (cga::transaction const &, cga::block const &);
 	bool is_epoch_link (cga::uint256_union const &);
+	// Fills rep_weights and block_count_cache from the store
+	void load_cache (cga::transaction const &);
 	static cga::uint128_t const unit;
 	cga::block_store & store;
 	cga::stat & stats;
+	cga::rep_weights rep_weights;
+	// Number of blocks in the ledger, maintained by process and rollback
+	std::atomic<uint64_t> block_count_cache;
 	std::unordered_map<cga::account, cga::uint128_t> bootstrap_weights;
 	uint64_t bootstrap_weight_max_blocks;
 	std::atomic<bool> check_bootstrap_weights;
+	// Incremented when vote weights cached outside the ledger should be refreshed
+	std::atomic<uint64_t> weights_epoch;
 	cga::uint256_union epoch_link;
 	cga::account epoch_signer;
 };